@@ -0,0 +1,36 @@
+// 基准语料：函数密集型翻译单元
+// 宏生成的大量中等大小函数，主要测量优化pass追踪（cb_pass_execution）的开销
+
+#define GPERF_BENCH_FUNCTION(N)                      \
+    int function_##N(int x, int y)                   \
+    {                                                \
+        int result = 0;                              \
+        for (int i = 0; i < x; i++)                  \
+        {                                            \
+            result += (i * N + y) % (N + 7);         \
+            if (result > 1000 * N)                   \
+            {                                        \
+                result -= y;                         \
+            }                                        \
+        }                                            \
+        return result;                               \
+    }
+
+#define GPERF_BENCH_FUNCTIONS_10(N)                                   \
+    GPERF_BENCH_FUNCTION(N##0) GPERF_BENCH_FUNCTION(N##1)             \
+    GPERF_BENCH_FUNCTION(N##2) GPERF_BENCH_FUNCTION(N##3)             \
+    GPERF_BENCH_FUNCTION(N##4) GPERF_BENCH_FUNCTION(N##5)             \
+    GPERF_BENCH_FUNCTION(N##6) GPERF_BENCH_FUNCTION(N##7)             \
+    GPERF_BENCH_FUNCTION(N##8) GPERF_BENCH_FUNCTION(N##9)
+
+#define GPERF_BENCH_FUNCTIONS_100(N)                                  \
+    GPERF_BENCH_FUNCTIONS_10(N##0) GPERF_BENCH_FUNCTIONS_10(N##1)     \
+    GPERF_BENCH_FUNCTIONS_10(N##2) GPERF_BENCH_FUNCTIONS_10(N##3)     \
+    GPERF_BENCH_FUNCTIONS_10(N##4) GPERF_BENCH_FUNCTIONS_10(N##5)     \
+    GPERF_BENCH_FUNCTIONS_10(N##6) GPERF_BENCH_FUNCTIONS_10(N##7)     \
+    GPERF_BENCH_FUNCTIONS_10(N##8) GPERF_BENCH_FUNCTIONS_10(N##9)
+
+GPERF_BENCH_FUNCTIONS_100(1)
+GPERF_BENCH_FUNCTIONS_100(2)
+GPERF_BENCH_FUNCTIONS_100(3)
+GPERF_BENCH_FUNCTIONS_100(4)
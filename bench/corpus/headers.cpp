@@ -0,0 +1,38 @@
+// 基准语料：头文件密集型翻译单元
+// 大量标准库头文件，少量函数，主要测量预处理追踪（cb_file_change）的开销
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+int count_words(const std::string& text)
+{
+    std::istringstream stream(text);
+    std::map<std::string, int> counts;
+    for (std::string word; stream >> word;)
+    {
+        counts[word]++;
+    }
+    return static_cast<int>(counts.size());
+}
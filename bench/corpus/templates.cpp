@@ -0,0 +1,64 @@
+// 基准语料：模板密集型翻译单元
+// 递归模板实例化和大量类定义，主要测量函数/类追踪（cb_finish_parse_function、cb_finish_type）的开销
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+template <std::size_t N>
+struct Fibonacci
+{
+    static constexpr std::size_t value = Fibonacci<N - 1>::value + Fibonacci<N - 2>::value;
+};
+
+template <>
+struct Fibonacci<0>
+{
+    static constexpr std::size_t value = 0;
+};
+
+template <>
+struct Fibonacci<1>
+{
+    static constexpr std::size_t value = 1;
+};
+
+template <std::size_t Depth>
+struct Node
+{
+    Node<Depth - 1> child;
+    int value = static_cast<int>(Depth);
+
+    int sum() const
+    {
+        return value + child.sum();
+    }
+};
+
+template <>
+struct Node<0>
+{
+    int sum() const
+    {
+        return 0;
+    }
+};
+
+template <class... Ts>
+auto make_sums(Ts... values)
+{
+    return std::make_tuple((values + 1)...);
+}
+
+template <std::size_t... Is>
+int sum_nodes(std::index_sequence<Is...>)
+{
+    return (Node<Is + 1>{}.sum() + ...);
+}
+
+int run()
+{
+    auto sums = make_sums(1, 2.0, 3u, 4l, 5.0f);
+    return static_cast<int>(std::get<0>(sums) + Fibonacci<80>::value % 1000) +
+        sum_nodes(std::make_index_sequence<64>{});
+}
@@ -0,0 +1,438 @@
+// GCC性能追踪插件的开销基准测试驱动
+// 用固定的翻译单元语料，在不加载插件和各种输出模式下分别编译多次，
+// 统计每个翻译单元的墙钟时间中位数、最大常驻内存中位数和trace大小，
+// 并输出相对于基线（第一个模式，通常不加载插件）的差值到JSON文件；
+// 规模用例（--scale）还检查同一维度内插件开销是否随规模线性增长
+
+#include <algorithm>     // 排序（计算中位数）
+#include <chrono>        // 墙钟计时
+#include <cstdio>        // 文件输出
+#include <cstdlib>       // strtol、exit
+#include <cstring>       // strcmp
+#include <filesystem>    // 临时目录和trace文件大小
+#include <map>           // 按维度分组的规模用例
+#include <string>        // 字符串
+#include <vector>        // 向量容器
+
+#include <sys/resource.h>  // rusage（子进程最大常驻内存）
+#include <sys/wait.h>      // wait4
+#include <unistd.h>        // fork、execvp
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // 输出模式：名称和附加的编译参数
+    // 参数中的{dir}替换为每次编译独立的输出目录，目录中所有文件的大小之和即trace大小
+    struct Mode
+    {
+        std::string name;                 // 模式名称（如none、trace、sample16）
+        std::vector<std::string> flags;   // 附加的编译参数
+    };
+
+    // 单次编译的测量结果
+    struct Sample
+    {
+        double wall_ms;        // 墙钟时间（毫秒）
+        long max_rss_kb;       // 最大常驻内存（KB）
+        uintmax_t trace_bytes; // 输出目录中的文件总大小（字节）
+    };
+
+    // 规模用例：所属维度（如functions）和规模（如函数数量）
+    struct ScaleCase
+    {
+        std::string dimension;  // 维度名称，同一维度的用例按规模比较
+        double units;           // 规模
+    };
+
+    // 基准测试配置
+    struct Options
+    {
+        std::string compiler = "g++";         // 编译器
+        std::vector<std::string> flags;       // 公共编译参数
+        std::vector<Mode> modes;              // 输出模式（第一个为基线）
+        std::vector<std::string> sources;     // 翻译单元语料
+        std::string output = "gperf_bench.json"; // 结果文件
+        int runs = 5;                         // 每个翻译单元、每个模式的编译次数
+        std::map<std::string, ScaleCase> scales; // 规模用例（按翻译单元）
+        double max_nonlinearity = 2.0;        // 允许的非线性比（开销增长倍数/规模增长倍数）
+        double noise_ms = 5.0;                // 开销的噪声下限（毫秒），低于它按下限计算
+    };
+
+    // 把逗号分隔的参数拆分为列表
+    std::vector<std::string> split_flags(const std::string& text)
+    {
+        std::vector<std::string> result;
+        size_t start = 0;
+        while (start <= text.size())
+        {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = text.size();
+            }
+            if (end > start)
+            {
+                result.push_back(text.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+
+    // 替换参数中的{dir}占位符
+    std::string expand(const std::string& flag, const std::string& dir)
+    {
+        std::string result = flag;
+        for (size_t pos = result.find("{dir}"); pos != std::string::npos; pos = result.find("{dir}", pos))
+        {
+            result.replace(pos, 5, dir);
+            pos += dir.size();
+        }
+        return result;
+    }
+
+    // 编译一次并测量墙钟时间、最大常驻内存和trace大小
+    bool compile_once(const Options& options, const Mode& mode, const std::string& source,
+        const fs::path& dir, Sample& sample)
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        std::vector<std::string> args{options.compiler};
+        args.insert(args.end(), options.flags.begin(), options.flags.end());
+        for (const auto& flag : mode.flags)
+        {
+            args.push_back(expand(flag, dir.string()));
+        }
+        args.insert(args.end(), {"-c", source, "-o", (dir / "bench.o").string()});
+
+        std::vector<char*> argv;
+        for (auto& arg : args)
+        {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            execvp(argv[0], argv.data());
+            perror("gperf-bench: execvp");
+            _exit(127);
+        }
+        if (pid < 0)
+        {
+            perror("gperf-bench: fork");
+            return false;
+        }
+
+        int status = 0;
+        rusage usage{};
+        if (wait4(pid, &status, 0, &usage) < 0)
+        {
+            perror("gperf-bench: wait4");
+            return false;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "gperf-bench: compiling %s in mode %s failed\n", source.data(), mode.name.data());
+            return false;
+        }
+
+        // trace大小：输出目录中除目标文件外的所有文件
+        sample.trace_bytes = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(dir))
+        {
+            if (entry.is_regular_file() && entry.path().filename() != "bench.o")
+            {
+                sample.trace_bytes += entry.file_size();
+            }
+        }
+        sample.wall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        // Linux下wait4返回的ru_maxrss包括子进程已回收的后代（cc1plus、as）中的最大值
+        sample.max_rss_kb = usage.ru_maxrss;
+        return true;
+    }
+
+    // 计算中位数
+    template <class T>
+    T median(std::vector<T> values)
+    {
+        std::sort(values.begin(), values.end());
+        size_t n = values.size();
+        return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    }
+
+    // 输出JSON字符串（转义引号、反斜杠和控制字符）
+    void write_string(FILE* file, const std::string& text)
+    {
+        fputc('"', file);
+        for (unsigned char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                fprintf(file, "\\%c", c);
+            }
+            else if (c < 0x20)
+            {
+                fprintf(file, "\\u%04x", c);
+            }
+            else
+            {
+                fputc(c, file);
+            }
+        }
+        fputc('"', file);
+    }
+
+    // 解析--scale SOURCE=DIMENSION:UNITS
+    bool parse_scale(const std::string& spec, Options& options)
+    {
+        size_t eq = spec.rfind('=');
+        size_t colon = spec.rfind(':');
+        if (eq == std::string::npos || colon == std::string::npos || colon < eq)
+        {
+            return false;
+        }
+        char* end = nullptr;
+        double units = strtod(spec.data() + colon + 1, &end);
+        if (*end || units <= 0)
+        {
+            return false;
+        }
+        options.scales[spec.substr(0, eq)] = ScaleCase{spec.substr(eq + 1, colon - eq - 1), units};
+        return true;
+    }
+
+    // 检查同一维度内相邻规模用例的插件开销增长是否线性
+    // 非线性比 = (大用例开销/小用例开销) / (大用例规模/小用例规模)，超过上限即失败；
+    // 开销（相对于基线的墙钟时间差）低于噪声下限时按下限计算，避免小用例的抖动被放大
+    bool check_linearity(FILE* file, const Options& options,
+        const std::map<std::pair<std::string, size_t>, double>& deltas)
+    {
+        std::map<std::string, std::vector<std::pair<double, std::string>>> dimensions;
+        for (const auto& [source, scale] : options.scales)
+        {
+            dimensions[scale.dimension].emplace_back(scale.units, source);
+        }
+
+        bool ok = true;
+        bool first = true;
+        fprintf(file, ", \"max_nonlinearity\": %.2f, \"linearity\": [", options.max_nonlinearity);
+        for (auto& [dimension, cases] : dimensions)
+        {
+            std::sort(cases.begin(), cases.end());
+            for (size_t m = 1; m < options.modes.size(); m++)
+            {
+                for (size_t i = 1; i < cases.size(); i++)
+                {
+                    auto small = deltas.find({cases[i - 1].second, m});
+                    auto large = deltas.find({cases[i].second, m});
+                    if (small == deltas.end() || large == deltas.end())
+                    {
+                        continue;
+                    }
+                    double small_ms = std::max(small->second, options.noise_ms);
+                    double large_ms = std::max(large->second, options.noise_ms);
+                    double ratio = (large_ms / small_ms) / (cases[i].first / cases[i - 1].first);
+                    bool pass = ratio <= options.max_nonlinearity;
+
+                    fprintf(file, "%s\n  {\"dimension\": ", first ? "" : ",");
+                    write_string(file, dimension);
+                    fprintf(file, ", \"mode\": ");
+                    write_string(file, options.modes[m].name);
+                    fprintf(file, ", \"from_units\": %.0f, \"to_units\": %.0f"
+                        ", \"from_delta_ms\": %.3f, \"to_delta_ms\": %.3f, \"nonlinearity\": %.2f}",
+                        cases[i - 1].first, cases[i].first, small->second, large->second, ratio);
+                    first = false;
+
+                    printf("%-12s %-12s %8.0f -> %-8.0f overhead %+9.1f -> %+9.1f ms  nonlinearity %5.2f%s\n",
+                        dimension.data(), options.modes[m].name.data(), cases[i - 1].first, cases[i].first,
+                        small->second, large->second, ratio, pass ? "" : "  FAILED");
+                    if (!pass)
+                    {
+                        fprintf(stderr, "gperf-bench: %s overhead in mode %s grows %.2fx faster than its size "
+                            "(%.0f -> %.0f), limit %.2f\n", dimension.data(), options.modes[m].name.data(),
+                            ratio, cases[i - 1].first, cases[i].first, options.max_nonlinearity);
+                        ok = false;
+                    }
+                }
+            }
+        }
+        fprintf(file, "\n]");
+        return ok;
+    }
+
+    void usage(const char* program)
+    {
+        fprintf(stderr,
+            "Usage: %s [--compiler CXX] [--flags F1,F2,...] [--runs N] [--output FILE]\n"
+            "          [--scale SOURCE=DIMENSION:UNITS ...] [--max-nonlinearity RATIO] [--noise-ms MS]\n"
+            "          --mode NAME[=FLAG1,FLAG2,...] [--mode ...] SOURCE...\n"
+            "The first mode is the baseline; {dir} in mode flags expands to a fresh output directory.\n"
+            "Scale cases of the same dimension fail when the overhead grows faster than RATIO times their size.\n",
+            program);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--compiler" && has_value)
+        {
+            options.compiler = argv[++i];
+        }
+        else if (arg == "--flags" && has_value)
+        {
+            options.flags = split_flags(argv[++i]);
+        }
+        else if (arg == "--runs" && has_value)
+        {
+            options.runs = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--output" && has_value)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--scale" && has_value)
+        {
+            if (!parse_scale(argv[++i], options))
+            {
+                fprintf(stderr, "gperf-bench: invalid scale case %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (arg == "--max-nonlinearity" && has_value)
+        {
+            options.max_nonlinearity = atof(argv[++i]);
+        }
+        else if (arg == "--noise-ms" && has_value)
+        {
+            options.noise_ms = atof(argv[++i]);
+        }
+        else if (arg == "--mode" && has_value)
+        {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            Mode mode{spec.substr(0, eq), {}};
+            if (eq != std::string::npos)
+            {
+                mode.flags = split_flags(spec.substr(eq + 1));
+            }
+            options.modes.push_back(std::move(mode));
+        }
+        else if (arg.starts_with("--"))
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+        {
+            options.sources.push_back(arg);
+        }
+    }
+
+    if (options.modes.empty() || options.sources.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    fs::path work_dir = fs::temp_directory_path() / ("gperf_bench_" + std::to_string(getpid()));
+
+    FILE* file = fopen(options.output.data(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "gperf-bench: couldn't open %s for writing\n", options.output.data());
+        return 1;
+    }
+
+    fprintf(file, "{\"compiler\": ");
+    write_string(file, options.compiler);
+    fprintf(file, ", \"runs\": %d, \"baseline\": ", options.runs);
+    write_string(file, options.modes.front().name);
+    fprintf(file, ", \"results\": [");
+
+    bool ok = true;
+    bool first_result = true;
+    std::map<std::pair<std::string, size_t>, double> deltas; // 每个翻译单元、每个模式相对基线的墙钟时间差
+    for (const auto& source : options.sources)
+    {
+        double baseline_wall_ms = 0;
+        long baseline_rss_kb = 0;
+        for (size_t m = 0; m < options.modes.size() && ok; m++)
+        {
+            const Mode& mode = options.modes[m];
+            std::vector<double> wall_ms;
+            std::vector<long> rss_kb;
+            std::vector<uintmax_t> trace_bytes;
+
+            // 热身：每个模式的第一次编译不计入结果（页缓存、动态链接）
+            for (int run = 0; run <= options.runs && ok; run++)
+            {
+                Sample sample;
+                ok = compile_once(options, mode, source, work_dir, sample);
+                if (ok && run > 0)
+                {
+                    wall_ms.push_back(sample.wall_ms);
+                    rss_kb.push_back(sample.max_rss_kb);
+                    trace_bytes.push_back(sample.trace_bytes);
+                }
+            }
+            if (!ok)
+            {
+                break;
+            }
+
+            double median_wall_ms = median(wall_ms);
+            long median_rss_kb = median(rss_kb);
+            if (m == 0)
+            {
+                baseline_wall_ms = median_wall_ms;
+                baseline_rss_kb = median_rss_kb;
+            }
+
+            fprintf(file, "%s\n  {\"tu\": ", first_result ? "" : ",");
+            write_string(file, source);
+            fprintf(file, ", \"mode\": ");
+            write_string(file, mode.name);
+            fprintf(file,
+                ", \"median_wall_ms\": %.3f, \"median_max_rss_kb\": %ld, \"trace_bytes\": %ju"
+                ", \"wall_delta_ms\": %.3f, \"wall_delta_pct\": %.2f, \"max_rss_delta_kb\": %ld}",
+                median_wall_ms, median_rss_kb, median(trace_bytes),
+                median_wall_ms - baseline_wall_ms,
+                baseline_wall_ms > 0 ? (median_wall_ms - baseline_wall_ms) * 100.0 / baseline_wall_ms : 0.0,
+                median_rss_kb - baseline_rss_kb);
+            first_result = false;
+            deltas[{source, m}] = median_wall_ms - baseline_wall_ms;
+
+            printf("%-40s %-12s wall %9.1f ms (%+7.1f ms)  rss %8ld KB (%+7ld KB)  trace %10ju B\n",
+                source.data(), mode.name.data(), median_wall_ms, median_wall_ms - baseline_wall_ms,
+                median_rss_kb, median_rss_kb - baseline_rss_kb, median(trace_bytes));
+        }
+    }
+
+    fprintf(file, "\n]");
+    bool linear = true;
+    if (ok && !options.scales.empty())
+    {
+        linear = check_linearity(file, options, deltas);
+    }
+    fprintf(file, "}\n");
+    fclose(file);
+    fs::remove_all(work_dir);
+
+    if (ok)
+    {
+        printf("Results written to %s\n", options.output.data());
+    }
+    return ok && linear ? 0 : 1;
+}
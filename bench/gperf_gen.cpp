@@ -0,0 +1,295 @@
+// 合成翻译单元生成器
+// 按参数生成规模可控的翻译单元，用于验证插件（tracking.cpp、perf_output.cpp）
+// 在极端规模下是否线性扩展：数十万函数、上万头文件、数千层模板递归、大量宏展开
+//
+// 生成的文件：
+//   OUT_DIR/NAME.cpp          主翻译单元
+//   OUT_DIR/NAME_include/*.h  头文件树（按包含深度和扇出生成，总数受--headers限制）
+
+#include <cstdio>        // 文件输出
+#include <cstdlib>       // atol
+#include <filesystem>    // 创建输出目录
+#include <string>        // 字符串
+#include <vector>        // 向量容器
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // 生成参数
+    struct Options
+    {
+        std::string out_dir = ".";     // 输出目录
+        std::string name = "synthetic";// 翻译单元名称
+        long include_depth = 0;        // 头文件包含深度（0表示不生成头文件）
+        long fan_out = 1;              // 每个头文件包含的子头文件数量
+        long headers = 0;              // 头文件总数上限（0表示只受深度和扇出限制）
+        long functions = 0;            // 主翻译单元中的函数数量
+        long body_size = 1;            // 每个函数体的语句数量
+        long template_depth = 0;       // 递归模板实例化深度
+        long macro_expansions = 0;     // 宏展开次数（每次展开为4层嵌套宏）
+        long functions_per_namespace = 100; // 每个命名空间中的函数数量
+    };
+
+    // 打开输出文件
+    FILE* open_output(const fs::path& path)
+    {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "gperf-gen: couldn't open %s for writing\n", path.c_str());
+            exit(1);
+        }
+        return file;
+    }
+
+    // 头文件名称
+    std::string header_name(long id)
+    {
+        return "header_" + std::to_string(id) + ".h";
+    }
+
+    // 按广度优先生成头文件树，返回主翻译单元直接包含的头文件
+    // 每个头文件包含一个结构体和一个内联函数，并包含fan_out个子头文件
+    std::vector<long> generate_headers(const Options& options, const fs::path& include_dir)
+    {
+        std::vector<long> roots;
+        if (options.include_depth <= 0)
+        {
+            return roots;
+        }
+
+        // 逐层分配头文件编号：每层节点数为上一层乘以扇出
+        std::vector<std::vector<long>> levels;
+        long next_id = 0;
+        long limit = options.headers > 0 ? options.headers : -1;
+        long width = options.fan_out;
+        for (long depth = 0; depth < options.include_depth && next_id != limit; depth++)
+        {
+            std::vector<long> level;
+            for (long i = 0; i < width && next_id != limit; i++)
+            {
+                level.push_back(next_id++);
+            }
+            levels.push_back(std::move(level));
+            width *= options.fan_out;
+        }
+        roots = levels.front();
+
+        for (size_t depth = 0; depth < levels.size(); depth++)
+        {
+            for (size_t i = 0; i < levels[depth].size(); i++)
+            {
+                long id = levels[depth][i];
+                FILE* file = open_output(include_dir / header_name(id));
+                fprintf(file, "#pragma once\n\n");
+
+                // 子头文件：下一层中第i个节点的fan_out个孩子
+                if (depth + 1 < levels.size())
+                {
+                    const auto& children = levels[depth + 1];
+                    for (long c = 0; c < options.fan_out; c++)
+                    {
+                        size_t child = i * options.fan_out + c;
+                        if (child < children.size())
+                        {
+                            fprintf(file, "#include \"%s\"\n", header_name(children[child]).data());
+                        }
+                    }
+                    fprintf(file, "\n");
+                }
+
+                fprintf(file,
+                    "struct Header%ld\n"
+                    "{\n"
+                    "    int value;\n"
+                    "    int twice() const { return value * 2; }\n"
+                    "};\n\n"
+                    "inline int header_function_%ld(int x)\n"
+                    "{\n"
+                    "    return x + %ld;\n"
+                    "}\n",
+                    id, id, id);
+                fclose(file);
+            }
+        }
+        return roots;
+    }
+
+    // 生成递归模板：Recursive<N>::value依赖Recursive<N - 1>::value
+    void generate_templates(FILE* file, const Options& options)
+    {
+        if (options.template_depth <= 0)
+        {
+            return;
+        }
+
+        fprintf(file,
+            "// 递归模板实例化：深度%ld（需要-ftemplate-depth=%ld以上）\n"
+            "template <long N>\n"
+            "struct Recursive\n"
+            "{\n"
+            "    static constexpr long value = Recursive<N - 1>::value + N %% 7;\n"
+            "    long get() const { return Recursive<N - 1>{}.get() + value; }\n"
+            "};\n\n"
+            "template <>\n"
+            "struct Recursive<0>\n"
+            "{\n"
+            "    static constexpr long value = 0;\n"
+            "    long get() const { return 0; }\n"
+            "};\n\n"
+            "long template_root()\n"
+            "{\n"
+            "    return Recursive<%ld>{}.get();\n"
+            "}\n\n",
+            options.template_depth, options.template_depth + 10, options.template_depth);
+    }
+
+    // 生成宏展开：每次调用展开为4层嵌套宏
+    void generate_macros(FILE* file, const Options& options)
+    {
+        if (options.macro_expansions <= 0)
+        {
+            return;
+        }
+
+        fprintf(file,
+            "// 宏展开：%ld次，每次4层嵌套\n"
+            "#define GPERF_GEN_M1(x) ((x) * 3 + 1)\n"
+            "#define GPERF_GEN_M2(x) GPERF_GEN_M1(GPERF_GEN_M1(x))\n"
+            "#define GPERF_GEN_M3(x) GPERF_GEN_M2(GPERF_GEN_M2(x))\n"
+            "#define GPERF_GEN_M4(x) GPERF_GEN_M3(x) + GPERF_GEN_M1(x)\n\n"
+            "long macro_root(long x)\n"
+            "{\n"
+            "    long result = 0;\n",
+            options.macro_expansions);
+        for (long i = 0; i < options.macro_expansions; i++)
+        {
+            fprintf(file, "    result += GPERF_GEN_M4(x + %ld);\n", i);
+        }
+        fprintf(file, "    return result;\n}\n\n");
+    }
+
+    // 生成函数：按命名空间分组，每个函数体包含body_size条语句
+    void generate_functions(FILE* file, const Options& options)
+    {
+        long per_namespace = options.functions_per_namespace > 0 ? options.functions_per_namespace : 1;
+        for (long i = 0; i < options.functions; i++)
+        {
+            if (i % per_namespace == 0)
+            {
+                fprintf(file, "namespace generated_%ld\n{\n", i / per_namespace);
+            }
+
+            fprintf(file, "    int function_%ld(int x, int y)\n    {\n        int result = x;\n", i);
+            for (long s = 0; s < options.body_size; s++)
+            {
+                fprintf(file, "        result = result * %ld + (y ^ %ld);\n", s % 13 + 2, s);
+            }
+            fprintf(file, "        return result;\n    }\n");
+
+            if (i % per_namespace == per_namespace - 1 || i == options.functions - 1)
+            {
+                fprintf(file, "}\n\n");
+            }
+        }
+    }
+
+    void usage(const char* program)
+    {
+        fprintf(stderr,
+            "Usage: %s --out-dir DIR --name NAME [--include-depth D] [--fan-out F] [--headers H]\n"
+            "          [--functions N] [--body-size S] [--template-depth T] [--macro-expansions M]\n"
+            "          [--functions-per-namespace K]\n",
+            program);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        const char* value = argv[++i];
+        if (arg == "--out-dir")
+        {
+            options.out_dir = value;
+        }
+        else if (arg == "--name")
+        {
+            options.name = value;
+        }
+        else if (arg == "--include-depth")
+        {
+            options.include_depth = atol(value);
+        }
+        else if (arg == "--fan-out")
+        {
+            options.fan_out = atol(value);
+        }
+        else if (arg == "--headers")
+        {
+            options.headers = atol(value);
+        }
+        else if (arg == "--functions")
+        {
+            options.functions = atol(value);
+        }
+        else if (arg == "--body-size")
+        {
+            options.body_size = atol(value);
+        }
+        else if (arg == "--template-depth")
+        {
+            options.template_depth = atol(value);
+        }
+        else if (arg == "--macro-expansions")
+        {
+            options.macro_expansions = atol(value);
+        }
+        else if (arg == "--functions-per-namespace")
+        {
+            options.functions_per_namespace = atol(value);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.fan_out < 1)
+    {
+        options.fan_out = 1;
+    }
+
+    fs::path out_dir{options.out_dir};
+    fs::path include_dir = out_dir / (options.name + "_include");
+    fs::create_directories(include_dir);
+
+    std::vector<long> roots = generate_headers(options, include_dir);
+
+    FILE* file = open_output(out_dir / (options.name + ".cpp"));
+    fprintf(file, "// 由gperf_gen生成的合成翻译单元，请勿手工修改\n\n");
+    for (long id : roots)
+    {
+        fprintf(file, "#include \"%s_include/%s\"\n", options.name.data(), header_name(id).data());
+    }
+    if (!roots.empty())
+    {
+        fprintf(file, "\n");
+    }
+
+    generate_templates(file, options);
+    generate_macros(file, options);
+    generate_functions(file, options);
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,143 @@
+// 输出序列化吞吐量微基准测试
+// 不运行GCC，直接用合成的TraceEvent驱动TraceWriter（插件add_event使用的写入器），
+// 报告每秒事件数、每秒字节数和峰值内存
+//
+// 输出文件以.gz或.zst结尾时经过与插件相同的流式压缩，同时报告压缩后的文件大小；
+// 第三个参数为background时与插件相同由后台线程写入文件，另外报告调用线程上的耗时
+//
+// 合成事件模拟真实trace的组成：头文件路径、pass名称、带命名空间和参数类型的函数签名，
+// 每个事件0~4个参数（static_pass_number、file、rtl_insns等）
+
+#include "trace_compression.h"  // 流式压缩输出
+#include "trace_writer.h"  // 事件流式写入器
+
+#include <chrono>          // 计时
+#include <cstdio>          // 输出
+#include <cstdlib>         // atol
+#include <string>          // 字符串
+#include <vector>          // 向量容器
+
+#include <sys/resource.h>  // getrusage（峰值内存）
+#include <sys/stat.h>      // stat（压缩后的文件大小）
+
+using namespace GccTrace;
+
+namespace
+{
+    // 生成合成事件：名称长度和参数数量按真实trace中各类事件的比例分布
+    std::vector<TraceEvent> make_events(size_t count, std::vector<std::string>& names)
+    {
+        static const char* passes[] = {"ssa", "einline", "ccp", "fre", "vrp", "pre", "expand", "ira", "reload", "final"};
+        static const char* headers[] = {
+            "bits/stl_vector.h", "bits/basic_string.h", "bits/unordered_map.h",
+            "boost/spirit/home/qi/nonterminal/rule.hpp", "project/include/core/very_long_module_name/detail/impl.hpp"
+        };
+
+        // 名称池：事件名称为const char*，由名称池持有
+        names.clear();
+        names.reserve(1024);
+        for (int i = 0; i < 1024; i++)
+        {
+            switch (i % 4)
+            {
+                case 0:
+                    names.push_back(passes[i % 10]);
+                    break;
+                case 1:
+                    names.push_back(std::string("/usr/include/c++/12/") + headers[i % 5]);
+                    break;
+                default:
+                    names.push_back("project::detail::Container<std::basic_string<char>, Allocator<" +
+                        std::to_string(i) + ">>::emplace_back(const value_type&, std::size_t)");
+                    break;
+            }
+        }
+
+        static const EventCategory categories[] = {
+            EventCategory::GIMPLE_PASS, EventCategory::PREPROCESS, EventCategory::FUNCTION, EventCategory::FUNCTION
+        };
+
+        std::vector<TraceEvent> events;
+        events.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            TraceEvent event{names[i % names.size()].data(), categories[i % 4],
+                {static_cast<TimeStamp>(i) * 1000003, static_cast<TimeStamp>(i) * 1000003 + 2000000}, std::nullopt};
+
+            size_t arg_count = i % 5;
+            if (arg_count)
+            {
+                map_t<std::string, std::string> args;
+                static const char* keys[] = {"static_pass_number", "file", "rtl_insns", "asm_bytes"};
+                for (size_t a = 0; a < arg_count; a++)
+                {
+                    args[keys[a]] = a == 1 ? names[(i + 1) % names.size()] : std::to_string(i * 7 + a);
+                }
+                event.args = std::move(args);
+            }
+            events.push_back(std::move(event));
+        }
+        return events;
+    }
+
+    // 峰值常驻内存（KB）
+    long peak_rss_kb()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // 参数：事件数量（默认200万）、输出文件（默认/dev/null）、写入模式
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    const char* output = argc > 2 ? argv[2] : "/dev/null";
+    bool background = argc > 3 && std::string(argv[3]) == "background";
+
+    std::vector<std::string> names;
+    std::vector<TraceEvent> events = make_events(count, names);
+    long setup_rss_kb = peak_rss_kb();
+
+    TraceCompression compression = compression_from_file_name(output);
+    FILE* file = fopen(output, "w");
+    if (file)
+    {
+        file = open_compressed_stream(file, compression);
+    }
+    if (!file)
+    {
+        fprintf(stderr, "gperf-writer-bench: couldn't open %s for writing\n", output);
+        return 1;
+    }
+
+    // 与add_event相同：每个事件写入一对B/E记录
+    // 调用线程耗时：格式化所有事件，不含等待后台线程写完最后的缓冲区
+    auto start = std::chrono::steady_clock::now();
+    TraceWriter writer(file, 1 << 20, background);
+    writer.begin(0);
+    int uid = 0;
+    for (const auto& event : events)
+    {
+        writer.write_event(event, 1, 0, event.ts.start, "B", uid);
+        writer.write_event(event, 1, 0, event.ts.end, "E", uid);
+        uid++;
+    }
+    double caller_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writer.end();
+    fclose(file);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t records = writer.events_written();
+    size_t bytes = writer.bytes_written();
+    struct stat info{};
+    long file_bytes = stat(output, &info) == 0 && S_ISREG(info.st_mode) ? static_cast<long>(info.st_size) : -1;
+    printf("{\"events\": %zu, \"records\": %zu, \"bytes\": %zu, \"file_bytes\": %ld, \"background\": %s, "
+        "\"seconds\": %.6f, \"caller_seconds\": %.6f, "
+        "\"events_per_second\": %.0f, \"bytes_per_second\": %.0f, "
+        "\"peak_rss_kb\": %ld, \"setup_rss_kb\": %ld}\n",
+        events.size(), records, bytes, file_bytes, background ? "true" : "false", seconds, caller_seconds,
+        events.size() / seconds, bytes / seconds, peak_rss_kb(), setup_rss_kb);
+    return 0;
+}
@@ -1,10 +1,12 @@
 #pragma once                // 头文件保护，防止重复包含
 
 #include <chrono>           // 高精度时间库
+#include <cstdint>          // 定长整数类型
 #include <optional>         // 可选类型（C++17）
 #include <string>           // 字符串
 #include <unordered_map>    // 哈希表
 #include <unordered_set>    // 哈希集合
+#include <vector>           // 向量容器
 
 namespace GccTrace // 项目核心命名空间
 {
@@ -47,6 +49,7 @@ namespace GccTrace // 项目核心命名空间
         TU,                 // Translation Unit：整个编译单元
         PREPROCESS,         // 预处理阶段（文件包含、宏展开）
         FUNCTION,           // 函数解析
+        DECLARATION,        // 函数之间的声明解析（类定义、变量声明、命名空间作用域代码）
         STRUCT,             // 结构体/类定义（包括union）
         NAMESPACE,          // 命名空间
         GIMPLE_PASS,        // GIMPLE中间表示优化pass
@@ -56,6 +59,29 @@ namespace GccTrace // 项目核心命名空间
         UNKNOWN             // 未知类型（默认/错误处理）
     };
 
+    // 事件类别数量（用于按类别索引的数组）
+    constexpr int EVENT_CATEGORY_COUNT = UNKNOWN + 1;
+
+    // 插件自身开销的来源：每个GCC回调和最终输出各计一项
+    enum class OverheadSource
+    {
+        START_UNIT,             // cb_start_compilation
+        FILE_CHANGE,            // cb_file_change（不含链式调用的原始回调）
+        FINISH_DECL,            // cb_finish_decl
+        START_PARSE_FUNCTION,   // cb_start_parse_function
+        FINISH_PARSE_FUNCTION,  // cb_finish_parse_function
+        FINISH_TYPE,            // cb_finish_type
+        PASS_EXECUTION,         // cb_pass_execution
+        ALL_IPA_PASSES_START,   // cb_all_ipa_passes_start
+        WRITE_EVENTS,           // write_all_events（构造事件，不含最终的JSON序列化）
+        COUNT                   // 来源数量
+    };
+
+    // 作用域ID：命名空间、类/结构体在作用域树中的驻留编号
+    // 同一个作用域（包括多次重新打开的命名空间）只有一个ID
+    using ScopeId = uint32_t;
+    constexpr ScopeId GLOBAL_SCOPE = 0;  // 全局作用域（作用域树的根节点）
+
     // 追踪事件基本单元，对应Chrome Tracing中的一个事件
     struct TraceEvent
     {
@@ -71,10 +97,38 @@ namespace GccTrace // 项目核心命名空间
     // 从GCC回调函数传递到追踪系统的数据结构
     struct FinishedFunction
     {
-        void* decl;               // GCC的tree节点指针（类型擦除为void*）
-        const char* name;         // 函数签名（如"my_namespace::MyClass::func(int)"）
+        void* decl;               // GCC的tree节点指针（类型擦除为void*，函数签名由此延迟格式化）
         const char* file_name;    // 定义所在的源文件
-        const char* scope_name;   // 所属作用域名称（命名空间或类名）
-        EventCategory scope_type; // 作用域类型（NAMESPACE或STRUCT）
+        ScopeId scope;            // 所属作用域ID（命名空间或类，全局作用域为GLOBAL_SCOPE）
+        bool in_class_body;       // 是否在类定义内定义（类内定义的成员函数）
+    };
+
+    // 已解析完成的类/结构体定义信息结构
+    // 从PLUGIN_FINISH_TYPE回调传递到追踪系统的数据结构
+    struct FinishedType
+    {
+        void* type;               // GCC的tree节点指针（RECORD_TYPE或UNION_TYPE）
+        ScopeId scope;            // 类型自身的作用域ID（名称、父作用域记录在作用域树中）
+        const char* file_name;    // 定义所在的源文件
+        int member_count;         // 成员数量（数据成员、成员函数、成员模板）
+        int base_count;           // 直接基类数量
+        bool nested;              // 是否为嵌套类（定义在另一个类内）
+    };
+
+    // 链接时优化（LTO）阶段：插件被加载到lto1时的运行模式
+    enum class LtoMode
+    {
+        NONE,               // 普通编译（C++前端）
+        LTO,                // 单进程LTO（-flto-partition=none，或lto1的增量链接）
+        WPA,                // 全程序分析（Whole Program Analysis），负责划分分区
+        LTRANS              // 分区的局部变换（Local Transformation），每个分区一个进程
+    };
+
+    // LTO编译单元信息：把WPA进程和它产生的LTRANS进程关联起来
+    struct LtoUnit
+    {
+        LtoMode mode;             // 运行模式
+        std::string run;          // LTO运行标识（LTRANS文件名的公共前缀，如/tmp/ccXXXXXX）
+        int partition;            // LTRANS分区编号（其他模式为-1）
     };
 }  // namespace GccTrace
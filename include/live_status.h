@@ -0,0 +1,131 @@
+// GCC性能追踪插件的实时状态接口头文件
+// 不依赖GCC头文件：编译过程中把当前阶段、pass、函数和包含深度发布到每个进程一个的共享内存，
+// gperf-top在构建进行中读取所有正在运行的编译的状态
+
+#pragma once          // 头文件保护，防止重复包含
+
+#include <cstdint>    // 定长整数类型（共享内存布局）
+
+// ==================== 命名空间声明 ====================
+namespace GccTrace
+{
+    // 共享内存对象名称的前缀（完整名称为/gperf-<pid>，Linux上位于/dev/shm）
+    constexpr const char* LIVE_STATUS_PREFIX = "gperf-";
+
+    // 共享内存布局的标识和版本（布局变化时递增版本，gperf-top跳过不认识的版本）
+    constexpr uint32_t LIVE_STATUS_MAGIC = 0x46524550;  // "PERF"
+    constexpr uint32_t LIVE_STATUS_VERSION = 1;
+
+    // 编译进程当前所处的阶段
+    enum class LivePhase : uint32_t
+    {
+        STARTING,   // 插件已加载，尚未开始预处理或优化
+        PARSE,      // 前端：预处理和解析（包含深度有效）
+        IPA,        // 过程间分析pass
+        GIMPLE,     // 函数的GIMPLE优化pass
+        RTL,        // 函数的RTL pass（包括代码生成）
+        FINISHING   // 编译结束，正在写入trace
+    };
+
+    /**
+     * @brief 阶段的显示名称
+     *
+     * @param phase 阶段
+     * @return "starting"、"parse"、"ipa"、"gimple"、"rtl"或"finishing"
+     */
+    inline const char* live_phase_name(LivePhase phase)
+    {
+        static const char* names[] = {"starting", "parse", "ipa", "gimple", "rtl", "finishing"};
+        auto index = static_cast<uint32_t>(phase);
+        return index < sizeof(names) / sizeof(names[0]) ? names[index] : "?";
+    }
+
+    /**
+     * @brief 共享内存中的状态记录（插件写入，gperf-top只读映射）
+     *
+     * 更新只有普通的内存写入，不调用系统调用。写入期间sequence为奇数（顺序锁）：
+     * 读取方在sequence为偶数且读取前后不变时才使用读到的内容，否则重新读取。
+     * 字符串字段超长时截断，总是以'\0'结尾。
+     */
+    struct LiveStatus
+    {
+        uint32_t magic;             // LIVE_STATUS_MAGIC
+        uint32_t version;           // LIVE_STATUS_VERSION
+        uint32_t sequence;          // 顺序锁计数（写入期间为奇数）
+        int32_t pid;                // 编译进程（cc1plus/lto1）的进程号
+        int64_t start_unix_ns;      // 编译开始的绝对时间（Unix纪元以来的纳秒）
+        int64_t pass_start_ns;      // 当前pass的开始时间（相对编译开始，纳秒）
+        LivePhase phase;            // 当前阶段
+        int32_t include_depth;      // 当前包含深度（主文件为1，前端之外为0）
+        char unit[256];             // 编译单元（主源文件，lto1中为lto1-wpa/ltrans运行名称）
+        char file[256];             // 正在预处理的文件（包含栈顶）
+        char pass[64];              // 当前pass名称
+        char function[256];         // 当前pass处理的函数（汇编名称或声明名称，IPA pass为空）
+    };
+
+    /**
+     * @brief 创建当前进程的状态共享内存
+     *
+     * 创建/gperf-<pid>并映射，初始化状态记录。只在初始化时调用系统调用，之后的更新都是内存写入。
+     * 失败时只输出错误信息，编译照常进行（之后的更新被忽略）。
+     *
+     * @param start_unix_ns 编译开始的绝对时间（Unix纪元以来的纳秒）
+     * @return 创建成功时返回true
+     */
+    bool open_live_status(int64_t start_unix_ns);
+
+    /**
+     * @brief 删除当前进程的状态共享内存
+     *
+     * 编译结束（包括异常结束）时调用，gperf-top不再显示这个编译。
+     * 进程被信号终止时共享内存会残留，gperf-top检测进程已不存在后清理。
+     */
+    void close_live_status();
+
+    /**
+     * @brief 是否已启用实时状态
+     *
+     * pass热路径上先检查，未启用时不读取时钟、不计算更新的参数。
+     *
+     * @return 共享内存已创建时返回true
+     */
+    bool live_status_enabled();
+
+    /**
+     * @brief 设置编译单元名称
+     *
+     * @param name 主源文件或lto1运行名称
+     */
+    void live_status_unit(const char* name);
+
+    /**
+     * @brief 设置当前阶段
+     *
+     * @param phase 阶段
+     */
+    void live_status_phase(LivePhase phase);
+
+    /**
+     * @brief 记录开始执行的pass
+     *
+     * @param name pass名称
+     * @param phase pass所属阶段（IPA/GIMPLE/RTL）
+     * @param start_ns pass开始时间（相对编译开始，纳秒）
+     */
+    void live_status_pass(const char* name, LivePhase phase, int64_t start_ns);
+
+    /**
+     * @brief 记录当前pass处理的函数
+     *
+     * @param name 函数名称，nullptr表示没有函数（IPA pass）
+     */
+    void live_status_function(const char* name);
+
+    /**
+     * @brief 记录预处理进入或离开文件后的包含栈顶
+     *
+     * @param file 包含栈顶的文件，nullptr表示栈已空
+     * @param depth 包含深度
+     */
+    void live_status_include(const char* file, int depth);
+}
@@ -16,37 +16,183 @@ namespace GccTrace
     /**
      * @brief 初始化输出文件系统
      *
-     * 创建JSON根对象，设置Chrome Tracing格式的元数据，准备事件数组容器。
+     * 创建流式写入器（TraceWriter），写入Chrome Tracing格式的元数据和事件数组开头。
      * 必须在插件初始化时调用，且只能调用一次。
      *
      * @param file 已打开的文件句柄（由setup_output函数提供）
-     * @note 该函数会设置全局状态，包括output_json和output_events_list
+     * @param periodic_flush pass边界是否按间隔把事件刷到文件；发送到gperfd的套接字为false
+     *        （套接字刷新不带来持久性，反而要等gperfd读取数据）
+     * @note 该函数会设置全局状态，包括writer和trace_file
      */
-    void init_output_file(FILE* file);
+    void init_output_file(FILE* file, bool periodic_flush = true);
+
+    /**
+     * @brief 设置摘要侧车文件
+     *
+     * 编译结束时除trace中的summary报告外，还把同样的摘要单独写入该文件
+     * （几KB，汇总整个构建时只需读取摘要，不必解析所有事件）。
+     * 不调用时（如trace发送到gperfd）只写入summary报告。
+     *
+     * @param path 摘要文件路径（由setup_output根据trace文件名生成）
+     */
+    void set_summary_file(const std::string& path);
+
+    /**
+     * @brief 设置摘要中的主源文件
+     *
+     * 摘要的unit（lto1中为进程名称）；主文件的预处理事件不计入头文件。
+     *
+     * @param file_name 主源文件（main_input_filename）
+     * @note 由cb_start_compilation调用
+     */
+    void set_summary_main_file(const char* file_name);
+
+    /**
+     * @brief 记录前端结束的时间
+     *
+     * 摘要的frontend_ns为编译开始到此刻（减去其间执行的函数降级pass）。
+     *
+     * @note 由cb_all_ipa_passes_start调用
+     */
+    void set_summary_frontend_end();
+
+    /**
+     * @brief 处理等待中的终止信号
+     *
+     * 终止信号（SIGTERM、SIGINT等）的处理只记录信号；编译线程在检查点
+     * （pass边界、文件切换、刷新输出）调用本函数，在普通上下文中关闭trace
+     * （TU事件带"incomplete"参数，incomplete报告的reason为信号名），
+     * 再恢复原来的处理方式并重新发送信号。没有等待中的信号时只读取一个标志。
+     *
+     * @note 编译长时间没有到达检查点时，再次发送信号会立即结束进程（trace停在最后一次刷新处）
+     */
+    void check_fatal_signal();
+
+    /**
+     * @brief 把已写入的事件刷到文件
+     *
+     * 等待后台线程写完缓冲区，刷新文件缓冲区，压缩输出时同步刷新压缩流，
+     * 使编译中途被终止（无法处理的SIGKILL）时文件中已有这些事件，截断的trace仍可读取。
+     * 在阶段边界调用：前端结束时强制刷新，pass边界按间隔（1秒）刷新（发送到gperfd时不刷新）。
+     *
+     * @param force 为false时距上次刷新不足间隔则跳过
+     */
+    void flush_output(bool force = false);
+
+    /**
+     * @brief 设置某一类别的最小事件长度
+     *
+     * 默认每个类别都是MINIMUM_EVENT_LENGTH_NS（1ms），由插件参数
+     * -fplugin-arg-gperf-threshold[-类别]=微秒 调整。必须在输出任何事件之前调用。
+     * TU事件不受阈值限制（init_output_file设为0），插件不为TU类别调用本函数。
+     *
+     * @param category 事件类别
+     * @param threshold_ns 最小事件长度（纳秒），0表示输出该类别的所有事件
+     */
+    void set_event_threshold(EventCategory category, TimeStamp threshold_ns);
+
+    /**
+     * @brief 按插件参数中的名称查找事件类别
+     *
+     * 名称为"cat"字段的小写形式，下划线写作连字符（如function、gimple-pass）。
+     *
+     * @param name 类别名称
+     * @param category 查找结果
+     * @return 找到时返回true
+     */
+    bool parse_event_category(const char* name, EventCategory& category);
+
+    /**
+     * @brief 判断事件是否会被输出
+     *
+     * 与add_event使用相同的过滤规则（短于所属类别阈值的事件被丢弃）。
+     * 追踪模块据此跳过注定被过滤的事件，避免为它们格式化名称、构造参数；
+     * 跳过的事件应交给record_dropped_event计入汇总。
+     *
+     * @param category 事件类别
+     * @param ts 事件时间跨度
+     * @return 事件会被输出时返回true
+     */
+    bool should_emit_event(EventCategory category, const TimeSpan& ts);
+
+    /**
+     * @brief 把被丢弃的事件计入"other"聚合
+     *
+     * 按类别（有文件时同时按文件）累计事件数量和总时间，编译结束时输出为
+     * belowThreshold报告，使trace在丢弃短事件的同时仍然覆盖全部时间。
+     *
+     * @param category 事件类别
+     * @param file 事件所属的文件（规范化文件名，可为nullptr）
+     * @param ts 事件时间跨度
+     */
+    void record_dropped_event(EventCategory category, const char* file, const TimeSpan& ts);
 
     /**
      * @brief 添加单个追踪事件到输出队列
      *
-     * 将收集到的编译事件转换为JSON格式，并添加到输出缓冲区。
+     * 将收集到的编译事件直接序列化为JSON文本，写入输出缓冲区（缓冲区满时写入文件）。
      * 每个事件会生成一对"B"（开始）和"E"（结束）记录。
      *
      * @param event 要添加的追踪事件（包含名称、类别、时间跨度等）
-     * @note 内部会过滤短于MINIMUM_EVENT_LENGTH_NS（1ms）的事件
+     * @note 内部会过滤短于类别阈值（默认1ms）的事件，并计入"other"聚合
      * @note 自动分配唯一UID确保开始/结束事件正确配对
      */
     void add_event(const TraceEvent& event);
 
+    /**
+     * @brief 添加附加报告到输出文件
+     *
+     * 报告作为JSON根对象的顶层键输出（与traceEvents并列），
+     * Chrome Tracing和Perfetto会忽略未知的顶层键，不影响时间线显示。
+     * 用于输出不适合表示为时间跨度的汇总数据（如作用域汇总）。
+     *
+     * @param key 报告的键名（如"scopeRollup"）
+     * @param report 报告内容，所有权转移给输出系统
+     * @note 报告在所有事件之后按添加顺序写入，必须在write_all_events结束之前调用
+     */
+    void add_report(const char* key, json::value* report);
+
+    /**
+     * @brief 添加计数器事件
+     *
+     * 输出Chrome Tracing计数器事件（"ph": "C"），同名计数器在Perfetto中
+     * 显示为进程下的一条独立轨道，每个键一条曲线。
+     *
+     * @param name 计数器（轨道）名称
+     * @param ts 时间戳（纳秒）
+     * @param values 各曲线在该时刻的取值
+     */
+    void add_counter_event(const char* name, TimeStamp ts, const map_t<std::string, double>& values);
+
+    /**
+     * @brief 设置当前进程在Chrome Tracing中的名称和排序
+     *
+     * 输出process_name和process_sort_index元数据事件（"ph": "M"），
+     * 合并多个进程的trace（如LTO的WPA和各LTRANS分区）时用于区分和排列进程。
+     *
+     * @param name 进程名称
+     * @param sort_index 进程排序值（越小越靠前）
+     */
+    void set_process_name(const char* name, int sort_index);
+
     /**
      * @brief 写入所有追踪事件并完成输出
      *
      * 插件的主输出入口函数，在编译结束时调用。
      * 执行顺序：
-     * 1. 添加TU（整个编译单元）总时间事件
-     * 2. 调用各模块的写入函数（预处理、优化pass、函数、作用域）
-     * 3. 序列化JSON到文件
+     * 0. 格式化会被输出的事件名称（resolve_deferred_names）
+     * 1. 结束最后一个优化pass，添加TU（整个编译单元）总时间事件
+     * 2. 调用各模块的写入函数（预处理、函数、作用域；pass事件已在编译过程中写入），
+     *    最后写入插件自身的开销（包括0-2步的耗时）
+     * 3. 结束事件数组，写入附加报告
      * 4. 清理内存资源
      *
      * @note 此函数由cb_plugin_finish回调触发
+     * @note 编译异常结束（致命错误、内部编译器错误后exit）时不会调用，
+     *       由init_output_file安装的atexit回调关闭trace：写入已收集的事件，
+     *       TU事件带"incomplete"参数，并输出incomplete报告（reason、end_ns）
+     * @note 终止信号的处理只记录信号（异步信号安全），由check_fatal_signal
+     *       在下一个检查点以同样的方式关闭trace后重新发送信号
      */
     void write_all_events();
 
@@ -67,9 +213,9 @@ namespace GccTrace
 /**
  * 本模块是项目的输出层，依赖关系如下：
  *
- *        comm.h（数据定义）           外部：json.h（GCC JSON库）
+ *        comm.h（数据定义）           外部：json.h（GCC JSON库，仅附加报告）
  *              ↓                            ↓
- *         perf_output.h（本文件）
+ *         perf_output.h（本文件）  ←  trace_writer.h（事件流式序列化，不依赖GCC）
  *              ↓
  *     ┌───────┼───────┐
  *     ↓       ↓       ↓
@@ -79,12 +225,16 @@ namespace GccTrace
  *
  * 数据流向：
  * 1. 各追踪模块 → 收集事件数据 → TraceEvent
- * 2. TraceEvent → add_event() → JSON格式转换
- * 3. JSON数据 → write_all_events() → trace.json文件
+ * 2. TraceEvent → add_event() → TraceWriter直接格式化为JSON文本 → trace.json文件
+ * 3. 附加报告（json::value）→ write_all_events() → 追加到根对象
  *
  * 关键设计：
- * - 延迟写入：所有事件先收集在内存中，编译结束时一次性写入
- * - 事件过滤：跳过短于1ms的事件，减少噪音和文件大小
+ * - 写入时机：pass事件在pass结束时流式写入；预处理、声明和作用域事件在前端结束时写入；
+ *   函数事件需要最终的代码大小，编译结束时写入（流式序列化，不构造JSON对象树）
+ * - 异常结束：阶段边界把事件刷到文件；atexit写入incomplete报告并关闭trace，终止信号在下一个检查点关闭trace
+ * - 后台写入：写满的缓冲区由TraceWriter的后台线程写入文件（双缓冲），文件I/O和压缩不在编译线程上
+ * - 事件过滤：跳过短于类别阈值（默认1ms）的事件，减少噪音和文件大小；
+ *   被跳过的事件按类别和文件汇总到belowThreshold报告
  * - 时间转换：内部使用纳秒，输出转换为微秒（Chrome Tracing标准）
  * - 版本兼容：处理GCC 14+与旧版本的JSON dump API差异
  */
@@ -12,6 +12,20 @@ namespace GccTrace
 {
     // ==================== 函数/作用域追踪接口 ====================
 
+    /**
+     * @brief 处理函数解析开始事件
+     *
+     * 当GCC开始解析一个函数体时调用，记录函数解析的真实开始时间。
+     * 主要任务：
+     * 1. 将开始时间压入函数解析栈（lambda、局部类成员函数会嵌套解析）
+     * 2. 如果是最外层函数，把上一个函数结束到本函数开始之间的时间
+     *    记录为DECLARATION事件（类定义、变量声明、命名空间作用域代码）
+     *
+     * @note 由cb_start_parse_function回调调用，在tracking.cpp中实现
+     * @note 与end_parse_function配对使用
+     */
+    void start_parse_function();
+
     /**
      * @brief 处理函数解析完成事件
      *
@@ -24,29 +38,108 @@ namespace GccTrace
      * 3. 记录到函数事件列表和相应作用域事件
      *
      * @param info FinishedFunction结构，包含：
-     *   - decl: GCC tree节点指针（类型擦除为void*）
-     *   - name: 函数完整签名（包含命名空间和参数类型）
+     *   - decl: GCC tree节点指针（类型擦除为void*，函数签名延迟格式化）
      *   - file_name: 定义所在的源文件
-     *   - scope_name: 所属作用域名称（命名空间或类名，可能为空）
-     *   - scope_type: 作用域类型（NAMESPACE或STRUCT）
+     *   - scope: 所属作用域ID（命名空间或类，沿完整上下文链驻留）
+     *   - in_class_body: 是否为类内定义的成员函数
      *
      * @note 由cb_finish_parse_function回调调用，在tracking.cpp中实现
      * @see tracking.cpp中的end_parse_function实现
      */
     void end_parse_function(FinishedFunction info);
 
+    /**
+     * @brief 处理类/结构体定义完成事件
+     *
+     * 当GCC完成一个类、结构体或联合体的定义时调用（PLUGIN_FINISH_TYPE）。
+     * GCC没有对应的开始回调，因此：
+     * - 最外层类从上一个命名空间作用域实体结束处开始计时，
+     *   类内定义的成员函数（在类定义结束前解析）包含在类定义内
+     * - 嵌套类从外层类中上一个函数或嵌套类结束处开始计时
+     *
+     * @param info FinishedType结构，包含类型名称、成员数量、基类数量等
+     * @note 由cb_finish_type回调调用，在tracking.cpp中实现
+     * @note 函数体内的局部类计入外层函数，不单独追踪
+     */
+    void end_parse_type(FinishedType info);
+
+    /**
+     * @brief 查找已驻留的作用域
+     *
+     * @param key GCC tree节点指针（NAMESPACE_DECL、RECORD_TYPE或UNION_TYPE）
+     * @return 作用域ID，未驻留时返回GLOBAL_SCOPE
+     * @note 插件先查找，未命中时才沿上下文链驻留
+     */
+    ScopeId find_scope(const void* key);
+
+    /**
+     * @brief 驻留一个新的作用域节点
+     *
+     * 作用域树按完整的上下文链构建（由外到内驻留），每个节点累计：
+     * - 直接定义在此作用域的函数数量和解析时间
+     * - 包含所有子作用域的函数解析时间
+     * - 类定义本身的解析时间，以及不重复计算的独占解析时间
+     *
+     * @param key GCC tree节点指针（作用域名称由此延迟格式化）
+     * @param parent 父作用域ID（必须已驻留）
+     * @param type 作用域类型（NAMESPACE或STRUCT）
+     * @return 新作用域的ID
+     */
+    ScopeId intern_scope(const void* key, ScopeId parent, EventCategory type);
+
+    /**
+     * @brief 格式化声明或类型的名称
+     *
+     * 对decl_as_string的封装，供追踪系统延迟格式化函数签名和作用域名称。
+     * lto1中，以及-flto编译中free_lang_data释放语言数据之后（PLUGIN_ALL_IPA_PASSES_START起），
+     * 改为反修饰汇编名称。返回的字符串由GCC垃圾回收管理（或为静态缓冲区），调用方需要立即拷贝。
+     *
+     * @param decl GCC tree节点指针（FUNCTION_DECL、NAMESPACE_DECL或类类型）
+     * @return 带命名空间和参数类型的完整名称
+     * @note 在plugin.cpp中实现
+     */
+    const char* decl_name(const void* decl);
+
+    /**
+     * @brief 格式化所有会被输出的事件名称
+     *
+     * 解析阶段只保存tree节点和时间戳，此函数只为通过最小事件长度过滤的
+     * 函数事件、作用域事件以及汇总报告中的作用域格式化名称，
+     * 被过滤的事件（通常是绝大多数）从不调用decl_as_string。
+     *
+     * @note 在前端解析结束后（PLUGIN_ALL_IPA_PASSES_START）调用一次，
+     *       此时语言相关数据尚未被free_lang_data释放；write_all_events中再调用一次兜底
+     * @note 可重复调用，已格式化的名称不会重复处理
+     */
+    void resolve_deferred_names();
+
+    /**
+     * @brief 处理命名空间作用域声明完成事件
+     *
+     * 将声明的解析时间计入DECLARATION事件，并作为下一个类定义的开始时间；
+     * 关闭不在声明作用域链上的已打开命名空间，使命名空间事件只合并连续的解析。
+     *
+     * @param scope 声明所在的作用域ID（DECL_CONTEXT，全局作用域为GLOBAL_SCOPE）
+     * @note 由cb_finish_decl回调调用，只处理命名空间作用域的声明
+     */
+    void end_toplevel_declaration(ScopeId scope);
+
     /**
      * @brief 写入所有作用域（命名空间、类/结构体）事件
      *
      * 将收集到的所有作用域追踪事件转换为JSON格式并输出。
      * 作用域包括：
-     * - NAMESPACE: C++命名空间
-     * - STRUCT: 结构体、类、联合体
+     * - NAMESPACE: C++命名空间（由连续函数/类定义的作用域合并得到）
+     * - STRUCT: 结构体、类、联合体（由PLUGIN_FINISH_TYPE追踪的真实定义）
      *
      * 每个作用域事件包含：
      * 1. 作用域名称
      * 2. 作用域类型
      * 3. 时间跨度（进入和离开作用域的时间）
+     * 4. 类定义的额外参数：成员数量、基类数量、成员函数数量及总解析时间
+     *
+     * 同时输出作用域树的汇总报告（顶层键"scopeRollup"），每个命名空间/类一条记录，
+     * 包含自身及所有子作用域的函数解析时间和独占解析时间。
      *
      * @note 由write_all_events调用，在编译结束时统一输出
      * @note 在tracking.cpp中实现，遍历scope_events向量
@@ -70,6 +163,17 @@ namespace GccTrace
      */
     void write_all_functions();
 
+    /**
+     * @brief 写入所有声明解析事件
+     *
+     * 输出函数之间的声明解析时间（DECLARATION类别），
+     * 避免把类定义、变量声明等开销错误地计入紧随其后的函数。
+     *
+     * @note 由write_all_events调用，在编译结束时统一输出
+     * @note 在tracking.cpp中实现，遍历declaration_events向量
+     */
+    void write_all_declarations();
+
 } // namespace GccTrace
 
 // ==================== 模块角色说明 ====================
@@ -78,19 +182,20 @@ namespace GccTrace
  *
  * 数据来源：GCC AST（抽象语法树）
  *           ↓
- *     cb_finish_parse_function（GCC回调）
+ *     cb_start_parse_function / cb_finish_parse_function（GCC回调）
  *           ↓
- *     end_parse_function（提取函数信息）
+ *     start_parse_function / end_parse_function（提取函数信息）
  *           ↓
- *   存储到 function_events / scope_events
+ *   存储到 function_events / scope_events / declaration_events
  *           ↓
- * write_all_functions / write_all_scopes（输出时调用）
+ * write_all_functions / write_all_scopes / write_all_declarations（输出时调用）
  *           ↓
  *        add_event（JSON转换）
  *
  * 关键特点：
- * 1. 作用域处理：智能合并连续函数的作用域，避免重复事件
- * 2. 时间对齐：微调时间戳避免Chrome Tracing显示重叠
+ * 1. 作用域处理：沿完整上下文链驻留作用域树，按嵌套关系合并连续的命名空间事件，
+ *    类定义由PLUGIN_FINISH_TYPE直接追踪，汇总数据按作用域ID精确累计
+ * 2. 时间对齐：函数开始时间来自PLUGIN_START_PARSE_FUNCTION，微调时间戳避免Chrome Tracing显示重叠
  * 3. 路径规范化：将绝对路径转换为相对包含路径
  *
  * 相关文件：
@@ -0,0 +1,22 @@
+// GCC性能追踪插件的收集守护进程（gperfd）客户端接口头文件
+// 不依赖GCC头文件：把trace流式发送到gperfd的Unix套接字，而不是写入文件
+
+#pragma once          // 头文件保护，防止重复包含
+
+#include <cstdio>     // FILE*
+
+// ==================== 命名空间声明 ====================
+namespace GccTrace
+{
+    /**
+     * @brief 连接gperfd收集守护进程
+     *
+     * 连接上Unix套接字后包装为FILE*：写入的内容与trace文件完全相同，
+     * gperfd在连接关闭时把它作为一个完整（或被截断）的trace汇总。
+     * 写入使用MSG_NOSIGNAL：gperfd中途退出时写入失败，不会以SIGPIPE终止编译器。
+     *
+     * @param socket_path gperfd监听的Unix套接字路径
+     * @return 包装后的FILE*；连接失败时返回nullptr
+     */
+    std::FILE* connect_collector(const char* socket_path);
+}
@@ -0,0 +1,73 @@
+// GCC性能追踪插件的trace压缩输出接口头文件
+// 不依赖GCC头文件：把输出文件包装为边写边压缩的FILE*，写入器和GCC JSON库都直接写入它
+
+#pragma once          // 头文件保护，防止重复包含
+
+#include <cstdio>     // FILE*
+#include <string_view>// 字符串视图（文件名、参数）
+
+// ==================== 命名空间声明 ====================
+namespace GccTrace
+{
+    // trace文件的压缩格式
+    enum class TraceCompression
+    {
+        NONE,   // 不压缩（.json）
+        GZIP,   // gzip（.json.gz，Perfetto可直接打开）
+        ZSTD    // zstd（.json.zst）
+    };
+
+    /**
+     * @brief 压缩格式对应的文件扩展名
+     *
+     * @param compression 压缩格式
+     * @return ".gz"、".zst"，不压缩时为空字符串
+     */
+    const char* compression_extension(TraceCompression compression);
+
+    /**
+     * @brief 按文件扩展名判断压缩格式
+     *
+     * @param file_name 文件名（以.gz或.zst结尾时压缩）
+     * @return 压缩格式
+     */
+    TraceCompression compression_from_file_name(std::string_view file_name);
+
+    /**
+     * @brief 解析压缩格式名称（插件参数compress的取值）
+     *
+     * @param name "none"、"gzip"/"gz"或"zstd"/"zst"
+     * @param compression 解析结果
+     * @return 名称有效时返回true
+     */
+    bool parse_compression(std::string_view name, TraceCompression& compression);
+
+    /**
+     * @brief 插件构建时是否启用了该压缩格式（zlib、libzstd为可选依赖）
+     */
+    bool compression_supported(TraceCompression compression);
+
+    /**
+     * @brief 把已打开的文件包装为流式压缩的FILE*
+     *
+     * 写入返回的FILE*的数据分块压缩后立即写入底层文件，不在内存中保留未压缩的输出。
+     * fclose返回的FILE*时写入压缩流的结尾并关闭底层文件。
+     *
+     * @param file 已打开的输出文件（所有权转移）
+     * @param compression 压缩格式，NONE时直接返回file
+     * @return 包装后的FILE*；失败时返回nullptr（file已关闭）
+     */
+    std::FILE* open_compressed_stream(std::FILE* file, TraceCompression compression);
+
+    /**
+     * @brief 把已写入的数据刷到文件
+     *
+     * 普通文件等同于fflush；open_compressed_stream返回的FILE*还会同步刷新压缩器
+     * （gzip Z_SYNC_FLUSH、zstd ZSTD_e_flush），之后即使进程被终止、压缩流没有结尾，
+     * 已写入的数据也能解压出来。
+     *
+     * @param file 输出文件
+     * @return 成功返回true
+     */
+    bool flush_trace_stream(std::FILE* file);
+}
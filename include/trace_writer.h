@@ -0,0 +1,181 @@
+// GCC性能追踪插件的Chrome Tracing流式序列化接口头文件
+// 不依赖GCC头文件：插件和独立的序列化基准测试（bench/gperf_writer_bench.cpp）共用
+
+#pragma once          // 头文件保护，防止重复包含
+
+#include "comm.h"     // 项目核心数据结构（TraceEvent, TimeStamp等）
+
+#include <cstdio>     // FILE*
+#include <string>     // 输出缓冲区
+#include <string_view>// 字符串视图（转义输出）
+
+// ==================== 命名空间声明 ====================
+namespace GccTrace
+{
+    /**
+     * @brief 事件类别名称（"cat"字段的取值，如"FUNCTION"、"GIMPLE_PASS"）
+     *
+     * @param category 事件类别
+     * @return 类别名称（静态字符串）
+     */
+    const char* category_string(EventCategory category);
+
+    /**
+     * @brief Chrome Tracing格式的流式JSON写入器
+     *
+     * 事件直接格式化到输出缓冲区，缓冲区满时写入文件，不为每个事件构造JSON对象树。
+     * 输出结构：
+     *   {"displayTimeUnit": "ns", "beginningOfTime": ..., "traceEvents": [事件...], 附加键...}
+     *
+     * 使用顺序：begin → write_event/write_counter/write_process_metadata（任意次）
+     *          → begin_key（附加键，由调用方sync后写入值）→ end
+     *
+     * 后台模式下使用双缓冲：写满的缓冲区交给后台线程写入文件（包括压缩），
+     * 调用线程换用另一个缓冲区继续格式化事件，只有后台线程落后一整个缓冲区时才等待。
+     */
+    class TraceWriter
+    {
+    public:
+        /**
+         * @brief 构造写入器
+         *
+         * @param file 已打开的输出文件（所有权不转移，由调用方关闭）
+         * @param buffer_size 输出缓冲区大小，缓冲区满时写入文件
+         * @param background_writer 是否由后台线程写入文件
+         */
+        explicit TraceWriter(std::FILE* file, size_t buffer_size = 1 << 20, bool background_writer = false);
+
+        /**
+         * @brief 析构：等待后台线程写完所有缓冲区并结束线程
+         */
+        ~TraceWriter();
+
+        TraceWriter(const TraceWriter&) = delete;
+        TraceWriter& operator=(const TraceWriter&) = delete;
+
+        /**
+         * @brief 写入根对象开头和traceEvents数组开头
+         *
+         * 根对象格式（而非可省略结尾"]"的JSON数组格式）用于在事件之后输出附加报告；
+         * 缺少结尾"]}"的截断trace不能直接在chrome://tracing或Perfetto中打开，
+         * 只有tools/中的工具（trace_reader）会在最后一个完整记录处补全后读取。
+         *
+         * @param beginning_of_time_us 时间原点（编译开始的绝对时间，微秒）
+         */
+        void begin(int64_t beginning_of_time_us);
+
+        /**
+         * @brief 写入单个追踪事件记录
+         *
+         * @param event 追踪事件（名称、类别、参数）
+         * @param pid 进程ID
+         * @param tid 线程ID
+         * @param ts 时间戳（纳秒，输出为精确到纳秒的微秒值）
+         * @param phase 事件阶段（"B"开始或"E"结束）
+         * @param uid 事件唯一标识符，用于配对开始和结束事件
+         */
+        void write_event(const TraceEvent& event, int pid, int tid, TimeStamp ts,
+            const char* phase, int uid);
+
+        /**
+         * @brief 写入计数器事件（"ph": "C"）
+         *
+         * @param name 计数器名称
+         * @param pid 进程ID
+         * @param ts 时间戳（纳秒）
+         * @param values 各曲线的取值
+         */
+        void write_counter(const char* name, int pid, TimeStamp ts, const map_t<std::string, double>& values);
+
+        /**
+         * @brief 写入进程元数据事件（"ph": "M"）
+         *
+         * @param name 元数据名称（如process_name、process_sort_index）
+         * @param pid 进程ID
+         * @param key 参数名称
+         * @param value 参数值（字符串或整数）
+         */
+        void write_process_metadata(const char* name, int pid, const char* key, std::string_view value);
+        void write_process_metadata(const char* name, int pid, const char* key, int64_t value);
+
+        /**
+         * @brief 结束traceEvents数组（如果未结束），写入附加键名
+         *
+         * 调用方随后必须写入一个JSON值：先sync，再直接写入文件。
+         *
+         * @param key 附加键名
+         */
+        void begin_key(const char* key);
+
+        /**
+         * @brief 结束traceEvents数组（如果未结束）和根对象，并sync
+         */
+        void end();
+
+        /**
+         * @brief 把缓冲区写入文件（后台模式下交给后台线程，不等待写入完成）
+         */
+        void flush();
+
+        /**
+         * @brief 把缓冲区写入文件并等待写入完成
+         *
+         * 调用方直接写入文件（如附加报告）之前必须调用，保证输出顺序。
+         */
+        void sync();
+
+        /**
+         * @brief 已生成的字节数（包括尚在缓冲区中的字节）
+         */
+        size_t bytes_written() const
+        {
+            return flushed_bytes + buffer.size();
+        }
+
+        /**
+         * @brief 已写入的事件记录数
+         */
+        size_t events_written() const
+        {
+            return event_count;
+        }
+
+    private:
+        struct BackgroundWriter;  // 后台写入线程状态（定义在trace_writer.cpp，头文件不引入线程库）
+
+        // 写入元数据事件开头（参数值之前的部分）
+        void begin_process_metadata(const char* name, int pid, const char* key);
+
+        // 追加JSON字符串（带引号，转义引号、反斜杠和控制字符）
+        void append_string(std::string_view text);
+
+        // 追加整数
+        void append_integer(int64_t value);
+
+        // 追加浮点数
+        void append_double(double value);
+
+        // 追加时间戳：纳秒 → 微秒，保留3位小数（精确到纳秒）
+        void append_timestamp(TimeStamp ts);
+
+        // 开始一个事件记录（数组元素之间的逗号）
+        void begin_record();
+
+        // 缓冲区超过阈值时写入文件
+        void flush_if_full()
+        {
+            if (buffer.size() >= buffer_limit)
+            {
+                flush();
+            }
+        }
+
+        std::FILE* file;              // 输出文件
+        std::string buffer;           // 输出缓冲区
+        size_t buffer_limit;          // 缓冲区阈值
+        size_t flushed_bytes = 0;     // 已交给文件（或后台线程）的字节数
+        size_t event_count = 0;       // 已写入的事件记录数
+        bool events_open = false;     // traceEvents数组是否尚未结束
+        BackgroundWriter* background = nullptr;  // 后台写入线程（非后台模式为nullptr）
+    };
+}
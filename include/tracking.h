@@ -5,6 +5,8 @@
 #include "perf_output.h"  // JSON输出接口（add_event函数依赖）
 #include "plugin.h"       // 插件接口（声明对称性，实际可能不直接依赖）
 
+#include <vector>         // 向量容器（内联决策的被调用者列表）
+
 namespace GccTrace
 {
     // ==================== 预处理阶段追踪接口组 ====================
@@ -72,6 +74,7 @@ namespace GccTrace
      * - 使用规范化文件名（相对包含路径）
      *
      * @note 由write_all_events统一调用
+     * @note 已在前端结束时写入的文件不会重复写入
      */
     void write_preprocessing_events();
 
@@ -88,15 +91,260 @@ namespace GccTrace
      *
      * @param pass GCC优化pass对象指针
      *             包含pass名称、类型、静态编号等信息
+     * @param function pass处理的函数（原始函数的tree节点，克隆归并到原始函数）
+     *                 IPA pass等不针对单个函数的pass为nullptr
+     * @param file_name 函数定义所在的源文件（函数为nullptr时也为nullptr）
+     *                  未详细追踪的源文件上的pass只计入该文件的"other"汇总
      * @note 由cb_pass_execution回调调用
      * @note 时间戳微调（+1纳秒）避免pass事件重叠
      */
-    void start_opt_pass(const opt_pass* pass);
+    void start_opt_pass(const opt_pass* pass, const void* function, const char* file_name);
+
+    /**
+     * @brief 添加源文件路径过滤
+     *
+     * 只详细追踪第一方代码：include路径（可多个）之外、或exclude路径（优先）之内的源文件
+     * 不生成函数、类定义、预处理和pass事件，它们的时间按文件计入"other"汇总
+     * （见belowThreshold报告）。路径按真实路径的前缀匹配。
+     *
+     * @param path 目录或文件路径
+     * @param include true为只详细追踪该路径，false为不详细追踪该路径
+     * @note 由setup_output根据插件参数include-path和exclude-path调用
+     */
+    void add_path_filter(const char* path, bool include);
+
+    /**
+     * @brief 判断源文件是否详细追踪
+     *
+     * 每个文件只匹配一次，结果按GCC驻留的文件名指针缓存。
+     *
+     * @param file_name 源文件名（GCC的DECL_SOURCE_FILE等，可为nullptr）
+     * @return 需要详细追踪时返回true（没有过滤规则或文件未知时总是true）
+     */
+    bool is_traced_file(const char* file_name);
+
+    /**
+     * @brief 设置pass执行采样
+     *
+     * PLUGIN_PASS_EXECUTION对每个函数的每个pass触发，-O2下的大型翻译单元可达千万次。
+     * 采样模式按函数哈希确定性地只完整追踪1/N的函数，报告中按采样率外推总时间；
+     * 记录的pass事件总数有硬上限，超出部分只计数不保存。
+     *
+     * @param sample_rate 采样率N（≤1表示追踪所有函数）
+     * @param max_events 记录的pass事件上限（≤0表示不限制）
+     * @note 由setup_output根据插件参数sample和max-pass-events调用
+     */
+    void configure_pass_sampling(int sample_rate, int64_t max_events);
+
+    /**
+     * @brief 判断是否追踪函数上执行的pass
+     *
+     * 同一函数的采样结果只由哈希值决定，因此同一函数的所有pass一起被追踪或跳过，
+     * 使用汇编名称的哈希时多次编译、多个翻译单元之间的采样结果一致。
+     *
+     * @param function 原始函数的tree节点
+     * @param hash 函数的确定性哈希值（汇编名称哈希）
+     * @return 需要追踪时返回true，否则调用方应调用skip_opt_pass
+     */
+    bool sample_function(const void* function, uint32_t hash);
+
+    /**
+     * @brief 跳过一个未被采样的pass
+     *
+     * 只结束上一个被追踪的pass（连续跳过时不读取时钟），不记录新事件。
+     *
+     * @note 由cb_pass_execution回调调用，替代start_opt_pass
+     */
+    void skip_opt_pass();
+
+    /**
+     * @brief 写入pass采样报告
+     *
+     * 开启采样或发生事件丢弃时，作为顶层键"passSampling"输出：
+     * 采样率、被追踪/跳过的函数数、跳过的pass执行次数、丢弃的事件数，
+     * 以及每个pass追踪到的时间和按采样率外推的估计时间（IPA pass不外推）。
+     * 超过max-pass-events上限的事件不保存，但其时间仍按pass计入估计。
+     *
+     * @note 由write_all_events统一调用
+     */
+    void write_sampling_report();
+
+    /**
+     * @brief 记录函数的生成代码大小
+     *
+     * 在final pass处统计函数的RTL指令数，并在final结束后统计输出的汇编字节数。
+     * 同一函数的多个克隆（构造函数变体、IPA克隆）累加到原始函数。
+     *
+     * @param function 原始函数的tree节点
+     * @param rtl_insns 增加的RTL指令数（不含调试指令）
+     * @param asm_bytes 增加的汇编文本字节数，-1表示无法获取（如-pipe输出到管道）
+     * @note 由cb_pass_execution回调调用
+     */
+    void record_function_code_size(const void* function, int64_t rtl_insns, int64_t asm_bytes);
+
+    /**
+     * @brief 记录内联pass中一个调用者的内联决策
+     *
+     * 在早期内联（einline）或过程间内联（inline）结束后调用，
+     * 汇总到当前内联pass事件的参数（inlined_calls、size_growth），
+     * 并保存完整记录用于内联报告。
+     *
+     * @param caller 调用者（原始函数的tree节点）
+     * @param callees 被内联的调用点所调用的函数，每个调用点一项（包括被内联函数中再内联的调用），
+     *        同一函数的多个调用点在报告中合并并计数
+     * @param size_before 内联前调用者的估计大小（GCC内联器的大小单位，-1表示未知）
+     * @param size_after 内联后调用者的估计大小（-1表示未知）
+     * @note 由cb_pass_execution回调在内联pass之后的下一个pass开始时调用
+     * @note 调用者和被调用者的名称在此格式化（每个函数只格式化一次），编译结束时不再访问tree
+     */
+    void record_inlining(const void* caller, std::vector<const void*> callees, int size_before, int size_after);
+
+    /**
+     * @brief 写入内联报告
+     *
+     * 每个内联pass中的每个调用者一条记录，作为顶层键"inlineReport"输出：
+     * pass名称、调用者、被内联的函数列表、内联前后的估计大小及增长，
+     * 用于找出导致后续pass变慢的内联级联。
+     *
+     * @note 由write_all_events统一调用
+     */
+    void write_inline_report();
 
     /**
-     * @brief 写入所有优化pass事件
+     * @brief 写入函数报告
      *
-     * 将收集到的所有优化pass追踪事件转换为JSON格式并输出。
+     * 把每个函数的解析时间、优化时间（该函数上所有GIMPLE/RTL pass之和）
+     * 与生成代码大小关联到一条记录，作为顶层键"functionReport"输出。
+     * 报告所有生成了代码的函数，以及解析+优化时间超过最小事件长度的函数。
+     *
+     * @note 由write_all_events统一调用
+     */
+    void write_function_report();
+
+    /**
+     * @brief 写入pass事件处理的函数名称
+     *
+     * pass事件的"function"参数是函数在本报告中的下标（不为每个pass事件格式化函数名称），
+     * 作为顶层键"passFunctions"输出为函数名称数组。
+     *
+     * @note 由write_all_events统一调用
+     */
+    void write_pass_function_report();
+
+    // ==================== 插件开销追踪接口组 ====================
+
+    /**
+     * @brief 记录一次插件自身的开销
+     *
+     * 按来源累计调用次数和耗时；每隔一段时间保存一次累计值的采样点，
+     * 输出为"gperf overhead"计数器轨道，显示插件开销随编译进度的增长。
+     *
+     * @param source 开销来源（回调或输出）
+     * @param start 开始时间戳（结束时间戳在函数内读取）
+     * @note 通常通过OverheadScope自动调用
+     */
+    void record_overhead(OverheadSource source, TimeStamp start);
+
+    /**
+     * @brief 插件开销计时作用域
+     *
+     * 在回调开头定义局部变量，离开作用域（包括提前返回）时记录开销：
+     *   OverheadScope overhead{OverheadSource::PASS_EXECUTION};
+     * active为false时不读取时钟、不记录（pass_execution中未被采样的函数上的pass）
+     */
+    struct OverheadScope
+    {
+        OverheadSource source;                         // 开销来源
+        bool active = true;                            // 是否计时
+        TimeStamp start = active ? ns_from_start() : 0; // 进入作用域的时间
+
+        ~OverheadScope()
+        {
+            if (active)
+            {
+                record_overhead(source, start);
+            }
+        }
+    };
+
+    /**
+     * @brief 写入插件开销报告
+     *
+     * 输出"gperf overhead"计数器轨道（每个来源的累计开销，毫秒），
+     * 并在顶层"metadata"中输出汇总：每个来源的调用次数和总耗时、
+     * 总开销及其占整个编译单元时间的比例。
+     *
+     * @note 由write_all_events在事件构造完成后、JSON序列化之前调用，
+     *       序列化本身的耗时无法写入同一个文件
+     */
+    void write_overhead_report();
+
+    // ==================== LTO追踪接口组 ====================
+
+    /**
+     * @brief 设置LTO编译单元信息
+     *
+     * 插件在lto1中运行时，由插件初始化时根据-fwpa/-fltrans选项
+     * 和LTRANS输入文件名确定运行模式、LTO运行标识和分区编号。
+     *
+     * @param unit LTO编译单元信息（普通编译时mode为LtoMode::NONE）
+     * @note 由plugin_init调用，必须在setup_output之前调用（输出文件名依赖分区编号）
+     */
+    void set_lto_unit(LtoUnit unit);
+
+    /**
+     * @brief 获取LTO编译单元信息
+     *
+     * @return 当前进程的LTO编译单元信息
+     */
+    const LtoUnit& lto_unit();
+
+    /**
+     * @brief lto1进程的名称
+     *
+     * trace的process_name元数据和实时状态的编译单元名称使用这个名称。
+     *
+     * @return lto1-wpa <run>或lto1-ltrans <run> #N
+     */
+    std::string lto_process_name();
+
+    /**
+     * @brief 记录本进程处理的符号
+     *
+     * WPA记录全部定义的符号，LTRANS只记录属于本分区的符号
+     * （其他分区的符号只有声明，不在本进程生成代码）。
+     *
+     * @param functions 函数（tree节点）；报告只列出前1000个函数的名称（在此格式化），其余只计数
+     * @param variable_count 变量数量
+     * @note 由cb_pass_execution在lto1的第一个pass开始时调用（此时符号表已读入）
+     */
+    void record_partition_symbols(std::vector<const void*> functions, int variable_count);
+
+    /**
+     * @brief 记录WPA划分出的LTRANS分区
+     *
+     * @param files LTRANS输入文件（按分区编号排列，来自-fltrans-output-list）
+     * @note 由cb_plugin_finish在WPA写出分区之后调用
+     */
+    void record_ltrans_partitions(std::vector<std::string> files);
+
+    /**
+     * @brief 写入LTO报告
+     *
+     * 在lto1中运行时，输出顶层键"lto"：模式、LTO运行标识、分区编号、
+     * 本进程的符号数量和函数列表（WPA还包括分区文件列表）；
+     * 并设置Chrome Tracing的进程名称和排序，合并多个trace时WPA排在
+     * 所属的LTRANS分区之前。普通编译时不输出。
+     *
+     * @note 由write_all_events统一调用
+     */
+    void write_lto_report();
+
+    /**
+     * @brief 结束并写入最后一个优化pass事件
+     *
+     * pass事件在每个pass结束时（下一个pass开始时）即流式写入，
+     * 写入器的后台线程在编译过程中落盘；编译结束时只剩最后一个pass需要结束和写入。
      * 输出内容：
      * 1. pass名称
      * 2. pass类型（GIMPLE_PASS, RTL_PASS等）
@@ -109,11 +357,32 @@ namespace GccTrace
      * - SIMPLE_IPA_PASS: 简单过程间分析
      * - IPA_PASS: 完整过程间分析
      *
-     * @note 由write_all_events统一调用
-     * @note 遍历pass_events向量生成事件
+     * @note 由write_all_events在TU事件之前调用（保证TU包含最后一个pass）
      */
     void write_opt_pass_events();
 
+    /**
+     * @brief 写入前端事件（已结束预处理的文件、声明解析、作用域事件和scopeRollup报告）
+     *
+     * 前端结束后这些事件不再变化，提前写入使编译在优化阶段中途退出时trace中已有前端的数据。
+     * 主文件直到编译结束才结束预处理，由write_preprocessing_events写入。
+     *
+     * @note 由cb_all_ipa_passes_start在resolve_deferred_names之后调用，
+     *       write_all_events再调用一次兜底（只写入一次）
+     */
+    void write_frontend_events();
+
+    /**
+     * @brief 编译异常结束时写入已收集的事件
+     *
+     * 结束正在执行的pass和仍在包含栈中的文件（结束于此刻），写入前端事件和函数事件。
+     * 名称尚未格式化（前端中途退出）时只写入声明解析事件，不再访问可能已损坏的tree。
+     * pass事件只使用已缓存的函数名称，GCC出错时正在处理的函数名称未缓存时省略function参数。
+     *
+     * @note 由atexit回调调用（write_all_events未执行时）
+     */
+    void write_incomplete_events();
+
 } // namespace GccTrace
 
 // ==================== 模块设计说明 ====================
@@ -127,10 +396,17 @@ namespace GccTrace
  *    路径系统：文件名规范化（绝对路径→相对包含路径）
  *
  * 二、优化pass追踪系统：
- *    当前pass：OptPassEvent last_pass
+ *    当前pass：OptPassEvent last_pass（包含pass处理的函数）
  *    历史记录：std::vector<OptPassEvent> pass_events
+ *    采样：PassSampling sampling（按函数哈希采样1/N，事件总数上限）
+ *    代码大小：map_t<const void*, CodeSize> code_sizes（final时的RTL指令数和汇编字节数）
+ *    内联决策：std::vector<InlineRecord> inline_records（einline/inline之后遍历调用图）
  *    pass类型转换：pass_type函数（GCC类型→EventCategory）
  *
+ * 三、LTO追踪系统：
+ *    编译单元：LtoUnit lto（WPA/LTRANS模式、LTO运行标识、分区编号）
+ *    分区符号：partition_functions、partition_variable_count、ltrans_files
+ *
  * 数据流：
  *    GCC回调 → tracking接口 → 内部存储 → 输出时转换为TraceEvent
  *
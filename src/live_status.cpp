@@ -0,0 +1,170 @@
+// GCC性能追踪插件的实时状态模块
+// 状态记录放在POSIX共享内存中，更新时用顺序锁保护，gperf-top只读映射后读取
+
+#include "live_status.h"  // 包含实时状态接口声明，提供实现
+
+#include <atomic>         // atomic_ref、内存屏障（顺序锁）
+#include <cerrno>         // errno
+#include <cstdio>         // fprintf、snprintf
+#include <cstring>        // memcpy、strnlen、strerror
+#include <fcntl.h>        // O_CREAT等打开标志
+#include <sys/mman.h>     // shm_open、mmap
+#include <unistd.h>       // getpid、ftruncate、close
+
+namespace GccTrace
+{
+    namespace // 匿名命名空间，限制符号只在当前文件可见
+    {
+        LiveStatus* status = nullptr;  // 映射的状态记录（未启用或创建失败时为nullptr）
+        char shm_name[32];             // 共享内存对象名称（/gperf-<pid>）
+
+        // 复制字符串到定长字段，超长时截断
+        template <size_t N>
+        void copy_field(char (&field)[N], const char* text)
+        {
+            size_t length = text ? strnlen(text, N - 1) : 0;
+            memcpy(field, text ? text : "", length);
+            field[length] = '\0';
+        }
+
+        // 顺序锁：写入前把sequence变为奇数，写入后变为偶数
+        // 只有写入方修改sequence，不需要原子的读-改-写
+        void begin_update()
+        {
+            std::atomic_ref<uint32_t> sequence{status->sequence};
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void end_update()
+        {
+            std::atomic_ref<uint32_t> sequence{status->sequence};
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }  // 匿名命名空间结束
+
+    // 创建当前进程的状态共享内存
+    // 参数：start_unix_ns - 编译开始的绝对时间（纳秒）
+    bool open_live_status(int64_t start_unix_ns)
+    {
+        snprintf(shm_name, sizeof(shm_name), "/%s%d", LIVE_STATUS_PREFIX, static_cast<int>(getpid()));
+
+        // 同名对象只可能是进程号复用前被SIGKILL的编译残留的，直接覆盖
+        int fd = shm_open(shm_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd == -1)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't create shared memory %s: %s\n", shm_name, strerror(errno));
+            return false;
+        }
+        if (ftruncate(fd, sizeof(LiveStatus)) == -1)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't resize shared memory %s: %s\n", shm_name, strerror(errno));
+            close(fd);
+            shm_unlink(shm_name);
+            return false;
+        }
+        void* memory = mmap(nullptr, sizeof(LiveStatus), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't map shared memory %s: %s\n", shm_name, strerror(errno));
+            shm_unlink(shm_name);
+            return false;
+        }
+
+        // ftruncate得到的内容全为0（sequence为偶数，字符串为空），最后写入magic表示记录有效
+        status = static_cast<LiveStatus*>(memory);
+        begin_update();
+        status->version = LIVE_STATUS_VERSION;
+        status->pid = static_cast<int32_t>(getpid());
+        status->start_unix_ns = start_unix_ns;
+        status->phase = LivePhase::STARTING;
+        status->magic = LIVE_STATUS_MAGIC;
+        end_update();
+        return true;
+    }
+
+    // 删除当前进程的状态共享内存
+    void close_live_status()
+    {
+        // LTO WPA流式输出分区的子进程继承了映射，共享内存属于父进程
+        if (!status || status->pid != getpid())
+        {
+            return;
+        }
+        shm_unlink(shm_name);
+        munmap(status, sizeof(LiveStatus));
+        status = nullptr;
+    }
+
+    // 是否已启用实时状态
+    bool live_status_enabled()
+    {
+        return status != nullptr;
+    }
+
+    // 设置编译单元名称
+    void live_status_unit(const char* name)
+    {
+        if (!status)
+        {
+            return;
+        }
+        begin_update();
+        copy_field(status->unit, name);
+        end_update();
+    }
+
+    // 设置当前阶段
+    void live_status_phase(LivePhase phase)
+    {
+        if (!status)
+        {
+            return;
+        }
+        begin_update();
+        status->phase = phase;
+        end_update();
+    }
+
+    // 记录开始执行的pass
+    void live_status_pass(const char* name, LivePhase phase, int64_t start_ns)
+    {
+        if (!status)
+        {
+            return;
+        }
+        begin_update();
+        status->phase = phase;
+        status->pass_start_ns = start_ns;
+        status->include_depth = 0;
+        copy_field(status->pass, name);
+        end_update();
+    }
+
+    // 记录当前pass处理的函数
+    void live_status_function(const char* name)
+    {
+        if (!status)
+        {
+            return;
+        }
+        begin_update();
+        copy_field(status->function, name);
+        end_update();
+    }
+
+    // 记录包含栈顶
+    void live_status_include(const char* file, int depth)
+    {
+        if (!status)
+        {
+            return;
+        }
+        begin_update();
+        status->phase = LivePhase::PARSE;
+        status->include_depth = depth;
+        copy_field(status->file, file);
+        end_update();
+    }
+}
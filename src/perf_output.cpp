@@ -2,117 +2,592 @@
 // 负责将收集到的编译事件转换为Chrome Tracing格式的JSON文件
 
 #include "perf_output.h"     // 包含JSON输出接口声明，提供函数实现
+#include "trace_writer.h"    // 事件的流式JSON序列化（不依赖GCC）
+#include "trace_compression.h" // 压缩流的同步刷新（flush_trace_stream）
+#include "live_status.h"     // 编译结束时删除实时状态
 #include <gcc-plugin.h>      // 插件初始化、回调注册、GCC内部API
 #include <plugin-version.h>  // GCC版本信息，用于条件编译处理API差异
+#include <pthread.h>         // fork前刷新输出（pthread_atfork）
+#include <signal.h>          // 终止信号处理（sigaction、raise）
 #include <sys/types.h>       // 系统类型定义（如pid_t、size_t等）
 #include <unistd.h>          // Unix标准函数（getpid、close、write等）
 
 namespace GccTrace
 {
-    // 最小事件长度常量：1毫秒（1000000纳秒）
-    // 用于过滤过短的编译事件，避免生成过于庞大的追踪文件
+    // 默认最小事件长度：1毫秒（1000000纳秒）
+    // 用于过滤过短的编译事件，避免生成过于庞大的追踪文件（可按类别通过插件参数调整）
     constexpr int MINIMUM_EVENT_LENGTH_NS = 1000000;  // 1ms
 
+    // 编译过程中把已写入的事件刷到文件的最小间隔：1秒
+    // 编译被终止（SIGKILL）时最多丢失这段时间内的事件
+    constexpr TimeStamp OUTPUT_FLUSH_INTERVAL_NS = 1000000000;  // 1s
+
     namespace // 匿名命名空间，限制符号只在当前文件可见
     {
-        // JSON输出系统的全局状态变量
-        json::object* output_json;            // JSON根对象指针
-        json::array* output_events_list;      // 事件数组指针（快速访问）
+        // 输出系统的全局状态变量
+        int pid = getpid();                   // 编译进程ID
+        TraceWriter* writer;                  // 事件流式写入器
         static std::FILE* trace_file;         // 输出文件句柄（static限制作用域）
 
-        // 将EventCategory枚举转换为对应的字符串表示
-        // 用于JSON输出中的"cat"字段
-        const char* category_string(EventCategory cat)
-        {
-            // 静态字符串数组，避免每次调用都重新构造
-            static const char* strings[10] = {
-                "TU",                  // Translation Unit（整个编译单元）
-                "PREPROCESS",          // 预处理阶段
-                "FUNCTION",            // 函数解析
-                "STRUCT",              // 结构体/类定义
-                "NAMESPACE",           // 命名空间
-                "GIMPLE_PASS",         // GIMPLE中间表示优化pass
-                "RTL_PASS",            // RTL（寄存器传输级）优化pass
-                "SIMPLE_IPA_PASS",     // 简单过程间分析pass
-                "IPA_PASS",            // 完整过程间分析pass
-                "UNKNOWN"              // 未知类型
+        // 附加报告：在所有事件之后按添加顺序写入根对象
+        std::vector<std::pair<std::string, json::value*>> reports;
+
+        // 上次把事件刷到文件的时间（纳秒）
+        TimeStamp last_flush_ns = 0;
+
+        // pass边界是否按间隔刷新（发送到gperfd时不刷新：等待gperfd读取会阻塞编译线程）
+        bool periodic_flush_enabled = true;
+
+        // 是否已开始结束输出（正常结束或异常结束），atexit据此避免重复关闭trace
+        volatile sig_atomic_t output_closing = 0;
+
+        // 记录的终止信号及其名称
+        // 信号处理中不写trace（见on_fatal_signal），只记录信号；编译线程在下一个检查点
+        // （pass边界、文件切换、刷新输出）调用check_fatal_signal关闭trace后重新发送信号
+        // SIGSEGV等崩溃信号由GCC处理为内部编译器错误后exit，由atexit关闭trace
+        struct FatalSignal
+        {
+            int signal;                   // 信号值
+            const char* name;             // 信号名称
+            struct sigaction previous;    // 安装前的处理方式（关闭trace后恢复并重新发送信号）
+        };
+        FatalSignal fatal_signals[] = {
+            {SIGTERM, "SIGTERM", {}},     // 构建超时、kill
+            {SIGINT, "SIGINT", {}},       // Ctrl-C
+            {SIGHUP, "SIGHUP", {}},       // 终端关闭
+            {SIGQUIT, "SIGQUIT", {}},     // 终端退出键（Ctrl-\）
+            {SIGXCPU, "SIGXCPU", {}}      // 超过CPU时间限制（ulimit -t）
+        };
+        constexpr int FATAL_SIGNAL_COUNT = sizeof(fatal_signals) / sizeof(fatal_signals[0]);
+
+        // 收到的终止信号在fatal_signals中的下标（-1表示没有）
+        volatile sig_atomic_t received_signal = -1;
+
+        // 短于阈值被丢弃的事件的汇总（"other"聚合）
+        struct OtherAggregate
+        {
+            int64_t count = 0;        // 事件数量
+            TimeStamp total_ns = 0;   // 总时间（纳秒）
+        };
+
+        // 每个类别的阈值和输出统计：输出的事件与"other"聚合合计覆盖该类别的全部时间
+        struct CategoryStats
+        {
+            TimeStamp threshold = MINIMUM_EVENT_LENGTH_NS;  // 最小事件长度（纳秒）
+            int64_t emitted_count = 0;                      // 输出的事件数量
+            TimeStamp emitted_ns = 0;                       // 输出的事件总时间
+            OtherAggregate other;                           // 被丢弃事件的汇总
+            map_t<std::string, OtherAggregate> other_files; // 被丢弃事件按文件汇总
+        };
+        CategoryStats category_stats[EVENT_CATEGORY_COUNT];
+
+        // 摘要中每个列表（头文件、函数、pass）保留的条目数
+        constexpr size_t SUMMARY_TOP_COUNT = 10;
+
+        // 摘要条目：名称、次数和总时间
+        struct SummaryEntry
+        {
+            std::string name;
+            int64_t count = 0;
+            TimeStamp total_ns = 0;
+        };
+
+        // 编译单元摘要：在add_event中随事件输出累计，编译结束时写入summary报告和侧车文件
+        struct TraceSummary
+        {
+            std::string unit;                            // 进程名称（lto1）
+            std::string main_file;                       // 主源文件（不计入头文件）
+            TimeStamp tu_ns = 0;                         // TU总时间
+            TimeStamp frontend_end = -1;                 // 前端结束（IPA开始）的时间，-1表示未到达
+            TimeStamp passes_before_frontend_end = 0;    // 前端结束前已记录的pass时间（函数降级pass）
+            std::vector<SummaryEntry> headers;           // 最长的头文件预处理事件
+            std::vector<SummaryEntry> functions;         // 解析最慢的函数
+            map_t<std::string, SummaryEntry> passes;     // pass名称 -> 所有函数上的合计（不填name）
+            std::string file;                            // 侧车文件路径（为空表示不写入）
+        };
+        TraceSummary summary;
+
+        // 把条目插入按总时间降序排列的列表，只保留前count个
+        void keep_top(std::vector<SummaryEntry>& list, SummaryEntry entry, size_t count)
+        {
+            if (list.size() >= count && list.back().total_ns >= entry.total_ns)
+            {
+                return;
+            }
+            list.push_back(std::move(entry));
+            for (size_t i = list.size() - 1; i > 0 && list[i - 1].total_ns < list[i].total_ns; i--)
+            {
+                std::swap(list[i - 1], list[i]);
+            }
+            if (list.size() > count)
+            {
+                list.pop_back();
+            }
+        }
+
+        // 所有pass类别的时间（含短于阈值被丢弃的事件）
+        TimeStamp pass_ns()
+        {
+            TimeStamp total = 0;
+            for (EventCategory category : {SIMPLE_IPA_PASS, IPA_PASS, GIMPLE_PASS, RTL_PASS})
+            {
+                total += category_stats[category].emitted_ns + category_stats[category].other.total_ns;
+            }
+            return total;
+        }
+
+        // 把一个输出的事件计入摘要
+        void add_to_summary(const TraceEvent& event)
+        {
+            TimeStamp ns = event.ts.end - event.ts.start;
+            switch (event.category)
+            {
+                case EventCategory::PREPROCESS:
+                    if (summary.main_file != event.name)
+                    {
+                        keep_top(summary.headers, SummaryEntry{event.name, 1, ns}, SUMMARY_TOP_COUNT);
+                    }
+                    break;
+                case EventCategory::FUNCTION:
+                    keep_top(summary.functions, SummaryEntry{event.name, 1, ns}, SUMMARY_TOP_COUNT);
+                    break;
+                case EventCategory::GIMPLE_PASS:
+                case EventCategory::RTL_PASS:
+                case EventCategory::SIMPLE_IPA_PASS:
+                case EventCategory::IPA_PASS:
+                {
+                    SummaryEntry& entry = summary.passes[event.name];
+                    entry.count++;
+                    entry.total_ns += ns;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        // 摘要条目列表转换为JSON数组
+        json::array* summary_list(const std::vector<SummaryEntry>& list)
+        {
+            json::array* array = new json::array();
+            for (size_t i = 0; i < list.size(); i++)
+            {
+                json::object* entry = new json::object();
+                entry->set("name", new json::string(list[i].name.data()));
+                entry->set("count", new json::integer_number(list[i].count));
+                entry->set("total_ns", new json::integer_number(list[i].total_ns));
+                array->append(entry);
+            }
+            return array;
+        }
+
+        void dump_json(const json::value* value, std::FILE* file);
+
+        // 输出编译单元摘要：固定结构，大小与翻译单元规模无关（几KB）
+        // 阶段时间包括短于阈值被丢弃的事件，各阶段与other_ns合计为TU总时间；
+        // 头文件时间包括嵌套包含的头文件
+        // 参数：incomplete - 编译异常结束的原因（正常结束为nullptr）
+        void write_summary(const char* incomplete)
+        {
+            json::object* report = new json::object();
+            report->set("version", new json::integer_number(1));
+            const std::string& unit = summary.unit.empty() ? summary.main_file : summary.unit;
+            if (!unit.empty())
+            {
+                report->set("unit", new json::string(unit.data()));
+            }
+            if (incomplete)
+            {
+                report->set("incomplete", new json::string(incomplete));
+            }
+            report->set("tu_ns", new json::integer_number(summary.tu_ns));
+
+            // 阶段：前端为编译开始到IPA开始（未到达时为整个编译，如-fsyntax-only或前端出错），
+            // 减去其间执行的函数降级pass；优化阶段为各pass类别（含被丢弃的事件）的合计
+            auto category_ns = [](EventCategory category) {
+                return category_stats[category].emitted_ns + category_stats[category].other.total_ns;
             };
-            return strings[(int)cat];  // 通过枚举值索引获取字符串
-        }
-
-        // 创建单个JSON事件对象
-        // 参数说明：
-        // - event: 原始追踪事件数据
-        // - pid: 进程ID（编译进程）
-        // - tid: 线程ID（单线程编译固定为0）
-        // - ts: 时间戳（纳秒）
-        // - phase: 事件阶段（"B"开始或"E"结束）
-        // - this_uid: 事件唯一标识符，用于配对开始和结束事件
-        json::object* new_event(const TraceEvent& event, int pid, int tid, TimeStamp ts,
-            const char* phase, int this_uid)
-        {
-            // 创建JSON对象
-            json::object* json_event = new json::object;
-
-            // 设置事件基本属性
-            json_event->set("name", new json::string(event.name));                      // 事件名称
-            json_event->set("ph", new json::string(phase));                             // 阶段："B"或"E"
-            json_event->set("cat", new json::string(category_string(event.category)));  // 事件类别
-
-            // 时间戳转换：纳秒 → 微秒（Chrome Tracing标准格式）
-            // 乘以0.001L将纳秒转换为微秒，使用long double保证精度
-            json_event->set("ts",
-                new json::float_number(static_cast<double>(ts) * 0.001L));
-
-            // 进程和线程标识
-            json_event->set("pid", new json::integer_number(pid));  // 进程ID
-            json_event->set("tid", new json::integer_number(tid));  // 线程ID（固定为0）
-
-            // 创建参数对象
-            json::object* args = new json::object();
-            args->set("UID", new json::integer_number(this_uid));  // 唯一标识符，用于事件配对
-
-            // 如果事件有额外参数，将它们添加到args对象
+            TimeStamp frontend_ns = summary.frontend_end >= 0 ?
+                summary.frontend_end - summary.passes_before_frontend_end : summary.tu_ns - pass_ns();
+            TimeStamp other_ns = summary.tu_ns - frontend_ns - pass_ns();
+            json::object* phases = new json::object();
+            phases->set("frontend_ns", new json::integer_number(frontend_ns));
+            phases->set("ipa_ns", new json::integer_number(category_ns(SIMPLE_IPA_PASS) + category_ns(IPA_PASS)));
+            phases->set("gimple_ns", new json::integer_number(category_ns(GIMPLE_PASS)));
+            phases->set("rtl_ns", new json::integer_number(category_ns(RTL_PASS)));
+            phases->set("other_ns", new json::integer_number(other_ns > 0 ? other_ns : 0));
+            report->set("phases", phases);
+
+            // 各类别的事件数，以及短于阈值被丢弃的事件数和总时间
+            json::object* categories = new json::object();
+            for (int i = 0; i < EVENT_CATEGORY_COUNT; i++)
+            {
+                const CategoryStats& stats = category_stats[i];
+                if (!stats.emitted_count && !stats.other.count)
+                {
+                    continue;
+                }
+                json::object* entry = new json::object();
+                entry->set("count", new json::integer_number(stats.emitted_count));
+                entry->set("total_ns", new json::integer_number(stats.emitted_ns));
+                entry->set("other_count", new json::integer_number(stats.other.count));
+                entry->set("other_ns", new json::integer_number(stats.other.total_ns));
+                categories->set(category_string(static_cast<EventCategory>(i)), entry);
+            }
+            report->set("categories", categories);
+
+            std::vector<SummaryEntry> passes;
+            for (const auto& [name, entry] : summary.passes)
+            {
+                keep_top(passes, SummaryEntry{name, entry.count, entry.total_ns}, SUMMARY_TOP_COUNT);
+            }
+            report->set("headers", summary_list(summary.headers));
+            report->set("functions", summary_list(summary.functions));
+            report->set("passes", summary_list(passes));
+
+            // 侧车文件：与summary报告内容相同
+            if (!summary.file.empty())
+            {
+                if (std::FILE* file = fopen(summary.file.data(), "w"))
+                {
+                    dump_json(report, file);
+                    fputc('\n', file);
+                    fclose(file);
+                }
+                else
+                {
+                    fprintf(stderr, "GPERF Error! Couldn't open %s for writing\n", summary.file.data());
+                }
+            }
+            add_report("summary", report);
+        }
+
+        // 事件所属的文件：预处理事件的名称即文件名，其他事件取"file"参数
+        const char* event_file(const TraceEvent& event)
+        {
+            if (event.category == EventCategory::PREPROCESS)
+            {
+                return event.name;
+            }
             if (event.args)
             {
-                // C++17结构化绑定遍历键值对
-                for (auto& [key, value] : *event.args)
+                if (auto file = event.args->find("file"); file != event.args->end())
+                {
+                    return file->second.data();
+                }
+            }
+            return nullptr;
+        }
+
+        // 输出各类别的阈值、输出统计和"other"聚合
+        void write_threshold_report()
+        {
+            json::object* report = new json::object();
+            for (int i = 0; i < EVENT_CATEGORY_COUNT; i++)
+            {
+                const CategoryStats& stats = category_stats[i];
+                if (!stats.emitted_count && !stats.other.count)
+                {
+                    continue;
+                }
+
+                json::object* entry = new json::object();
+                entry->set("threshold_ns", new json::integer_number(stats.threshold));
+                entry->set("emitted_count", new json::integer_number(stats.emitted_count));
+                entry->set("emitted_ns", new json::integer_number(stats.emitted_ns));
+                entry->set("other_count", new json::integer_number(stats.other.count));
+                entry->set("other_ns", new json::integer_number(stats.other.total_ns));
+
+                json::object* files = new json::object();
+                for (const auto& [file, aggregate] : stats.other_files)
+                {
+                    json::object* file_entry = new json::object();
+                    file_entry->set("count", new json::integer_number(aggregate.count));
+                    file_entry->set("total_ns", new json::integer_number(aggregate.total_ns));
+                    files->set(file.data(), file_entry);
+                }
+                entry->set("other_files", files);
+
+                report->set(category_string(static_cast<EventCategory>(i)), entry);
+            }
+            add_report("belowThreshold", report);
+        }
+
+        // 把GCC JSON值序列化到文件（处理GCC版本兼容性）
+        void dump_json(const json::value* value, std::FILE* file)
+        {
+#if GCCPLUGIN_VERSION_MAJOR >= 14
+            // GCC 14及以上版本：支持格式化参数
+            value->dump(file, /*formatted=*/false);  // 不格式化，减小文件大小
+#else
+            // GCC 13及以下版本：简化API
+            value->dump(file);
+#endif
+        }
+
+        // 结束事件数组，写入附加报告，关闭输出文件
+        void close_output()
+        {
+            // 依次写入附加报告（GCC JSON值直接序列化到文件）
+            for (auto& [key, report] : reports)
+            {
+                writer->begin_key(key.data());
+                writer->sync();  // 后台线程写完之前的事件后再直接写入文件
+                dump_json(report, trace_file);
+                delete report;
+            }
+            reports.clear();
+            writer->end();
+
+            // 关闭输出文件（压缩输出在此写入压缩流结尾）
+            fclose(trace_file);
+
+            // 编译已结束，gperf-top不再显示
+            close_live_status();
+
+            // 清理内存资源
+            delete writer;
+            writer = nullptr;
+        }
+
+        // 编译异常结束（致命错误、内部编译器错误后exit）时关闭trace：
+        // 写入已收集且不需要再访问GCC数据结构的事件，TU事件结束于此刻，
+        // 并记录incomplete报告，使trace仍是完整的JSON文件
+        // 只在普通上下文（atexit）中调用，不在信号处理中调用
+        void finish_incomplete_trace(const char* reason)
+        {
+            // 已正常结束，或在LTO WPA流式输出分区的子进程中（trace属于父进程）
+            if (output_closing || !writer || getpid() != pid)
+            {
+                return;
+            }
+            output_closing = 1;
+
+            TimeStamp now = ns_from_start();
+            write_incomplete_events();
+
+            map_t<std::string, std::string> args;
+            args["incomplete"] = reason;
+            add_event(TraceEvent{"TU", EventCategory::TU, {0, now}, std::move(args)});
+            write_threshold_report();
+            write_summary(reason);
+
+            json::object* incomplete = new json::object();
+            incomplete->set("reason", new json::string(reason));
+            incomplete->set("end_ns", new json::integer_number(now));
+            add_report("incomplete", incomplete);
+
+            close_output();
+        }
+
+        // 恢复收到的终止信号原来的处理方式并重新发送信号（默认处理方式下进程在此结束）
+        void raise_received_signal()
+        {
+            int index = received_signal;
+            if (index >= 0)
+            {
+                sigaction(fatal_signals[index].signal, &fatal_signals[index].previous, nullptr);
+                raise(fatal_signals[index].signal);
+            }
+        }
+
+        // atexit回调：GCC在致命错误和内部编译器错误后调用exit，不触发PLUGIN_FINISH
+        // 信号在最后一个检查点之后到达时，trace已由正常或异常结束的路径关闭，
+        // 仍重新发送信号，使进程像未加载插件时一样被信号终止
+        void finish_trace_at_exit()
+        {
+            int index = received_signal;
+            finish_incomplete_trace(index >= 0 ? fatal_signals[index].name : "exit");
+            raise_received_signal();
+        }
+
+        // 终止信号处理：只记录信号，由编译线程在下一个检查点关闭trace（check_fatal_signal）
+        // 只调用异步信号安全的函数：信号可能在编译线程持有malloc或写入器的锁、
+        // 或正在向缓冲区追加事件时到达，在此写trace会死锁（构建超时的SIGTERM无法结束编译）或写坏文件
+        // 已有信号等待处理时（编译长时间没有到达检查点）再次收到信号，不再等待，立即按原处理方式结束
+        void on_fatal_signal(int signal)
+        {
+            if (received_signal >= 0)
+            {
+                raise_received_signal();
+                return;
+            }
+            for (int i = 0; i < FATAL_SIGNAL_COUNT; i++)
+            {
+                if (fatal_signals[i].signal == signal)
                 {
-                    args->set(key.data(), new json::string(value.data()));
+                    received_signal = i;
+                    break;
                 }
             }
+        }
+
+        // fork前把已写入的事件刷到文件：LTO WPA用fork的子进程写出分区，子进程exit时
+        // glibc会刷新继承的所有stdio流，缓冲区中的数据（包括压缩流和gperfd套接字）会被写入两次
+        void flush_before_fork()
+        {
+            if (writer && !output_closing && getpid() == pid)
+            {
+                writer->sync();
+                flush_trace_stream(trace_file);
+            }
+        }
 
-            json_event->set("args", args);  // 将参数对象附加到事件
-            return json_event;              // 返回构建好的JSON事件对象
+        // 安装atexit回调、fork前的刷新和终止信号处理
+        void install_exit_handlers()
+        {
+            atexit(finish_trace_at_exit);
+            pthread_atfork(flush_before_fork, nullptr, nullptr);
+
+            struct sigaction action = {};
+            action.sa_handler = on_fatal_signal;
+            sigemptyset(&action.sa_mask);
+            for (FatalSignal& fatal : fatal_signals)
+            {
+                sigaction(fatal.signal, nullptr, &fatal.previous);
+                if (fatal.previous.sa_handler == SIG_IGN)
+                {
+                    continue;  // 保持被忽略的信号（如nohup下的SIGHUP）
+                }
+                sigaction(fatal.signal, &action, nullptr);
+            }
         }
 
     }  // 匿名命名空间结束
 
     // 初始化输出文件系统
-    // 参数：file - 已打开的文件句柄
-    void init_output_file(FILE* file)
+    // 参数：
+    //   file           - 已打开的文件句柄
+    //   periodic_flush - pass边界是否按间隔刷新
+    void init_output_file(FILE* file, bool periodic_flush)
     {
         trace_file = file;  // 保存文件句柄
+        periodic_flush_enabled = periodic_flush;
 
-        // 创建JSON根对象
-        output_json = new json::object();
+        // TU事件总是输出（不受最小事件长度限制）：工具从它得到翻译单元的时间跨度
+        category_stats[EventCategory::TU].threshold = 0;
 
-        // 设置Chrome Tracing格式的元数据
-        output_json->set("displayTimeUnit", new json::string("ns"));  // 显示时间单位为纳秒
+        // 创建写入器：事件在add_event时直接序列化，不构造JSON对象树
+        // 写满的缓冲区由后台线程写入文件（包括压缩），编译过程中流式输出的事件不阻塞编译
+        writer = new TraceWriter(file, 1 << 20, /*background_writer=*/true);
 
-        // beginningOfTime: 时间原点（编译开始的绝对时间）
-        // 转换为微秒精度的时间戳
-        output_json->set("beginningOfTime",
-            new json::integer_number(
-                std::chrono::duration_cast<std::chrono::microseconds>(
-                    COMPILATION_START.time_since_epoch())  // 获取从纪元开始的时间间隔
-                .count()));  // 转换为微秒计数
+        // 写入Chrome Tracing格式的元数据和事件数组开头
+        // beginningOfTime: 时间原点（编译开始的绝对时间，微秒）
+        writer->begin(std::chrono::duration_cast<std::chrono::microseconds>(
+            COMPILATION_START.time_since_epoch()).count());
 
-        // 创建事件数组容器
-        output_json->set("traceEvents", new json::array());
+        // 编译异常结束时也关闭trace
+        install_exit_handlers();
+    }
+
+    // 设置摘要侧车文件
+    // 参数：path - 摘要文件路径
+    void set_summary_file(const std::string& path)
+    {
+        summary.file = path;
+    }
+
+    // 设置摘要中的主源文件
+    // 参数：file_name - 主源文件（与其预处理事件的名称相同）
+    void set_summary_main_file(const char* file_name)
+    {
+        summary.main_file = file_name;
+    }
 
-        // 获取事件数组的指针，便于后续快速添加事件
-        output_events_list = (json::array*)output_json->get("traceEvents");
+    // 记录前端结束（IPA开始）的时间
+    void set_summary_frontend_end()
+    {
+        summary.frontend_end = ns_from_start();
+        summary.passes_before_frontend_end = pass_ns();
+    }
+
+    // 处理等待中的终止信号：在普通上下文中关闭trace，再按原处理方式重新发送信号
+    void check_fatal_signal()
+    {
+        int index = received_signal;
+        if (index < 0)
+        {
+            return;
+        }
+        finish_incomplete_trace(fatal_signals[index].name);
+        raise_received_signal();
+    }
+
+    // 把已写入的事件刷到文件
+    // 参数：force - 为false时距上次刷新不足OUTPUT_FLUSH_INTERVAL_NS则跳过
+    void flush_output(bool force)
+    {
+        check_fatal_signal();
+
+        TimeStamp now = ns_from_start();
+        if (!writer || (!force && (!periodic_flush_enabled || now - last_flush_ns < OUTPUT_FLUSH_INTERVAL_NS)))
+        {
+            return;
+        }
+        last_flush_ns = now;
+
+        writer->sync();                  // 等待后台线程写完所有事件
+        flush_trace_stream(trace_file);  // 压缩流同步刷新，截断的文件也能解压出这些事件
+    }
+
+    // 设置某一类别的最小事件长度
+    // 参数：
+    //   category     - 事件类别
+    //   threshold_ns - 最小事件长度（纳秒），0表示输出所有事件
+    void set_event_threshold(EventCategory category, TimeStamp threshold_ns)
+    {
+        category_stats[category].threshold = threshold_ns;
+    }
+
+    // 按插件参数中的名称查找事件类别（如"gimple-pass"对应GIMPLE_PASS）
+    // 参数：
+    //   name     - 类别名称
+    //   category - 查找结果
+    bool parse_event_category(const char* name, EventCategory& category)
+    {
+        for (int i = 0; i < EVENT_CATEGORY_COUNT; i++)
+        {
+            const char* expected = category_string(static_cast<EventCategory>(i));
+            size_t j = 0;
+            while (expected[j] && name[j] &&
+                (expected[j] == '_' ? name[j] == '-' : TOLOWER(expected[j]) == name[j]))
+            {
+                j++;
+            }
+            if (!expected[j] && !name[j])
+            {
+                category = static_cast<EventCategory>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 判断事件是否会被输出（未被所属类别的最小事件长度过滤）
+    // 参数：
+    //   category - 事件类别
+    //   ts       - 事件时间跨度
+    bool should_emit_event(EventCategory category, const TimeSpan& ts)
+    {
+        return (ts.end - ts.start) >= category_stats[category].threshold;
+    }
+
+    // 把被丢弃的事件计入所属类别（和文件）的"other"聚合
+    // 参数：
+    //   category - 事件类别
+    //   file     - 事件所属的文件（可为nullptr）
+    //   ts       - 事件时间跨度
+    void record_dropped_event(EventCategory category, const char* file, const TimeSpan& ts)
+    {
+        CategoryStats& stats = category_stats[category];
+        stats.other.count++;
+        stats.other.total_ns += ts.end - ts.start;
+        if (file)
+        {
+            OtherAggregate& aggregate = stats.other_files[file];
+            aggregate.count++;
+            aggregate.total_ns += ts.end - ts.start;
+        }
     }
 
     // 添加单个追踪事件到输出队列
@@ -120,54 +595,101 @@ namespace GccTrace
     void add_event(const TraceEvent& event)
     {
         // 静态变量，只初始化一次
-        static int pid = getpid();  // 获取编译进程ID
         static int tid = 0;         // 线程ID（单线程编译固定为0）
         static int UID = 0;         // 事件唯一标识符计数器
 
-        // 事件长度过滤：跳过短于1ms的事件
-        if ((event.ts.end - event.ts.start) < MINIMUM_EVENT_LENGTH_NS)
+        // TU总时间不受阈值影响
+        if (event.category == EventCategory::TU)
+        {
+            summary.tu_ns = event.ts.end - event.ts.start;
+        }
+
+        // 事件长度过滤：跳过短于类别阈值的事件，只计入"other"聚合
+        if (!should_emit_event(event.category, event.ts))
         {
-            return;  // 事件太短，直接返回
+            record_dropped_event(event.category, event_file(event), event.ts);
+            return;
         }
 
+        CategoryStats& stats = category_stats[event.category];
+        stats.emitted_count++;
+        stats.emitted_ns += event.ts.end - event.ts.start;
+        add_to_summary(event);
+
         // 分配当前事件的唯一标识符
         int this_uid = UID++;
 
         // 为每个事件生成一对JSON记录：开始("B")和结束("E")
-        output_events_list->append(
-            new_event(event, pid, tid, event.ts.start, "B", this_uid));  // 开始事件
-        output_events_list->append(
-            new_event(event, pid, tid, event.ts.end, "E", this_uid));    // 结束事件
+        writer->write_event(event, pid, tid, event.ts.start, "B", this_uid);  // 开始事件
+        writer->write_event(event, pid, tid, event.ts.end, "E", this_uid);    // 结束事件
+    }
+
+    // 添加附加报告到JSON根对象
+    // 参数：
+    //   key    - 报告在根对象中的键名
+    //   report - 报告内容（所有权转移给输出系统）
+    void add_report(const char* key, json::value* report)
+    {
+        reports.emplace_back(key, report);
+    }
+
+    // 添加计数器事件
+    // 参数：
+    //   name   - 计数器（轨道）名称
+    //   ts     - 时间戳（纳秒）
+    //   values - 各曲线的取值
+    void add_counter_event(const char* name, TimeStamp ts, const map_t<std::string, double>& values)
+    {
+        writer->write_counter(name, pid, ts, values);
+    }
+
+    // 设置当前进程在Chrome Tracing中的名称和排序
+    // 参数：
+    //   name       - 进程名称
+    //   sort_index - 进程排序值
+    void set_process_name(const char* name, int sort_index)
+    {
+        summary.unit = name;
+
+        // 元数据事件：{"name": "process_name", "ph": "M", "pid": ..., "args": {"name": ...}}
+        writer->write_process_metadata("process_name", pid, "name", name);
+        writer->write_process_metadata("process_sort_index", pid, "sort_index", sort_index);
     }
 
     // 写入所有追踪事件并完成输出
     // 这是输出模块的主入口函数，在编译结束时调用
     void write_all_events()
     {
-        // 1. 添加整个编译单元（TU）的总时间事件
-        add_event(TraceEvent{"TU", EventCategory::TU, {0, ns_from_start()}, std::nullopt});
+        output_closing = 1;  // 之后的终止信号和exit不再重复关闭trace
 
-        // 2. 按顺序写入所有类型的追踪事件
-        write_preprocessing_events();  // 预处理事件
-        write_opt_pass_events();       // 优化pass事件
-        write_all_functions();         // 函数解析事件
-        write_all_scopes();            // 作用域事件
+        {
+            // 构造事件的耗时计入插件开销
+            OverheadScope overhead{OverheadSource::WRITE_EVENTS};
 
-        // 3. 序列化JSON对象到文件（处理GCC版本兼容性）
-#if GCCPLUGIN_VERSION_MAJOR >= 14
-    // GCC 14及以上版本：支持格式化参数
-        output_json->dump(trace_file, /*formatted=*/false);  // 不格式化，减小文件大小
-#else
-    // GCC 13及以下版本：简化API
-        output_json->dump(trace_file);
-#endif
+            // 0. 格式化会被输出的事件名称（解析阶段只保存了tree节点）
+            resolve_deferred_names();
+
+            // 1. 结束最后一个优化pass（其余pass事件已在编译过程中流式写入），
+            //    添加整个编译单元（TU）的总时间事件
+            write_opt_pass_events();
+            add_event(TraceEvent{"TU", EventCategory::TU, {0, ns_from_start()}, std::nullopt});
 
-        // 4. 关闭输出文件
-        fclose(trace_file);
+            // 2. 按顺序写入其余类型的追踪事件
+            write_preprocessing_events();  // 预处理事件（前端结束时未写入的文件）
+            write_frontend_events();       // 声明解析和作用域事件（通常已在前端结束时写入）
+            write_all_functions();         // 函数解析事件
+            write_function_report();       // 函数解析/优化时间与代码大小报告
+            write_inline_report();         // 内联决策报告
+            write_pass_function_report();  // pass事件处理的函数名称
+            write_sampling_report();       // pass采样与外推报告
+            write_lto_report();            // LTO分区信息（仅lto1）
+            write_threshold_report();      // 各类别阈值和被丢弃事件的汇总
+            write_summary(nullptr);        // 编译单元摘要（summary报告和侧车文件）
+        }
+        write_overhead_report();           // 插件自身开销（计数器轨道和metadata汇总）
 
-        // 5. 清理内存资源
-        output_events_list = nullptr;  // 清空指针（事件数组会被delete output_json一起释放）
-        delete output_json;            // 释放JSON根对象（递归释放所有子对象）
+        // 3. 结束事件数组，写入附加报告，关闭输出文件并清理内存资源
+        close_output();
     }
 
 }  // namespace GccTrace
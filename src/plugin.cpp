@@ -3,85 +3,556 @@
 
 #include "plugin.h"             // 包含插件接口声明，提供回调函数的实现
 #include <options.h>            // GCC编译选项处理和解析
+#include <opts.h>               // 输入文件列表（in_fnames）
+#include <langhooks.h>          // 语言钩子（区分C++前端和lto1）
+#include <demangle.h>           // C++符号反修饰（lto1中格式化函数名称）
 #include <tree-check.h>         // GCC树节点验证和调试工具
 #include <tree-pass.h>          // GCC优化pass定义和管理
 #include <tree.h>               // GCC抽象语法树（AST）核心数据结构定义
+#include <function.h>           // 函数级编译状态（cfun、current_function_decl）
+#include <rtl.h>                // RTL指令表示（NONDEBUG_INSN_P、NEXT_INSN）
+#include <memmodel.h>           // 内存模型定义（emit-rtl.h依赖）
+#include <emit-rtl.h>           // RTL指令序列访问（get_insns）
+#include <output.h>             // 汇编输出（asm_out_file）
+#include <cgraph.h>             // 调用图（cgraph_node、cgraph_edge）
+#include <symbol-summary.h>     // 函数摘要容器（ipa-fnsummary.h依赖）
+#include <tree-vrp.h>           // 值范围（ipa-prop.h依赖）
+#include <ipa-prop.h>           // 过程间传播数据（ipa-fnsummary.h依赖）
+#include <ipa-fnsummary.h>      // 内联器使用的函数大小估计
 #include <cp/cp-tree.h>         // C++特定的树节点类型和操作函数
 #include "c-family/c-pragma.h"  // 预处理指令（#pragma）处理
 #include "cpplib.h"             // C++预处理库核心实现
+#include "trace_compression.h"  // 流式压缩输出（gzip/zstd）
+#include "trace_collector.h"    // 把trace发送到收集守护进程gperfd
+#include "live_status.h"        // 实时状态共享内存（gperf-top）
 
 // GCC插件必须的GPL兼容性声明
 // 值为1表示插件与GPL许可证兼容
 int plugin_is_GPL_compatible = 1;
 
+// C++前端符号弱引用：lto1不链接C++前端，强引用会导致插件在LTO时加载失败
+// lto1中不注册前端回调，这些符号不会被使用
+extern cpp_reader* parse_in __attribute__((weak));
+extern tree cp_global_trees[CPTI_MAX] __attribute__((weak));
+extern const char* decl_as_string(tree, int) __attribute__((weak));
+
 namespace GccTrace
 {
+    namespace // 匿名命名空间，限制符号只在当前文件可见
+    {
+        // 正在执行final pass的函数，以及final开始时汇编文件的写入位置
+        // final本身不触发结束回调，在下一个pass开始时计算输出的汇编字节数
+        tree final_function = nullptr;
+        long final_asm_start = -1;
+
+        // 实时状态中最近一次记录的函数（pass按函数连续执行，函数变化时才复制名称）
+        tree live_function = nullptr;
+
+        // 正在执行的内联pass（einline或inline），在下一个pass开始时遍历调用图
+        const opt_pass* inline_pass = nullptr;
+
+        // 内联pass开始时调用者的快照：估计大小和直接调用边
+        struct InlineSnapshot
+        {
+            int size;                 // 内联器估计的函数大小（-1表示未知）
+            std::vector<std::pair<int, tree>> edges; // 直接调用边的uid和被调用的函数（仅einline使用）
+        };
+        map_t<cgraph_node*, InlineSnapshot> inline_snapshots;
+
+        // 获取内联器估计的函数大小（包含已内联的函数体）
+        int estimated_size(cgraph_node* node)
+        {
+#if GCCPLUGIN_VERSION_MAJOR >= 10
+            ipa_size_summary* summary = ipa_size_summaries ? ipa_size_summaries->get(node) : nullptr;
+#else
+            ipa_fn_summary* summary = ipa_fn_summaries ? ipa_fn_summaries->get(node) : nullptr;
+#endif
+            return summary ? summary->size : -1;
+        }
+
+        // 获取内联副本所属的调用者（非内联副本返回nullptr）
+        cgraph_node* inlined_to(cgraph_node* node)
+        {
+#if GCCPLUGIN_VERSION_MAJOR >= 10
+            return node->inlined_to;
+#else
+            return node->global.inlined_to;
+#endif
+        }
+
+        // 调用边的唯一编号（边对象会被复用，编号不会）
+        int edge_uid(cgraph_edge* edge)
+        {
+#if GCCPLUGIN_VERSION_MAJOR >= 9
+            return edge->get_uid();
+#else
+            return edge->uid;
+#endif
+        }
+
+        // 收集调用者中已决定内联的调用（每个调用点一项，递归包括被内联函数中再内联的调用）
+        void collect_inlined_callees(cgraph_node* node, std::vector<const void*>& callees)
+        {
+            for (cgraph_edge* edge = node->callees; edge; edge = edge->next_callee)
+            {
+                if (!edge->inline_failed)
+                {
+                    callees.push_back(DECL_ORIGIN(edge->callee->decl));
+                    collect_inlined_callees(edge->callee, callees);
+                }
+            }
+        }
+
+        // 内联pass开始：记录调用者的估计大小（einline还记录直接调用的函数）
+        void start_inline_pass(const opt_pass* pass)
+        {
+            inline_pass = pass;
+            inline_snapshots.clear();
+
+            if (!strcmp(pass->name, "einline"))
+            {
+                // 早期内联：逐函数执行，只快照当前函数
+                cgraph_node* node = current_function_decl ? cgraph_node::get(current_function_decl) : nullptr;
+                if (node)
+                {
+                    InlineSnapshot& snapshot = inline_snapshots[node];
+                    snapshot.size = estimated_size(node);
+                    for (cgraph_edge* edge = node->callees; edge; edge = edge->next_callee)
+                    {
+                        snapshot.edges.emplace_back(edge_uid(edge), edge->callee->decl);
+                    }
+                }
+            }
+            else
+            {
+                // 过程间内联：快照所有调用者
+                cgraph_node* node;
+                FOR_EACH_DEFINED_FUNCTION(node)
+                {
+                    if (!inlined_to(node))
+                    {
+                        inline_snapshots[node].size = estimated_size(node);
+                    }
+                }
+            }
+        }
+
+        // 内联pass结束：比较快照得到每个调用者的内联决策
+        void finish_inline_pass()
+        {
+            if (!strcmp(inline_pass->name, "einline"))
+            {
+                // 早期内联立即改写函数体，被内联的调用边随之删除（内联的函数体中的调用是新的边）：
+                // 快照中存在、现在已不存在的调用边即为被内联的调用点
+                // 按边比较而不是按被调用函数比较：同一函数的多个调用点只内联了一部分、
+                // 或内联的函数体又调用了同一函数时，被调用函数仍然存在
+                for (auto& [node, snapshot] : inline_snapshots)
+                {
+                    set_t<int> remaining;
+                    for (cgraph_edge* edge = node->callees; edge; edge = edge->next_callee)
+                    {
+                        remaining.insert(edge_uid(edge));
+                    }
+                    std::vector<const void*> callees;
+                    for (const auto& [uid, callee] : snapshot.edges)
+                    {
+                        if (!remaining.count(uid))
+                        {
+                            callees.push_back(DECL_ORIGIN(callee));
+                        }
+                    }
+                    if (!callees.empty())
+                    {
+                        record_inlining(DECL_ORIGIN(node->decl), std::move(callees),
+                            snapshot.size, estimated_size(node));
+                    }
+                }
+            }
+            else
+            {
+                // 过程间内联只做决策（函数体稍后改写）：被内联的调用边inline_failed为空
+                cgraph_node* node;
+                FOR_EACH_DEFINED_FUNCTION(node)
+                {
+                    if (inlined_to(node))
+                    {
+                        continue;
+                    }
+
+                    std::vector<const void*> callees;
+                    collect_inlined_callees(node, callees);
+                    if (!callees.empty())
+                    {
+                        auto snapshot = inline_snapshots.find(node);
+                        record_inlining(DECL_ORIGIN(node->decl), std::move(callees),
+                            snapshot != inline_snapshots.end() ? snapshot->second.size : -1,
+                            estimated_size(node));
+                    }
+                }
+            }
+
+            inline_pass = nullptr;
+            inline_snapshots.clear();
+        }
+
+        // lto1中是否已记录本进程处理的符号
+        bool partition_symbols_recorded = false;
+
+        // 检测插件是否运行在lto1中，以及LTO运行模式和分区
+        // 插件初始化时选项已解析完成，输入文件列表可用
+        LtoUnit detect_lto_unit()
+        {
+            if (strcmp(lang_hooks.name, "GNU GIMPLE"))
+            {
+                return LtoUnit{LtoMode::NONE, {}, -1};
+            }
+
+            LtoUnit unit{LtoMode::LTO, {}, -1};
+#ifdef flag_wpa
+            if (flag_wpa)
+            {
+                // WPA：LTRANS文件列表为<run>.ltrans.out，分区文件为<run>.ltrans<N>.o
+                unit.mode = LtoMode::WPA;
+#ifdef ltrans_output_list
+                if (ltrans_output_list)
+                {
+                    unit.run = ltrans_output_list;
+                    if (unit.run.ends_with(".ltrans.out"))
+                    {
+                        unit.run.resize(unit.run.size() - strlen(".ltrans.out"));
+                    }
+                }
+#endif
+            }
+#endif
+#ifdef flag_ltrans
+            if (flag_ltrans && num_in_fnames > 0)
+            {
+                // LTRANS：从输入文件<run>.ltrans<N>.o解析运行标识和分区编号
+                unit.mode = LtoMode::LTRANS;
+                unit.run = in_fnames[0];
+                size_t pos = unit.run.rfind(".ltrans");
+                if (pos != std::string::npos)
+                {
+                    unit.partition = atoi(unit.run.data() + pos + strlen(".ltrans"));
+                    unit.run.resize(pos);
+                }
+            }
+#endif
+            return unit;
+        }
+
+        // 记录lto1本进程处理的符号（LTRANS只包括本分区定义的符号）
+        void record_lto_symbols()
+        {
+            std::vector<const void*> functions;
+            int variable_count = 0;
+
+            cgraph_node* node;
+            FOR_EACH_DEFINED_FUNCTION(node)
+            {
+                if (!node->in_other_partition && !inlined_to(node))
+                {
+                    functions.push_back(node->decl);
+                }
+            }
+
+            varpool_node* variable;
+            FOR_EACH_DEFINED_VARIABLE(variable)
+            {
+                if (!variable->in_other_partition)
+                {
+                    variable_count++;
+                }
+            }
+
+            record_partition_symbols(std::move(functions), variable_count);
+        }
+
+        // 已完成定义的最外层类集合（由PLUGIN_FINISH_TYPE记录）
+        // 用于判断成员函数是否在类定义内解析
+        set_t<tree> finished_types;
+
+        // 获取作用域节点对应的作用域ID
+        // 沿完整的上下文链（命名空间、类、嵌套类）由外到内驻留，已驻留的节点直接命中
+        // 作用域名称不在这里格式化，只在作用域会被输出时延迟格式化
+        // 参数：
+        //   context - 作用域tree节点（DECL_CONTEXT或TYPE_CONTEXT）
+        ScopeId scope_id(tree context)
+        {
+            // 全局作用域（翻译单元）
+            if (!context || TREE_CODE(context) == TRANSLATION_UNIT_DECL || context == global_namespace)
+            {
+                return GLOBAL_SCOPE;
+            }
+
+            // 已驻留的作用域
+            if (ScopeId id = find_scope(context))
+            {
+                return id;
+            }
+
+            // 根据GCC树节点类型判断作用域类型，并找到父作用域
+            EventCategory scope_type;
+            tree parent;
+            switch (TREE_CODE(context))
+            {
+                case NAMESPACE_DECL:  // C++命名空间
+                    scope_type = EventCategory::NAMESPACE;
+                    parent = DECL_CONTEXT(context);
+                    break;
+                case RECORD_TYPE:     // 结构体或类
+                case UNION_TYPE:      // 联合体（也归类为STRUCT）
+                    scope_type = EventCategory::STRUCT;
+                    parent = TYPE_CONTEXT(context);
+                    break;
+                case FUNCTION_DECL:   // 局部类所在的函数：函数不是作用域节点，直接跳过
+                    return scope_id(DECL_CONTEXT(context));
+                default:
+                    // 未知的作用域类型，输出警告信息
+                    fprintf(stderr, "Unkown tree code %d\n", TREE_CODE(context));
+                    return GLOBAL_SCOPE;
+            }
+
+            // 先驻留父作用域，再驻留自身
+            ScopeId parent_id = scope_id(parent);
+            return intern_scope(context, parent_id, scope_type);
+        }
+
+        // 判断函数是否在尚未完成的类定义内解析（类内定义的成员函数）
+        // 类内定义的成员函数体在最外层类的右花括号之后、PLUGIN_FINISH_TYPE之前解析
+        bool is_in_class_body(tree decl)
+        {
+            tree context = DECL_CONTEXT(decl);
+            if (!context || !CLASS_TYPE_P(context) || LAMBDA_TYPE_P(context))
+            {
+                return false;
+            }
+
+            // 嵌套类的成员函数与最外层类一起延迟解析
+            while (TYPE_CONTEXT(context) && CLASS_TYPE_P(TYPE_CONTEXT(context)))
+            {
+                context = TYPE_CONTEXT(context);
+            }
+
+            // 模板实例化得到的类不经过类定义解析，其成员函数总在类定义之外
+            if (CLASSTYPE_TEMPLATE_INSTANTIATION(context))
+            {
+                return false;
+            }
+
+            return !finished_types.contains(context);
+        }
+
+        // C++语言相关数据是否已（将）被free_lang_data释放：
+        // 生成LTO字节码的编译中，free_lang_data是PLUGIN_ALL_IPA_PASSES_START之后的第一个IPA pass，
+        // 之后decl_as_string不再可用
+        bool lang_data_freed = false;
+    }  // 匿名命名空间结束
+
+    // 格式化声明或类型的名称（带命名空间和参数类型的完整签名）
+    const char* decl_name(const void* decl)
+    {
+        if (lto_unit().mode == LtoMode::NONE && !lang_data_freed)
+        {
+            return decl_as_string((tree)decl, 0);
+        }
+
+        // lto1没有C++前端，-flto编译中语言数据已被释放：反修饰汇编名称得到带参数类型的签名
+        tree node = (tree)decl;
+        if (HAS_DECL_ASSEMBLER_NAME_P(node) && DECL_ASSEMBLER_NAME_SET_P(node))
+        {
+            const char* mangled = IDENTIFIER_POINTER(DECL_ASSEMBLER_NAME(node));
+            if (*mangled == '*')
+            {
+                mangled++;  // 用户指定的汇编名称（asm("...")）
+            }
+
+            static std::string demangled_name;
+            if (char* demangled = cplus_demangle(mangled, DMGL_PARAMS | DMGL_ANSI))
+            {
+                demangled_name = demangled;
+                free(demangled);
+                return demangled_name.data();
+            }
+            return mangled;
+        }
+        return lang_hooks.decl_printable_name(node, 2);
+    }
+
+    // pass所属的实时状态阶段
+    LivePhase live_phase(const opt_pass* pass)
+    {
+        switch (pass->type)
+        {
+            case opt_pass_type::GIMPLE_PASS:
+                return LivePhase::GIMPLE;
+            case opt_pass_type::RTL_PASS:
+                return LivePhase::RTL;
+            default:
+                return LivePhase::IPA;
+        }
+    }
+
+    // 实时状态中的函数名称：只取已有的标识符，不在pass热路径上格式化
+    // 汇编名称已生成时使用（gperf-top反修饰），否则使用声明名称
+    const char* live_function_name(tree function)
+    {
+        if (!function)
+        {
+            return nullptr;
+        }
+        tree name = DECL_ASSEMBLER_NAME_SET_P(function) ? DECL_ASSEMBLER_NAME_RAW(function) : DECL_NAME(function);
+        return name ? IDENTIFIER_POINTER(name) : nullptr;
+    }
+
     // ==================== GCC回调函数实现 ====================
 
+    // 回调函数：当GCC开始解析一个函数体时调用
+    // 参数：
+    //   gcc_data - GCC传入的数据，指向函数的tree节点（未使用）
+    //   user_data - 用户数据（未使用）
+    void cb_start_parse_function(void* gcc_data, void* user_data)
+    {
+        OverheadScope overhead{OverheadSource::START_PARSE_FUNCTION};
+
+        start_parse_function();
+    }
+
     // 回调函数：当GCC完成一个函数的解析时调用
     // 参数：
     //   gcc_data - GCC传入的数据，指向函数的tree节点
     //   user_data - 用户数据（未使用）
     void cb_finish_parse_function(void* gcc_data, void* user_data)
     {
+        OverheadScope overhead{OverheadSource::FINISH_PARSE_FUNCTION};
+
         // 将void*转换为GCC的tree类型（函数声明节点）
         tree decl = (tree)gcc_data;
 
         // 获取函数的源代码位置信息（文件、行号、列号）
         auto expanded_location = expand_location(decl->decl_minimal.locus);
 
-        // 获取函数的名称（带命名空间和参数类型的完整签名）
-        auto decl_name = decl_as_string(decl, 0);
+        // 将收集到的函数信息传递给追踪系统处理
+        // 函数签名不在解析热路径上格式化，只保存tree节点
+        end_parse_function(FinishedFunction{
+            gcc_data,                    // GCC树节点指针（保持原始类型）
+            expanded_location.file,      // 定义所在的源文件
+            scope_id(DECL_CONTEXT(decl)),// 所属作用域（包含此函数的命名空间或类）
+            is_in_class_body(decl)       // 是否为类内定义的成员函数
+            });
+    }
+
+    // 回调函数：当GCC完成一个类型的定义时调用
+    // 参数：
+    //   gcc_data - GCC传入的数据，指向类型的tree节点
+    //   user_data - 用户数据（未使用）
+    void cb_finish_type(void* gcc_data, void* user_data)
+    {
+        OverheadScope overhead{OverheadSource::FINISH_TYPE};
+
+        tree type = (tree)gcc_data;
 
-        // 获取函数的父作用域（包含此函数的命名空间或类）
-        auto parent_decl = DECL_CONTEXT(decl);
+        // 只追踪类、结构体和联合体的定义（忽略枚举和错误节点）
+        if (!type || type == error_mark_node || !CLASS_TYPE_P(type))
+        {
+            return;
+        }
 
-        // 初始化作用域信息
-        const char* scope_name = nullptr;
-        GccTrace::EventCategory scope_type = GccTrace::EventCategory::UNKNOWN;
+        // 嵌套类：定义在另一个类内，随外层类一起完成
+        tree context = TYPE_CONTEXT(type);
+        bool nested = context && CLASS_TYPE_P(context);
+        if (!nested)
+        {
+            finished_types.insert(type);
+        }
 
-        // 如果存在父作用域且不是全局作用域（翻译单元）
-        if (parent_decl)
+        // 统计成员数量：数据成员、静态数据成员、成员函数和成员模板
+        // 忽略编译器生成的成员（隐式构造函数、基类子对象、虚表指针等）
+        int member_count = 0;
+        for (tree field = TYPE_FIELDS(type); field; field = DECL_CHAIN(field))
         {
-            if (TREE_CODE(parent_decl) != TRANSLATION_UNIT_DECL)
+            switch (TREE_CODE(field))
             {
-                // 获取作用域名称
-                scope_name = decl_as_string(parent_decl, 0);
-
-                // 根据GCC树节点类型判断作用域类型
-                switch (TREE_CODE(parent_decl))
-                {
-                    case NAMESPACE_DECL:  // C++命名空间
-                        scope_type = GccTrace::EventCategory::NAMESPACE;
-                        break;
-                    case RECORD_TYPE:     // 结构体或类
-                        scope_type = GccTrace::EventCategory::STRUCT;
-                        break;
-                    case UNION_TYPE:      // 联合体（也归类为STRUCT）
-                        scope_type = GccTrace::EventCategory::STRUCT;
-                        break;
-                    default:
-                        // 未知的作用域类型，输出警告信息
-                        fprintf(stderr, "Unkown tree code %d\n", TREE_CODE(parent_decl));
-                        break;
-                }
+                case FIELD_DECL:
+                case VAR_DECL:
+                case FUNCTION_DECL:
+                case TEMPLATE_DECL:
+                    if (!DECL_ARTIFICIAL(field))
+                    {
+                        member_count++;
+                    }
+                    break;
+                default:
+                    break;
             }
         }
 
-        // 将收集到的函数信息传递给追踪系统处理
-        end_parse_function(FinishedFunction{
-            gcc_data,                // GCC树节点指针（保持原始类型）
-            decl_name,               // 函数签名
-            expanded_location.file,  // 定义所在的源文件
-            scope_name,              // 所属作用域名称（可为空）
-            scope_type               // 作用域类型
+        // 直接基类数量
+        int base_count = TYPE_BINFO(type) ? BINFO_N_BASE_BINFOS(TYPE_BINFO(type)) : 0;
+
+        // 获取类型定义所在的源文件
+        const char* file_name = nullptr;
+        if (TYPE_NAME(type) && TREE_CODE(TYPE_NAME(type)) == TYPE_DECL)
+        {
+            file_name = expand_location(DECL_SOURCE_LOCATION(TYPE_NAME(type))).file;
+        }
+
+        // 将收集到的类型信息传递给追踪系统处理
+        end_parse_type(FinishedType{
+            gcc_data,                     // GCC树节点指针
+            scope_id(type),               // 类型自身的作用域（连同完整上下文链一起驻留）
+            file_name,                    // 定义所在的源文件
+            member_count,                 // 成员数量
+            base_count,                   // 直接基类数量
+            nested                        // 是否为嵌套类
             });
     }
 
+    // 回调函数：当GCC开始执行过程间分析pass时调用（前端解析已全部结束）
+    // 在free_lang_data释放C++语言相关数据之前格式化延迟的名称，
+    // 写入前端事件并刷到文件（优化阶段中途退出时trace中已有前端的数据）
+    void cb_all_ipa_passes_start(void* gcc_data, void* user_data)
+    {
+        OverheadScope overhead{OverheadSource::ALL_IPA_PASSES_START};
+
+        set_summary_frontend_end();
+        resolve_deferred_names();
+        write_frontend_events();
+        flush_output(/*force=*/true);
+
+        // 之后第一次出现的函数（pass、内联、代码大小）改用汇编名称格式化
+        lang_data_freed = flag_generate_lto || flag_generate_offload;
+    }
+
     // 回调函数：当GCC完成整个编译过程时调用
     // 负责触发所有事件的最终写入
     void cb_plugin_finish(void* gcc_data, void* user_data)
     {
+        live_status_phase(LivePhase::FINISHING);
+
+        // WPA：分区已写出，从LTRANS文件列表读取分区
+#ifdef ltrans_output_list
+        if (lto_unit().mode == LtoMode::WPA && ltrans_output_list)
+        {
+            if (FILE* list = fopen(ltrans_output_list, "r"))
+            {
+                std::vector<std::string> files;
+                char line[4096];
+                while (fgets(line, sizeof(line), list))
+                {
+                    line[strcspn(line, "\n")] = '\0';
+                    if (line[0])
+                    {
+                        files.emplace_back(line);
+                    }
+                }
+                fclose(list);
+                record_ltrans_partitions(std::move(files));
+            }
+        }
+#endif
+
         write_all_events();
     }
 
@@ -92,9 +563,13 @@ namespace GccTrace
     // 使用Hook技术插入预处理文件追踪逻辑
     void cb_file_change(cpp_reader* pfile, const line_map_ordinary* new_map)
     {
+        check_fatal_signal();
+
         // 检查是否有新的行号映射（表示文件切换）
         if (new_map)
         {
+            OverheadScope overhead{OverheadSource::FILE_CHANGE};
+
             // 获取文件名
             const char* file_name = ORDINARY_MAP_FILE_NAME(new_map);
             if (file_name)
@@ -122,8 +597,12 @@ namespace GccTrace
     // 回调函数：当GCC开始编译一个翻译单元时调用
     void cb_start_compilation(void* gcc_data, void* user_data)
     {
+        OverheadScope overhead{OverheadSource::START_UNIT};
+
         // 开始追踪主输入文件的预处理
         // main_input_filename是GCC全局变量，指向主源文件
+        live_status_unit(main_input_filename);
+        set_summary_main_file(main_input_filename);
         start_preprocess_file(main_input_filename, nullptr);
 
         // 获取GCC的C++预处理回调函数表
@@ -139,18 +618,114 @@ namespace GccTrace
     // 回调函数：当GCC执行一个优化pass时调用
     void cb_pass_execution(void* gcc_data, void* user_data)
     {
+        // 终止信号在pass边界关闭trace（信号处理中只记录信号）
+        check_fatal_signal();
+
         // 将gcc_data转换为优化pass指针
         auto pass = (opt_pass*)gcc_data;
 
+        // pass处理的函数：克隆（构造函数变体、IPA克隆）归并到原始函数
+        tree function = current_function_decl ? DECL_ORIGIN(current_function_decl) : nullptr;
+        const char* file_name = function ? DECL_SOURCE_FILE(function) : nullptr;
+
+        // 采样模式：判断是否追踪这个函数上的pass
+        // 汇编名称哈希保证同一函数在不同编译、不同翻译单元中的采样结果一致
+        bool sampled = !function || sample_function(function, DECL_ASSEMBLER_NAME_SET_P(function) ?
+            IDENTIFIER_HASH_VALUE(DECL_ASSEMBLER_NAME(function)) : DECL_UID(function));
+
+        // 插件开销：未被采样的pass不计时，跳过路径上只有一次哈希查找，不读取时钟
+        OverheadScope overhead{OverheadSource::PASS_EXECUTION, sampled};
+
+        // 实时状态：所有pass都更新（包括未被采样的），函数变化时才更新函数名称
+        // 未启用时不读取时钟（这个回调每个翻译单元可达千万次）
+        if (live_status_enabled())
+        {
+            live_status_pass(pass->name, live_phase(pass), ns_from_start());
+            if (function != live_function)
+            {
+                live_function = function;
+                live_status_function(live_function_name(function));
+            }
+        }
+
+        // 上一个pass是final：统计它输出的汇编字节数
+        if (final_function)
+        {
+            long final_asm_end = asm_out_file ? ftell(asm_out_file) : -1;
+            record_function_code_size(final_function, 0,
+                (final_asm_start >= 0 && final_asm_end >= 0) ? final_asm_end - final_asm_start : -1);
+            final_function = nullptr;
+        }
+
+        // lto1的第一个pass：符号表（和分区）已读入
+        if (!partition_symbols_recorded && lto_unit().mode != LtoMode::NONE)
+        {
+            record_lto_symbols();
+            partition_symbols_recorded = true;
+        }
+
+        // 上一个pass是内联pass：遍历调用图记录内联决策（汇总到内联pass事件）
+        if (inline_pass)
+        {
+            finish_inline_pass();
+        }
+
+        // 未被采样的函数上的pass只结束上一个被追踪的pass
+        if (!sampled)
+        {
+            skip_opt_pass();
+            return;
+        }
+
+        // 早期内联和过程间内联：记录内联前的快照
+        if (!strcmp(pass->name, "einline") || !strcmp(pass->name, "inline"))
+        {
+            start_inline_pass(pass);
+        }
+
+        // final pass：统计函数最终的RTL指令数（不含调试指令），记录汇编文件位置
+        if (function && cfun && pass->type == opt_pass_type::RTL_PASS && !strcmp(pass->name, "final") &&
+            is_traced_file(file_name))
+        {
+            int64_t rtl_insns = 0;
+            for (rtx_insn* insn = get_insns(); insn; insn = NEXT_INSN(insn))
+            {
+                if (NONDEBUG_INSN_P(insn))
+                {
+                    rtl_insns++;
+                }
+            }
+            record_function_code_size(function, rtl_insns, -1);
+
+            // 汇编输出到管道（-pipe）时ftell失败，此时不统计字节数
+            final_function = function;
+            final_asm_start = asm_out_file ? ftell(asm_out_file) : -1;
+        }
+
         // 开始追踪这个优化pass的执行
-        start_opt_pass(pass);
+        start_opt_pass(pass, function, file_name);
     }
 
     // 回调函数：当GCC完成一个声明的处理时调用
-    // 主要用于标记预处理阶段的结束
+    // 主要用于标记预处理阶段的结束，以及划分命名空间作用域的声明解析时间
     void cb_finish_decl(void* gcc_data, void* user_data)
     {
+        OverheadScope overhead{OverheadSource::FINISH_DECL};
+
         finish_preprocessing_stage();
+
+        // 只有命名空间作用域的声明才是类定义之间的边界
+        // （类成员和局部变量的上下文分别是类和函数）
+        tree decl = (tree)gcc_data;
+        if (decl && DECL_P(decl))
+        {
+            tree context = DECL_CONTEXT(decl);
+            if (!context || TREE_CODE(context) == NAMESPACE_DECL ||
+                TREE_CODE(context) == TRANSLATION_UNIT_DECL)
+            {
+                end_toplevel_declaration(scope_id(context));
+            }
+        }
     }
 
 }  // namespace GccTrace结束
@@ -160,6 +735,79 @@ namespace GccTrace
 // 插件名称常量
 static const char* PLUGIN_NAME = "gperf";
 
+// 获取指定输出文件在当前进程中的实际文件名
+// LTO的WPA和各LTRANS分区是多个lto1进程，共用同一个-fplugin-arg参数，
+// 在扩展名之前插入模式和分区编号，避免互相覆盖：trace.json → trace.ltrans3.json
+// 参数：
+//   file_name - 插件参数指定的输出文件
+std::string trace_file_name(const char* file_name)
+{
+    const GccTrace::LtoUnit& unit = GccTrace::lto_unit();
+    std::string suffix;
+    switch (unit.mode)
+    {
+        case GccTrace::LtoMode::NONE:
+            return file_name;
+        case GccTrace::LtoMode::LTO:
+            suffix = ".lto";
+            break;
+        case GccTrace::LtoMode::WPA:
+            suffix = ".wpa";
+            break;
+        case GccTrace::LtoMode::LTRANS:
+            suffix = ".ltrans" + std::to_string(unit.partition);
+            break;
+    }
+
+    // 压缩扩展名（.gz/.zst）之前的扩展名：trace.json.gz → trace.wpa.json.gz
+    std::string result{file_name};
+    size_t end = result.size() -
+        strlen(GccTrace::compression_extension(GccTrace::compression_from_file_name(result)));
+    size_t dot = result.rfind('.', end - 1);
+    size_t slash = result.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = end;  // 没有扩展名：追加到末尾（压缩扩展名之前）
+    }
+    result.insert(dot, suffix);
+    return result;
+}
+
+// 摘要侧车文件名：把trace文件的.json和压缩扩展名替换为.summary.json
+// trace.json.gz → trace.summary.json，没有.json扩展名时追加：trace → trace.summary.json
+// 参数：
+//   file_name - 实际写入的trace文件
+std::string summary_file_name(const std::string& file_name)
+{
+    std::string result = file_name.substr(0, file_name.size() -
+        strlen(GccTrace::compression_extension(GccTrace::compression_from_file_name(file_name))));
+    if (result.ends_with(".json"))
+    {
+        result.resize(result.size() - strlen(".json"));
+    }
+    return result + ".summary.json";
+}
+
+// 解析非负整数插件参数
+// 参数：
+//   arg   - 插件参数
+//   value - 解析结果
+//   max   - 允许的最大值（超出范围的值不截断，报错）
+// 返回值：成功返回true，失败输出错误信息并返回false
+bool parse_count_argument(const plugin_argument& arg, int64_t& value, int64_t max = INT64_MAX)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = arg.value ? strtoll(arg.value, &end, 10) : -1;
+    if (!arg.value || *end || value < 0 || value > max || errno == ERANGE)
+    {
+        fprintf(stderr, "GPERF Error! -fplugin-arg-%s-%s expects an integer between 0 and %lld\n",
+            PLUGIN_NAME, arg.key, static_cast<long long>(max));
+        return false;
+    }
+    return true;
+}
+
 // 设置输出文件系统
 // 参数：
 //   argc - 插件参数个数
@@ -170,23 +818,200 @@ bool setup_output(int argc, plugin_argument* argv)
     // 插件参数名称定义
     const char* flag_name = "trace";       // 直接指定输出文件
     const char* dir_flag_name = "trace-dir"; // 指定输出目录
+    const char* sample_flag_name = "sample"; // pass执行采样率（每N个函数追踪1个）
+    const char* max_events_flag_name = "max-pass-events"; // 记录的pass事件上限
+    const char* threshold_flag_name = "threshold"; // 最小事件长度（微秒），可加"-类别"后缀
+    const char* include_flag_name = "include-path"; // 只详细追踪的源文件路径（可多次指定）
+    const char* exclude_flag_name = "exclude-path"; // 不详细追踪的源文件路径（可多次指定）
+    const char* compress_flag_name = "compress"; // 压缩格式（gzip/zstd/none），默认按文件扩展名
+    const char* collector_flag_name = "collector"; // 发送到gperfd的Unix套接字（代替输出文件）
+    const char* live_flag_name = "live"; // 把实时状态发布到共享内存（gperf-top查看）
 
     // TODO: 可以考虑将默认文件名与源文件名关联
     // TODO: 验证我们一次只编译一个翻译单元（目前不支持并行编译追踪）
 
     FILE* trace_file = nullptr;  // 输出文件句柄
+    const char* trace_path = nullptr;  // 输出文件参数
+    const char* trace_dir = nullptr;   // 输出目录参数
+    int64_t sample_rate = 1;           // 采样率参数
+    int64_t max_events = 1000000;      // pass事件上限参数
+    int64_t threshold_us = -1;         // 所有类别的最小事件长度参数（-1表示默认）
+    const char* compress = nullptr;    // 压缩格式参数
+    const char* collector = nullptr;   // gperfd套接字参数
+    bool live = false;                 // 实时状态参数
+    std::vector<std::pair<GccTrace::EventCategory, int64_t>> category_thresholds;  // 单个类别的阈值参数
+
+    // 解析插件参数
+    for (int i = 0; i < argc; i++)
+    {
+        if (!strcmp(argv[i].key, flag_name) && !trace_dir)
+        {
+            trace_path = argv[i].value;
+        }
+        else if (!strcmp(argv[i].key, dir_flag_name) && !trace_path)
+        {
+            trace_dir = argv[i].value;
+        }
+        else if (!strcmp(argv[i].key, sample_flag_name))
+        {
+            if (!parse_count_argument(argv[i], sample_rate, INT_MAX))
+            {
+                return false;
+            }
+        }
+        else if (!strcmp(argv[i].key, max_events_flag_name))
+        {
+            if (!parse_count_argument(argv[i], max_events))
+            {
+                return false;
+            }
+        }
+        else if (!strcmp(argv[i].key, compress_flag_name) && argv[i].value)
+        {
+            compress = argv[i].value;
+        }
+        else if (!strcmp(argv[i].key, collector_flag_name) && argv[i].value)
+        {
+            collector = argv[i].value;
+        }
+        else if (!strcmp(argv[i].key, live_flag_name))
+        {
+            live = true;
+        }
+        else if ((!strcmp(argv[i].key, include_flag_name) || !strcmp(argv[i].key, exclude_flag_name)) &&
+            argv[i].value)
+        {
+            GccTrace::add_path_filter(argv[i].value, !strcmp(argv[i].key, include_flag_name));
+        }
+        else if (!strncmp(argv[i].key, threshold_flag_name, strlen(threshold_flag_name)))
+        {
+            // threshold=N 设置所有类别，threshold-类别=N 设置单个类别（优先）
+            const char* suffix = argv[i].key + strlen(threshold_flag_name);
+            GccTrace::EventCategory category;
+            int64_t value;
+            if (*suffix && (*suffix != '-' || !GccTrace::parse_event_category(suffix + 1, category)))
+            {
+                fprintf(stderr, "GPERF Error! Unknown event category in -fplugin-arg-%s-%s\n",
+                    PLUGIN_NAME, argv[i].key);
+                return false;
+            }
+            // TU事件总是输出：工具从它得到翻译单元的时间跨度
+            if (*suffix && category == GccTrace::EventCategory::TU)
+            {
+                fprintf(stderr, "GPERF Error! The TU event is always written, -fplugin-arg-%s-%s is not supported\n",
+                    PLUGIN_NAME, argv[i].key);
+                return false;
+            }
+            if (!parse_count_argument(argv[i], value, INT64_MAX / 1000))  // 微秒换算为纳秒不溢出
+            {
+                return false;
+            }
+            if (*suffix)
+            {
+                category_thresholds.emplace_back(category, value);
+            }
+            else
+            {
+                threshold_us = value;
+            }
+        }
+        else
+        {
+            // 参数格式错误（未知参数，或同时指定了文件和目录）
+            fprintf(stderr,
+                "GPERF Error! Arguments must be -fplugin-arg-%s-%s=FILENAME or "
+                "-fplugin-arg-%s-%s=DIRECTORY, optionally with "
+                "-fplugin-arg-%s-%s=N, -fplugin-arg-%s-%s=N, "
+                "-fplugin-arg-%s-%s[-CATEGORY]=MICROSECONDS, "
+                "-fplugin-arg-%s-%s=PATH, -fplugin-arg-%s-%s=PATH, "
+                "-fplugin-arg-%s-%s=gzip|zstd|none, -fplugin-arg-%s-%s=SOCKET and -fplugin-arg-%s-%s\n",
+                PLUGIN_NAME, flag_name, PLUGIN_NAME, dir_flag_name,
+                PLUGIN_NAME, sample_flag_name, PLUGIN_NAME, max_events_flag_name,
+                PLUGIN_NAME, threshold_flag_name,
+                PLUGIN_NAME, include_flag_name, PLUGIN_NAME, exclude_flag_name,
+                PLUGIN_NAME, compress_flag_name, PLUGIN_NAME, collector_flag_name,
+                PLUGIN_NAME, live_flag_name);
+            return false;
+        }
+    }
+
+    GccTrace::configure_pass_sampling(static_cast<int>(sample_rate), max_events);
+
+    // 最小事件长度：先设置所有类别（TU事件除外），再用单个类别的参数覆盖
+    if (threshold_us >= 0)
+    {
+        for (int i = 0; i < GccTrace::EVENT_CATEGORY_COUNT; i++)
+        {
+            if (static_cast<GccTrace::EventCategory>(i) != GccTrace::EventCategory::TU)
+            {
+                GccTrace::set_event_threshold(static_cast<GccTrace::EventCategory>(i), threshold_us * 1000);
+            }
+        }
+    }
+    for (const auto& [category, value] : category_thresholds)
+    {
+        GccTrace::set_event_threshold(category, value * 1000);
+    }
+
+    // 压缩格式：插件参数优先，否则按输出文件的扩展名（.gz/.zst）
+    GccTrace::TraceCompression compression = GccTrace::TraceCompression::NONE;
+    if (compress && !GccTrace::parse_compression(compress, compression))
+    {
+        fprintf(stderr, "GPERF Error! -fplugin-arg-%s-%s expects gzip, zstd or none\n",
+            PLUGIN_NAME, compress_flag_name);
+        return false;
+    }
+    if (!compress && trace_path)
+    {
+        compression = GccTrace::compression_from_file_name(trace_path);
+    }
+    if (collector && compression != GccTrace::TraceCompression::NONE)
+    {
+        fprintf(stderr, "GPERF Error! -fplugin-arg-%s-%s sends uncompressed traces\n",
+            PLUGIN_NAME, collector_flag_name);
+        return false;
+    }
+    if (!GccTrace::compression_supported(compression))
+    {
+        fprintf(stderr, "GPERF Error! %s was built without %s compression support\n",
+            PLUGIN_NAME, GccTrace::compression_extension(compression));
+        return false;
+    }
+
+    // 实时状态：创建失败不影响trace输出
+    if (live)
+    {
+        GccTrace::open_live_status(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            GccTrace::COMPILATION_START.time_since_epoch()).count());
+    }
 
-    // 根据参数数量和处理方式分为三种情况：
+    // 临时文件的后缀：.json加压缩扩展名
+    std::string suffix = std::string(".json") + GccTrace::compression_extension(compression);
 
-    // 情况1：没有指定参数，使用默认临时文件
-    if (argc == 0)
+    // 指定了gperfd：trace发送到收集守护进程，不创建文件
+    // 连接失败时不中断编译，按下面的规则写入文件（默认为临时文件）
+    if (collector)
+    {
+        trace_file = GccTrace::connect_collector(collector);
+        if (trace_file)
+        {
+            GccTrace::init_output_file(trace_file, /*periodic_flush=*/false);
+            return true;
+        }
+        fprintf(stderr, "GPERF Error! Writing the trace to a file instead\n");
+    }
+
+    // 根据输出参数分为三种情况：
+
+    // 情况1：没有指定输出，使用默认临时文件
+    if (!trace_path && !trace_dir)
     {
         // 创建临时文件模板
-        char file_template[] = "/tmp/trace_XXXXXX.json";
+        std::string file_template = "/tmp/trace_XXXXXX" + suffix;
 
         // 使用mkstemps创建唯一的临时文件（XXXXXX会被随机字符替换）
-        // 参数5表示".json"后缀长度
-        int fd = mkstemps(file_template, 5);
+        // 第二个参数是后缀长度
+        int fd = mkstemps(file_template.data(), static_cast<int>(suffix.size()));
         if (fd == -1)
         {
             perror("GPERF mkstemps error: ");
@@ -195,26 +1020,29 @@ bool setup_output(int argc, plugin_argument* argv)
 
         // 将文件描述符转换为FILE*指针
         trace_file = fdopen(fd, "w");
+        GccTrace::set_summary_file(summary_file_name(file_template));
     }
     // 情况2：指定了输出文件路径
-    else if (argc == 1 && !strcmp(argv[0].key, flag_name))
+    else if (trace_path)
     {
-        // 直接打开指定的文件
-        trace_file = fopen(argv[0].value, "w");
+        // 直接打开指定的文件（lto1中按模式和分区区分文件名）
+        std::string file_name = trace_file_name(trace_path);
+        trace_file = fopen(file_name.data(), "w");
         if (!trace_file)
         {
-            fprintf(stderr, "GPERF Error! Couldn't open %s for writing\n", argv[0].value);
+            fprintf(stderr, "GPERF Error! Couldn't open %s for writing\n", file_name.data());
         }
+        GccTrace::set_summary_file(summary_file_name(file_name));
     }
     // 情况3：指定了输出目录
-    else if (argc == 1 && !strcmp(argv[0].key, dir_flag_name))
+    else
     {
         // 构建文件路径：目录 + 临时文件名
-        std::string file_template{argv[0].value};
-        file_template += "/trace_XXXXXX.json";
+        std::string file_template{trace_dir};
+        file_template += "/trace_XXXXXX" + suffix;
 
         // 在指定目录创建临时文件
-        int fd = mkstemps(file_template.data(), 5);
+        int fd = mkstemps(file_template.data(), static_cast<int>(suffix.size()));
         if (fd == -1)
         {
             perror("GPERF mkstemps error: ");
@@ -222,15 +1050,13 @@ bool setup_output(int argc, plugin_argument* argv)
         }
 
         trace_file = fdopen(fd, "w");
+        GccTrace::set_summary_file(summary_file_name(file_template));
     }
-    // 情况4：参数格式错误
-    else
+
+    // 压缩输出：包装为边写边压缩的FILE*（失败时已关闭原文件）
+    if (trace_file)
     {
-        fprintf(stderr,
-            "GPERF Error! Arguments must be -fplugin-arg-%s-%s=FILENAME or "
-            "-fplugin-arg-%s-%s=DIRECTORY\n",
-            PLUGIN_NAME, flag_name, PLUGIN_NAME, dir_flag_name);
-        return false;
+        trace_file = GccTrace::open_compressed_stream(trace_file, compression);
     }
 
     // 如果成功创建/打开文件，初始化输出系统
@@ -262,34 +1088,60 @@ int plugin_init(struct plugin_name_args* plugin_info,
     // 记录编译开始时间（关键的时间基准）
     GccTrace::COMPILATION_START = GccTrace::clock_t::now();
 
+    // 检测是否运行在lto1中（WPA/LTRANS），输出文件名依赖分区编号
+    GccTrace::set_lto_unit(GccTrace::detect_lto_unit());
+    bool front_end = GccTrace::lto_unit().mode == GccTrace::LtoMode::NONE;
+
     // 设置输出文件系统
     if (!setup_output(plugin_info->argc, plugin_info->argv))
     {
         return -1;  // 初始化失败
     }
 
+    // lto1没有主源文件（前端在开始编译单元时设置）
+    if (!front_end)
+    {
+        GccTrace::live_status_unit(GccTrace::lto_process_name().data());
+    }
+
     // ============ 注册插件回调函数（按编译流程顺序）============
 
     // 1. 注册插件基本信息
     register_callback(PLUGIN_NAME, PLUGIN_INFO, nullptr, &gcc_trace_info);
 
-    // 2. 注册编译单元开始回调（最早调用）
-    register_callback(PLUGIN_NAME, PLUGIN_START_UNIT,
-        &GccTrace::cb_start_compilation, nullptr);
+    // 2-6. 前端回调：lto1没有预处理和C++解析，只追踪优化pass
+    if (front_end)
+    {
+        // 2. 注册编译单元开始回调（最早调用）
+        register_callback(PLUGIN_NAME, PLUGIN_START_UNIT,
+            &GccTrace::cb_start_compilation, nullptr);
+
+        // 3. 注册声明处理完成回调（标记预处理结束）
+        register_callback(PLUGIN_NAME, PLUGIN_FINISH_DECL,
+            &GccTrace::cb_finish_decl, nullptr);
 
-    // 3. 注册声明处理完成回调（标记预处理结束）
-    register_callback(PLUGIN_NAME, PLUGIN_FINISH_DECL,
-        &GccTrace::cb_finish_decl, nullptr);
+        // 4. 注册函数解析开始回调（记录函数解析的真实开始时间）
+        register_callback(PLUGIN_NAME, PLUGIN_START_PARSE_FUNCTION,
+            &GccTrace::cb_start_parse_function, nullptr);
 
-    // 4. 注册函数解析完成回调（处理每个函数的解析）
-    register_callback(PLUGIN_NAME, PLUGIN_FINISH_PARSE_FUNCTION,
-        &GccTrace::cb_finish_parse_function, nullptr);
+        // 5. 注册函数解析完成回调（处理每个函数的解析）
+        register_callback(PLUGIN_NAME, PLUGIN_FINISH_PARSE_FUNCTION,
+            &GccTrace::cb_finish_parse_function, nullptr);
 
-    // 5. 注册优化pass执行回调（追踪每个优化阶段）
+        // 6. 注册类型定义完成回调（追踪类/结构体定义）
+        register_callback(PLUGIN_NAME, PLUGIN_FINISH_TYPE,
+            &GccTrace::cb_finish_type, nullptr);
+    }
+
+    // 7. 注册优化pass执行回调（追踪每个优化阶段）
     register_callback(PLUGIN_NAME, PLUGIN_PASS_EXECUTION,
         &GccTrace::cb_pass_execution, nullptr);
 
-    // 6. 注册编译完成回调（最后调用，触发数据输出）
+    // 8. 注册过程间分析开始回调（前端结束，格式化延迟的名称）
+    register_callback(PLUGIN_NAME, PLUGIN_ALL_IPA_PASSES_START,
+        &GccTrace::cb_all_ipa_passes_start, nullptr);
+
+    // 9. 注册编译完成回调（最后调用，触发数据输出）
     register_callback(PLUGIN_NAME, PLUGIN_FINISH,
         &GccTrace::cb_plugin_finish, nullptr);
 
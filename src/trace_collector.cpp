@@ -0,0 +1,94 @@
+// GCC性能追踪插件的收集守护进程客户端模块
+// 用fopencookie把Unix套接字包装为FILE*：TraceWriter和GCC json::value::dump照常写入FILE*
+
+#include "trace_collector.h"  // 包含客户端接口声明，提供实现
+
+#include <cerrno>             // errno
+#include <cstring>            // strerror、strncpy
+#include <sys/socket.h>       // socket、connect、send
+#include <sys/un.h>           // sockaddr_un
+#include <unistd.h>           // close
+
+namespace GccTrace
+{
+    namespace // 匿名命名空间，限制符号只在当前文件可见
+    {
+        // 套接字连接状态（fopencookie的cookie）
+        struct CollectorStream
+        {
+            int fd;                  // 已连接的套接字
+            bool failed = false;     // 是否已报告过写入失败（只报告一次）
+        };
+
+        // fopencookie写回调：全部发送后返回字节数，出错时返回-1
+        ssize_t cookie_write(void* cookie, const char* data, size_t size)
+        {
+            auto stream = static_cast<CollectorStream*>(cookie);
+            size_t sent = 0;
+            while (sent < size)
+            {
+                ssize_t n = send(stream->fd, data + sent, size - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    if (!stream->failed)
+                    {
+                        fprintf(stderr, "GPERF Error! Couldn't send trace to gperfd: %s\n", strerror(errno));
+                        stream->failed = true;
+                    }
+                    return -1;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            return static_cast<ssize_t>(size);
+        }
+
+        // fopencookie关闭回调：关闭连接（gperfd据此认为trace已结束）
+        int cookie_close(void* cookie)
+        {
+            auto stream = static_cast<CollectorStream*>(cookie);
+            int result = close(stream->fd);
+            delete stream;
+            return result == 0 ? 0 : EOF;
+        }
+    }  // 匿名命名空间结束
+
+    std::FILE* connect_collector(const char* socket_path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (strlen(socket_path) >= sizeof(address.sun_path))
+        {
+            fprintf(stderr, "GPERF Error! gperfd socket path is too long: %s\n", socket_path);
+            return nullptr;
+        }
+        strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd == -1)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't create socket: %s\n", strerror(errno));
+            return nullptr;
+        }
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't connect to gperfd at %s: %s\n", socket_path, strerror(errno));
+            close(fd);
+            return nullptr;
+        }
+
+        cookie_io_functions_t functions{};
+        functions.write = cookie_write;
+        functions.close = cookie_close;
+        auto stream = new CollectorStream{fd};
+        std::FILE* file = fopencookie(stream, "w", functions);
+        if (!file)
+        {
+            cookie_close(stream);
+        }
+        return file;
+    }
+}
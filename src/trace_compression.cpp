@@ -0,0 +1,305 @@
+// GCC性能追踪插件的trace压缩输出模块
+// 用fopencookie把压缩器包装为FILE*：TraceWriter和GCC json::value::dump照常写入FILE*，
+// 数据分块压缩后立即写入底层文件
+
+#include "trace_compression.h"  // 包含压缩输出接口声明，提供实现
+
+#include <cerrno>               // errno
+#include <cstring>              // strerror
+#include <vector>               // 压缩输出缓冲区
+
+#ifdef GPERF_HAVE_ZLIB
+#include <zlib.h>               // gzip压缩（deflate）
+#endif
+#ifdef GPERF_HAVE_ZSTD
+#include <zstd.h>               // zstd流式压缩
+#endif
+
+namespace GccTrace
+{
+    namespace // 匿名命名空间，限制符号只在当前文件可见
+    {
+        // 压缩输出块大小：每次压缩调用的输出缓冲区
+        constexpr size_t COMPRESSED_CHUNK_SIZE = 1 << 16;
+
+        // gzip压缩级别：1最快，JSON文本仍有很高的压缩率
+        constexpr int GZIP_LEVEL = 1;
+
+        // zstd压缩级别：3为zstd默认值，速度与gzip -1相当而压缩率更高
+        constexpr int ZSTD_LEVEL = 3;
+
+        // 压缩一块数据的方式
+        enum class ChunkMode
+        {
+            CONTINUE,   // 普通写入：压缩器可以保留未输出的数据
+            FLUSH,      // 同步刷新：输出所有已写入的数据，之前的内容可以独立解压
+            FINISH      // 结束：写入压缩流结尾
+        };
+
+        // 压缩流状态（fopencookie的cookie）
+        struct CompressedStream
+        {
+            std::FILE* file;                 // 底层输出文件
+            TraceCompression compression;    // 压缩格式
+            std::vector<char> out;           // 压缩输出缓冲区
+#ifdef GPERF_HAVE_ZLIB
+            z_stream zlib{};                 // deflate状态
+#endif
+#ifdef GPERF_HAVE_ZSTD
+            ZSTD_CCtx* zstd = nullptr;       // zstd压缩上下文
+#endif
+        };
+
+        // 已打开的压缩流：fopencookie不提供flush回调，同步刷新时按FILE*查找压缩状态
+        // （插件只打开一个输出流，线性查找即可）
+        std::vector<std::pair<std::FILE*, CompressedStream*>> open_streams;
+
+        // 把压缩输出缓冲区的前size字节写入底层文件
+        [[maybe_unused]] bool write_out(CompressedStream* stream, size_t size)
+        {
+            return size == 0 || fwrite(stream->out.data(), 1, size, stream->file) == size;
+        }
+
+#ifdef GPERF_HAVE_ZLIB
+        // 压缩一块数据（FLUSH时同步刷新，FINISH时写入gzip结尾）
+        bool deflate_chunk(CompressedStream* stream, const char* data, size_t size, ChunkMode mode)
+        {
+            static const int flush_modes[] = {Z_NO_FLUSH, Z_SYNC_FLUSH, Z_FINISH};
+            z_stream& z = stream->zlib;
+            z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            z.avail_in = static_cast<uInt>(size);
+            int result;
+            do
+            {
+                z.next_out = reinterpret_cast<Bytef*>(stream->out.data());
+                z.avail_out = static_cast<uInt>(stream->out.size());
+                result = deflate(&z, flush_modes[(int)mode]);
+                if (result == Z_STREAM_ERROR || !write_out(stream, stream->out.size() - z.avail_out))
+                {
+                    return false;
+                }
+            } while (z.avail_out == 0 || (mode == ChunkMode::FINISH && result != Z_STREAM_END));
+            return true;
+        }
+#endif
+
+#ifdef GPERF_HAVE_ZSTD
+        // 压缩一块数据（FLUSH时刷新当前块，FINISH时写入zstd帧结尾）
+        bool zstd_chunk(CompressedStream* stream, const char* data, size_t size, ChunkMode mode)
+        {
+            static const ZSTD_EndDirective directives[] = {ZSTD_e_continue, ZSTD_e_flush, ZSTD_e_end};
+            ZSTD_inBuffer in{data, size, 0};
+            size_t remaining;
+            do
+            {
+                ZSTD_outBuffer out{stream->out.data(), stream->out.size(), 0};
+                remaining = ZSTD_compressStream2(stream->zstd, &out, &in, directives[(int)mode]);
+                if (ZSTD_isError(remaining) || !write_out(stream, out.pos))
+                {
+                    return false;
+                }
+            } while (mode != ChunkMode::CONTINUE ? remaining != 0 : in.pos < in.size);
+            return true;
+        }
+#endif
+
+        // 压缩一块数据并写入底层文件（没有启用任何压缩库时各参数未使用）
+        bool compress_chunk(CompressedStream* stream, [[maybe_unused]] const char* data,
+            [[maybe_unused]] size_t size, [[maybe_unused]] ChunkMode mode)
+        {
+            switch (stream->compression)
+            {
+#ifdef GPERF_HAVE_ZLIB
+                case TraceCompression::GZIP:
+                    return deflate_chunk(stream, data, size, mode);
+#endif
+#ifdef GPERF_HAVE_ZSTD
+                case TraceCompression::ZSTD:
+                    return zstd_chunk(stream, data, size, mode);
+#endif
+                default:
+                    return false;
+            }
+        }
+
+        // fopencookie写回调：返回消耗的字节数，出错时返回0
+        ssize_t cookie_write(void* cookie, const char* data, size_t size)
+        {
+            auto stream = static_cast<CompressedStream*>(cookie);
+            if (!compress_chunk(stream, data, size, ChunkMode::CONTINUE))
+            {
+                fprintf(stderr, "GPERF Error! Couldn't write compressed trace: %s\n", strerror(errno));
+                return 0;
+            }
+            return static_cast<ssize_t>(size);
+        }
+
+        // fopencookie关闭回调：写入压缩流结尾，释放压缩器，关闭底层文件
+        int cookie_close(void* cookie)
+        {
+            auto stream = static_cast<CompressedStream*>(cookie);
+            bool ok = compress_chunk(stream, nullptr, 0, ChunkMode::FINISH);
+#ifdef GPERF_HAVE_ZLIB
+            if (stream->compression == TraceCompression::GZIP)
+            {
+                deflateEnd(&stream->zlib);
+            }
+#endif
+#ifdef GPERF_HAVE_ZSTD
+            if (stream->compression == TraceCompression::ZSTD)
+            {
+                ZSTD_freeCCtx(stream->zstd);
+            }
+#endif
+            ok = fclose(stream->file) == 0 && ok;
+            for (auto it = open_streams.begin(); it != open_streams.end(); ++it)
+            {
+                if (it->second == stream)
+                {
+                    open_streams.erase(it);
+                    break;
+                }
+            }
+            delete stream;
+            return ok ? 0 : EOF;
+        }
+    }  // 匿名命名空间结束
+
+    const char* compression_extension(TraceCompression compression)
+    {
+        switch (compression)
+        {
+            case TraceCompression::GZIP:
+                return ".gz";
+            case TraceCompression::ZSTD:
+                return ".zst";
+            default:
+                return "";
+        }
+    }
+
+    TraceCompression compression_from_file_name(std::string_view file_name)
+    {
+        if (file_name.ends_with(".gz"))
+        {
+            return TraceCompression::GZIP;
+        }
+        if (file_name.ends_with(".zst"))
+        {
+            return TraceCompression::ZSTD;
+        }
+        return TraceCompression::NONE;
+    }
+
+    bool parse_compression(std::string_view name, TraceCompression& compression)
+    {
+        if (name == "none")
+        {
+            compression = TraceCompression::NONE;
+        }
+        else if (name == "gzip" || name == "gz")
+        {
+            compression = TraceCompression::GZIP;
+        }
+        else if (name == "zstd" || name == "zst")
+        {
+            compression = TraceCompression::ZSTD;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    bool compression_supported(TraceCompression compression)
+    {
+        switch (compression)
+        {
+            case TraceCompression::NONE:
+                return true;
+            case TraceCompression::GZIP:
+#ifdef GPERF_HAVE_ZLIB
+                return true;
+#else
+                return false;
+#endif
+            case TraceCompression::ZSTD:
+#ifdef GPERF_HAVE_ZSTD
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    std::FILE* open_compressed_stream(std::FILE* file, TraceCompression compression)
+    {
+        if (compression == TraceCompression::NONE)
+        {
+            return file;
+        }
+        if (!compression_supported(compression))
+        {
+            fclose(file);
+            return nullptr;
+        }
+
+        auto stream = new CompressedStream{file, compression, std::vector<char>(COMPRESSED_CHUNK_SIZE)};
+        bool ok = false;
+#ifdef GPERF_HAVE_ZLIB
+        if (compression == TraceCompression::GZIP)
+        {
+            // windowBits 15+16：输出gzip头和结尾（而不是zlib格式）
+            ok = deflateInit2(&stream->zlib, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+#endif
+#ifdef GPERF_HAVE_ZSTD
+        if (compression == TraceCompression::ZSTD)
+        {
+            stream->zstd = ZSTD_createCCtx();
+            ok = stream->zstd &&
+                !ZSTD_isError(ZSTD_CCtx_setParameter(stream->zstd, ZSTD_c_compressionLevel, ZSTD_LEVEL));
+        }
+#endif
+
+        if (!ok)
+        {
+            fprintf(stderr, "GPERF Error! Couldn't initialize %s compression\n", compression_extension(compression));
+#ifdef GPERF_HAVE_ZSTD
+            ZSTD_freeCCtx(stream->zstd);
+#endif
+            fclose(file);
+            delete stream;
+            return nullptr;
+        }
+
+        cookie_io_functions_t functions{};
+        functions.write = cookie_write;
+        functions.close = cookie_close;
+        std::FILE* compressed = fopencookie(stream, "w", functions);
+        if (!compressed)
+        {
+            cookie_close(stream);  // 释放压缩器并关闭底层文件
+            return nullptr;
+        }
+        open_streams.emplace_back(compressed, stream);
+        return compressed;
+    }
+
+    bool flush_trace_stream(std::FILE* file)
+    {
+        bool ok = fflush(file) == 0;  // 压缩流：FILE缓冲区中的数据先交给压缩器
+        for (const auto& [handle, stream] : open_streams)
+        {
+            if (handle == file)
+            {
+                ok = compress_chunk(stream, nullptr, 0, ChunkMode::FLUSH) && ok;
+                ok = fflush(stream->file) == 0 && ok;
+                break;
+            }
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,342 @@
+// GCC性能追踪插件的Chrome Tracing流式序列化模块
+// 事件直接格式化为JSON文本，不依赖GCC的json.h，可在GCC之外测试和基准测试
+
+#include "trace_writer.h"    // 包含写入器声明，提供实现
+
+#include <charconv>          // to_chars（无区域设置的快速数字格式化）
+#include <csignal>           // 后台线程屏蔽信号（pthread_sigmask）
+#include <condition_variable>// 缓冲区交接通知
+#include <mutex>             // 缓冲区交接互斥
+#include <thread>            // 后台写入线程
+
+namespace GccTrace
+{
+    // 类别名称：与EventCategory枚举一一对应（用于"cat"字段）
+    const char* category_string(EventCategory cat)
+    {
+        static const char* strings[EVENT_CATEGORY_COUNT] = {
+            "TU",                  // Translation Unit（整个编译单元）
+            "PREPROCESS",          // 预处理阶段
+            "FUNCTION",            // 函数解析
+            "DECLARATION",         // 函数之间的声明解析
+            "STRUCT",              // 结构体/类定义
+            "NAMESPACE",           // 命名空间
+            "GIMPLE_PASS",         // GIMPLE中间表示优化pass
+            "RTL_PASS",            // RTL（寄存器传输级）优化pass
+            "SIMPLE_IPA_PASS",     // 简单过程间分析pass
+            "IPA_PASS",            // 完整过程间分析pass
+            "UNKNOWN"              // 未知类型
+        };
+        return strings[(int)cat];
+    }
+
+    // 后台写入线程：一次持有一个待写入的缓冲区
+    struct TraceWriter::BackgroundWriter
+    {
+        std::FILE* file;                  // 输出文件
+        std::mutex mutex;                 // 保护以下状态
+        std::condition_variable changed;  // pending或stopping变化时通知
+        std::string pending;              // 待写入（或正在写入）的缓冲区
+        bool has_pending = false;         // pending是否尚未写完
+        bool stopping = false;            // 是否结束线程
+        std::thread thread;               // 写入线程
+
+        explicit BackgroundWriter(std::FILE* file) : file(file)
+        {
+            // 后台线程屏蔽所有信号（新线程继承创建时的信号掩码）：
+            // 终止信号总是由编译线程处理
+            sigset_t all_signals;
+            sigset_t previous;
+            sigfillset(&all_signals);
+            pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+            thread = std::thread([this] { run(); });
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        }
+
+        // 等待并写入交来的缓冲区，写完后清空（保留容量供下次交换复用）
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                changed.wait(lock, [this] { return has_pending || stopping; });
+                if (!has_pending)
+                {
+                    return;
+                }
+
+                lock.unlock();
+                fwrite(pending.data(), 1, pending.size(), file);
+                lock.lock();
+
+                pending.clear();
+                has_pending = false;
+                changed.notify_all();
+            }
+        }
+
+        // 等待上一个缓冲区写完（调用方持有锁）
+        void wait_idle(std::unique_lock<std::mutex>& lock)
+        {
+            changed.wait(lock, [this] { return !has_pending; });
+        }
+
+        // 交换缓冲区：buffer交给线程写入，换回已写完的空缓冲区
+        void submit(std::string& buffer)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wait_idle(lock);
+            pending.swap(buffer);
+            has_pending = true;
+            changed.notify_all();
+        }
+
+        // 等待所有交来的缓冲区写完
+        void drain()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wait_idle(lock);
+        }
+
+        ~BackgroundWriter()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wait_idle(lock);
+                stopping = true;
+                changed.notify_all();
+            }
+            thread.join();
+        }
+    };
+
+    TraceWriter::TraceWriter(std::FILE* file, size_t buffer_size, bool background_writer)
+        : file(file), buffer_limit(buffer_size)
+    {
+        // 预留余量：单个事件不会触发缓冲区重新分配
+        buffer.reserve(buffer_size + 4096);
+
+        if (background_writer)
+        {
+            background = new BackgroundWriter(file);
+            background->pending.reserve(buffer_size + 4096);
+        }
+    }
+
+    TraceWriter::~TraceWriter()
+    {
+        delete background;
+    }
+
+    void TraceWriter::begin(int64_t beginning_of_time_us)
+    {
+        buffer += "{\"displayTimeUnit\": \"ns\", \"beginningOfTime\": ";
+        append_integer(beginning_of_time_us);
+        buffer += ", \"traceEvents\": [";
+        events_open = true;
+    }
+
+    void TraceWriter::write_event(const TraceEvent& event, int pid, int tid, TimeStamp ts,
+        const char* phase, int uid)
+    {
+        begin_record();
+        buffer += "{\"name\": ";
+        append_string(event.name);
+        buffer += ", \"ph\": ";
+        append_string(phase);
+        buffer += ", \"cat\": \"";
+        buffer += category_string(event.category);
+        buffer += "\", \"ts\": ";
+        append_timestamp(ts);
+        buffer += ", \"pid\": ";
+        append_integer(pid);
+        buffer += ", \"tid\": ";
+        append_integer(tid);
+        buffer += ", \"args\": {\"UID\": ";
+        append_integer(uid);
+        if (event.args)
+        {
+            for (const auto& [key, value] : *event.args)
+            {
+                buffer += ", ";
+                append_string(key);
+                buffer += ": ";
+                append_string(value);
+            }
+        }
+        buffer += "}}";
+        flush_if_full();
+    }
+
+    void TraceWriter::write_counter(const char* name, int pid, TimeStamp ts, const map_t<std::string, double>& values)
+    {
+        begin_record();
+        buffer += "{\"name\": ";
+        append_string(name);
+        buffer += ", \"ph\": \"C\", \"ts\": ";
+        append_timestamp(ts);
+        buffer += ", \"pid\": ";
+        append_integer(pid);
+        buffer += ", \"args\": {";
+        bool first = true;
+        for (const auto& [key, value] : values)
+        {
+            buffer += first ? "" : ", ";
+            append_string(key);
+            buffer += ": ";
+            append_double(value);
+            first = false;
+        }
+        buffer += "}}";
+        flush_if_full();
+    }
+
+    void TraceWriter::begin_process_metadata(const char* name, int pid, const char* key)
+    {
+        begin_record();
+        buffer += "{\"name\": ";
+        append_string(name);
+        buffer += ", \"ph\": \"M\", \"pid\": ";
+        append_integer(pid);
+        buffer += ", \"args\": {";
+        append_string(key);
+        buffer += ": ";
+    }
+
+    void TraceWriter::write_process_metadata(const char* name, int pid, const char* key, std::string_view value)
+    {
+        begin_process_metadata(name, pid, key);
+        append_string(value);
+        buffer += "}}";
+        flush_if_full();
+    }
+
+    void TraceWriter::write_process_metadata(const char* name, int pid, const char* key, int64_t value)
+    {
+        begin_process_metadata(name, pid, key);
+        append_integer(value);
+        buffer += "}}";
+        flush_if_full();
+    }
+
+    void TraceWriter::begin_key(const char* key)
+    {
+        if (events_open)
+        {
+            buffer += "]";
+            events_open = false;
+        }
+        buffer += ", ";
+        append_string(key);
+        buffer += ": ";
+    }
+
+    void TraceWriter::end()
+    {
+        if (events_open)
+        {
+            buffer += "]";
+            events_open = false;
+        }
+        buffer += "}\n";
+        sync();
+    }
+
+    void TraceWriter::flush()
+    {
+        if (buffer.empty())
+        {
+            return;
+        }
+
+        flushed_bytes += buffer.size();
+        if (background)
+        {
+            background->submit(buffer);  // 换回的缓冲区已清空
+        }
+        else
+        {
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            buffer.clear();
+        }
+    }
+
+    void TraceWriter::sync()
+    {
+        flush();
+        if (background)
+        {
+            background->drain();
+        }
+    }
+
+    void TraceWriter::append_string(std::string_view text)
+    {
+        static const char* hex = "0123456789abcdef";
+
+        buffer += '"';
+        size_t plain = 0;  // 尚未追加的无需转义的字符起点
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            unsigned char c = text[i];
+            if (c != '"' && c != '\\' && c >= 0x20)
+            {
+                continue;
+            }
+
+            // 批量追加前面无需转义的部分
+            buffer.append(text.data() + plain, i - plain);
+            plain = i + 1;
+            switch (c)
+            {
+                case '"':  buffer += "\\\""; break;
+                case '\\': buffer += "\\\\"; break;
+                case '\n': buffer += "\\n"; break;
+                case '\t': buffer += "\\t"; break;
+                default:
+                    buffer += "\\u00";
+                    buffer += hex[c >> 4];
+                    buffer += hex[c & 0xf];
+                    break;
+            }
+        }
+        buffer.append(text.data() + plain, text.size() - plain);
+        buffer += '"';
+    }
+
+    void TraceWriter::append_integer(int64_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr - digits);
+    }
+
+    void TraceWriter::append_double(double value)
+    {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr - digits);
+    }
+
+    void TraceWriter::append_timestamp(TimeStamp ts)
+    {
+        // 整数运算保证精确：12345678ns → 12345.678µs
+        if (ts < 0)
+        {
+            buffer += '-';
+            ts = -ts;
+        }
+        append_integer(ts / 1000);
+        int64_t fraction = ts % 1000;
+        char digits[4] = {'.', char('0' + fraction / 100), char('0' + fraction / 10 % 10), char('0' + fraction % 10)};
+        buffer.append(digits, 4);
+    }
+
+    void TraceWriter::begin_record()
+    {
+        if (event_count++)
+        {
+            buffer += ",\n";
+        }
+    }
+}
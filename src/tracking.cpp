@@ -11,6 +11,7 @@
 
 #include "cpplib.h"              // GCC C++预处理库（cpp_reader等预处理状态机）
 #include "tracking.h"            // 项目内部头文件：本模块的接口声明
+#include "live_status.h"         // 实时状态：包含栈顶和深度
 #include <tree-pass.h>           // GCC优化pass定义（opt_pass结构体和类型枚举）
 
 namespace GccTrace
@@ -26,6 +27,9 @@ namespace GccTrace
         map_t<std::string, int64_t> preprocess_start;  // 文件 -> 开始时间（纳秒）
         map_t<std::string, int64_t> preprocess_end;    // 文件 -> 结束时间（纳秒）
 
+        // 未详细追踪的预处理文件（路径过滤的结果，在第一次进入文件时按缓存查询）
+        set_t<std::string> untraced_preprocess_files;
+
         // 预处理文件栈：跟踪嵌套的文件包含关系
         // 栈顶是当前正在处理的文件
         std::stack<std::string> preprocessing_stack;
@@ -34,20 +38,224 @@ namespace GccTrace
         const char* CIRCULAR_POISON_VALUE = "CIRCULAR_POISON_VALUE";
 
         // 上一个函数解析完成的时间戳
-        // 用于确保连续函数事件的时间戳不重叠
+        // 用于确保连续函数事件的时间戳不重叠，也是下一段声明解析的起点
         TimeStamp last_function_parsed_ts = 0;
 
+        // 上一个命名空间作用域实体（函数、声明、类定义）结束的时间戳
+        // 作为下一个类定义的开始时间：GCC没有"开始定义类型"的回调，
+        // 类内定义的成员函数在类定义内解析，不更新此时间戳
+        TimeStamp last_toplevel_ts = 0;
+
+        // 函数解析开始时间栈（PLUGIN_START_PARSE_FUNCTION记录）
+        // lambda和局部类的成员函数在外层函数体内嵌套解析，因此使用栈
+        std::vector<TimeStamp> function_start_stack;
+
         // ==================== 优化pass追踪数据结构 ====================
         // 优化pass事件结构：存储pass指针和时间跨度
         struct OptPassEvent
         {
-            const opt_pass* pass;  // GCC优化pass对象
-            TimeSpan ts;           // pass执行的时间跨度
+            const opt_pass* pass;      // GCC优化pass对象
+            const void* function;      // pass处理的函数（IPA pass为nullptr）
+            const char* other_file;    // 函数来自未详细追踪的源文件时为该文件名（只计入其汇总）
+            TimeSpan ts;               // pass执行的时间跨度
+            int inlined_calls = 0;     // 内联pass：本次内联的调用数
+            int64_t size_growth = 0;   // 内联pass：调用者估计大小的总增长
         };
 
         OptPassEvent last_pass;                  // 当前正在执行的pass
         std::vector<OptPassEvent> pass_events;   // 所有pass的历史记录
 
+        // 报告中的函数名称：在函数第一次被记录时格式化并缓存（每个函数只格式化一次），
+        // 不在编译结束时格式化——-flto编译中那时语言数据已被free_lang_data释放
+        map_t<const void*, std::string> function_names;
+
+        // 编译异常结束（致命错误、内部编译器错误）：GCC正在处理的函数的tree可能已损坏，
+        // 不再格式化新的函数名称，只使用已缓存的名称
+        bool names_frozen = false;
+
+        // 函数名称（第一次调用时格式化）
+        const std::string& function_name(const void* function)
+        {
+            auto [it, inserted] = function_names.try_emplace(function);
+            if (inserted)
+            {
+                it->second = decl_name(function);
+            }
+            return it->second;
+        }
+
+        // 已输出的pass事件处理的函数：pass事件的"function"参数是函数在列表中的下标，
+        // 输出为passFunctions报告
+        map_t<const void*, int> pass_function_ids;
+        std::vector<const void*> pass_functions;
+
+        // pass执行采样：只完整追踪1/N的函数，并限制记录的pass事件总数
+        // 默认不采样；上限保证巨型翻译单元的内存和输出大小有界
+        struct PassSampling
+        {
+            int rate = 1;                        // 采样率N（每N个函数追踪1个）
+            int64_t max_events = 1000000;        // 记录的pass事件上限（0表示不限制）
+            int64_t sampled_functions = 0;       // 被追踪的函数数量
+            int64_t skipped_functions = 0;       // 未被追踪的函数数量
+            int64_t skipped_executions = 0;      // 未被追踪的函数上执行的pass次数
+            int64_t dropped_events = 0;          // 超过上限被丢弃的pass事件数
+            map_t<const opt_pass*, TimeStamp> dropped_ns; // 被丢弃的pass事件按pass累计的时间（仍计入外推）
+            const void* last_function = nullptr; // 上一个判断过的函数（pass按函数连续执行）
+            bool last_sampled = true;            // 上一个函数的采样结果
+            set_t<const void*> seen_functions;   // 已判断过的函数（用于统计函数数量）
+        };
+        PassSampling sampling;
+
+        EventCategory pass_type(opt_pass_type type);
+
+        // 输出一个已结束的pass事件（编译过程中流式写入，由写入器的后台线程落盘）
+        void write_pass_event(const OptPassEvent& event)
+        {
+            EventCategory category = pass_type(event.pass->type);
+
+            // 跳过会被过滤掉的事件，避免构造参数
+            if (!should_emit_event(category, event.ts))
+            {
+                record_dropped_event(category, nullptr, event.ts);
+                return;
+            }
+
+            // 准备pass的额外参数
+            map_t<std::string, std::string> args;
+            args["static_pass_number"] = std::to_string(event.pass->static_pass_number);
+            if (event.function && (!names_frozen || function_names.count(event.function)))
+            {
+                auto [it, inserted] = pass_function_ids.try_emplace(event.function,
+                    static_cast<int>(pass_functions.size()));
+                if (inserted)
+                {
+                    pass_functions.push_back(event.function);
+                    function_name(event.function);
+                }
+                args["function"] = std::to_string(it->second);
+            }
+
+            // 内联pass：本次内联的调用数和调用者估计大小的总增长（详见inlineReport）
+            if (event.inlined_calls)
+            {
+                args["inlined_calls"] = std::to_string(event.inlined_calls);
+                args["size_growth"] = std::to_string(event.size_growth);
+            }
+
+            // 创建并添加pass事件
+            add_event(TraceEvent{
+                event.pass->name,                // pass名称
+                category,                        // pass类型
+                event.ts,                        // 时间跨度
+                std::move(args)                  // 额外参数（移动语义）
+                });
+        }
+
+        // 结束当前pass的追踪，保存到历史记录并输出事件（超过上限时丢弃）
+        void finish_last_pass(TimeStamp now)
+        {
+            if (!last_pass.pass)
+            {
+                return;
+            }
+
+            last_pass.ts.end = now;
+            if (last_pass.other_file)
+            {
+                record_dropped_event(pass_type(last_pass.pass->type), last_pass.other_file, last_pass.ts);
+            }
+            else if (sampling.max_events && static_cast<int64_t>(pass_events.size()) >= sampling.max_events)
+            {
+                // 不保存事件，但时间仍按pass累计，外推的估计不因上限而偏低
+                sampling.dropped_events++;
+                sampling.dropped_ns[last_pass.pass] += (last_pass.ts.end - last_pass.ts.start) *
+                    (last_pass.function ? sampling.rate : 1);
+            }
+            else
+            {
+                pass_events.emplace_back(last_pass);
+                write_pass_event(last_pass);
+            }
+            last_pass.pass = nullptr;
+        }
+
+        // 函数生成代码大小：在final pass记录
+        struct CodeSize
+        {
+            int64_t rtl_insns = 0;   // final时的RTL指令数（不含调试指令）
+            int64_t asm_bytes = -1;  // 输出的汇编文本字节数（-1表示无法获取）
+        };
+        map_t<const void*, CodeSize> code_sizes;  // 函数 -> 代码大小
+
+        // 内联决策记录：一个内联pass中某个调用者内联的所有被调用者
+        // 名称在记录时格式化（function_name缓存），编译结束时不再访问tree
+        struct InlineRecord
+        {
+            const opt_pass* pass;              // 内联pass（einline或inline）
+            const std::string* caller;         // 调用者名称（指向function_names）
+            std::vector<std::pair<const std::string*, int>> callees; // 被内联的函数名称及内联的调用数（包括嵌套内联）
+            int size_before;                   // 内联前调用者的估计大小（-1表示未知）
+            int size_after;                    // 内联后调用者的估计大小（-1表示未知）
+        };
+        std::vector<InlineRecord> inline_records;  // 所有内联决策记录
+
+        // ==================== 插件开销追踪数据结构 ====================
+        constexpr int OVERHEAD_SOURCE_COUNT = (int)OverheadSource::COUNT;
+
+        // 计数器轨道采样间隔：10毫秒
+        constexpr TimeStamp OVERHEAD_SAMPLE_INTERVAL_NS = 10000000;
+
+        // 每个来源的调用次数和累计耗时
+        int64_t overhead_calls[OVERHEAD_SOURCE_COUNT] = {};
+        TimeStamp overhead_ns[OVERHEAD_SOURCE_COUNT] = {};
+
+        // 计数器轨道采样点：时间戳和当时各来源的累计耗时
+        struct OverheadSample
+        {
+            TimeStamp ts;
+            TimeStamp ns[OVERHEAD_SOURCE_COUNT];
+        };
+        std::vector<OverheadSample> overhead_samples;
+
+        // 开销来源名称（计数器轨道和汇总报告中的键名）
+        const char* overhead_source_name(int source)
+        {
+            static const char* names[OVERHEAD_SOURCE_COUNT] = {
+                "start_unit",
+                "file_change",
+                "finish_decl",
+                "start_parse_function",
+                "finish_parse_function",
+                "finish_type",
+                "pass_execution",
+                "all_ipa_passes_start",
+                "write_events"
+            };
+            return names[source];
+        }
+
+        // 保存一个采样点
+        void sample_overhead(TimeStamp now)
+        {
+            OverheadSample sample;
+            sample.ts = now;
+            for (int i = 0; i < OVERHEAD_SOURCE_COUNT; i++)
+            {
+                sample.ns[i] = overhead_ns[i];
+            }
+            overhead_samples.push_back(sample);
+        }
+
+        // ==================== LTO追踪数据结构 ====================
+        // LTO报告中列出名称的函数数量上限（大型WPA有几十万个函数，只报告数量）
+        constexpr size_t LTO_REPORT_MAX_FUNCTIONS = 1000;
+
+        LtoUnit lto{LtoMode::NONE, {}, -1};               // 当前进程的LTO编译单元信息
+        std::vector<std::string> partition_functions;     // 本进程处理的函数名称（最多LTO_REPORT_MAX_FUNCTIONS个）
+        int64_t partition_function_count = 0;             // 本进程处理的函数数量
+        int partition_variable_count = 0;                 // 本进程处理的变量数量
+        std::vector<std::string> ltrans_files;            // WPA划分出的LTRANS分区文件
+
         // ==================== 文件名规范化系统 ====================
         // 将绝对路径转换为相对包含路径，便于分析和可视化
 
@@ -123,6 +331,59 @@ namespace GccTrace
             }
         }
 
+        // ==================== 源文件路径过滤 ====================
+        std::vector<std::string> include_paths;  // 只详细追踪这些路径下的文件（为空表示不限制）
+        std::vector<std::string> exclude_paths;  // 不详细追踪这些路径下的文件（优先于include_paths）
+
+        // 文件的过滤结果：按GCC驻留的文件名指针缓存，每个文件只匹配一次
+        struct FileFilter
+        {
+            bool traced;         // 是否详细追踪
+            const char* name;    // 规范化文件名（"other"汇总的键）
+        };
+        map_t<const char*, FileFilter> file_filters;
+
+        // 路径是否位于某个过滤路径之下（前缀按路径分隔符边界比较）
+        bool under_path(const std::string& file, const std::vector<std::string>& paths)
+        {
+            for (const auto& path : paths)
+            {
+                if (file.starts_with(path) &&
+                    (file.size() == path.size() || path.back() == '/' || file[path.size()] == '/'))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 按真实路径匹配过滤规则（不缓存）
+        bool path_filter_accepts(const char* file_name)
+        {
+            if (include_paths.empty() && exclude_paths.empty())
+            {
+                return true;
+            }
+
+            char* real_file_name = realpath(file_name, nullptr);
+            std::string path = real_file_name ? real_file_name : file_name;
+            free(real_file_name);
+
+            return (include_paths.empty() || under_path(path, include_paths)) && !under_path(path, exclude_paths);
+        }
+
+        // 查询（首次时匹配并缓存）文件的过滤结果
+        const FileFilter& file_filter(const char* file_name)
+        {
+            auto it = file_filters.find(file_name);
+            if (it == file_filters.end())
+            {
+                it = file_filters.emplace(file_name,
+                    FileFilter{path_filter_accepts(file_name), normalized_file_name(file_name)}).first;
+            }
+            return it->second;
+        }
+
         // 将GCC的opt_pass_type转换为项目内部的EventCategory
         EventCategory pass_type(opt_pass_type type)
         {
@@ -142,24 +403,212 @@ namespace GccTrace
 
         // ==================== 函数和作用域事件存储 ====================
 
-        // 作用域事件结构：命名空间、类/结构体的追踪
+        // 作用域树节点：命名空间、类/结构体，按驻留的ScopeId索引
+        // 同一个作用域（包括重新打开的命名空间）只有一个节点，汇总数据精确
+        struct ScopeNode
+        {
+            const void* key;                // GCC的tree节点指针（驻留键，也用于延迟格式化名称）
+            ScopeId parent;                 // 父作用域ID（全局作用域的父节点是自身）
+            EventCategory type;             // 作用域类型（STRUCT 或 NAMESPACE）
+            std::string name{};             // 作用域名称（延迟格式化，只为输出的作用域填充）
+            int function_count = 0;         // 直接定义在此作用域的函数数量
+            TimeStamp function_ns = 0;      // 直接定义在此作用域的函数解析时间
+            TimeStamp total_function_ns = 0;// 包含所有子作用域的函数解析时间
+            TimeStamp definition_ns = 0;    // 类定义本身的解析时间（仅STRUCT）
+            TimeStamp total_ns = 0;         // 包含所有子作用域的独占解析时间（不重复计算）
+        };
+
+        // 所有作用域节点，下标即ScopeId，0号为全局作用域
+        std::vector<ScopeNode> scopes{ScopeNode{nullptr, GLOBAL_SCOPE, EventCategory::NAMESPACE, "::"}};
+
+        // tree节点 -> ScopeId 的驻留表
+        map_t<const void*, ScopeId> scope_ids;
+
+        // 作用域是否出现在汇总报告中（跳过只作为中间层出现、没有任何解析开销的作用域）
+        bool has_rollup(ScopeId id)
+        {
+            return id == GLOBAL_SCOPE || scopes[id].total_function_ns != 0 || scopes[id].total_ns != 0;
+        }
+
+        // 格式化作用域名称（只格式化一次）
+        const char* scope_name(ScopeId id)
+        {
+            ScopeNode& node = scopes[id];
+            if (node.name.empty())
+            {
+                node.name = decl_name(node.key);
+            }
+            return node.name.data();
+        }
+
+        // 将时间累加到作用域及其所有祖先作用域
+        // 参数：
+        //   scope  - 起始作用域
+        //   member - 要累加的ScopeNode字段
+        //   ns     - 累加的时间（纳秒）
+        void add_to_scope_chain(ScopeId scope, TimeStamp ScopeNode::*member, TimeStamp ns)
+        {
+            for (ScopeId id = scope;; id = scopes[id].parent)
+            {
+                scopes[id].*member += ns;
+                if (id == GLOBAL_SCOPE)
+                {
+                    break;
+                }
+            }
+        }
+
+        // 作用域事件结构：连续解析同一命名空间的时间段
         struct ScopeEvent
         {
-            std::string name;       // 作用域名称
-            EventCategory type;     // 作用域类型（STRUCT 或 NAMESPACE）
+            ScopeId scope;          // 作用域ID
             TimeSpan ts;            // 时间跨度
         };
         std::vector<ScopeEvent> scope_events;  // 所有作用域事件
 
+        // 当前打开的命名空间链（由外到内）：作用域ID和对应的scope_events下标
+        std::vector<std::pair<ScopeId, size_t>> open_scopes;
+
+        // 类/结构体定义事件：由PLUGIN_FINISH_TYPE记录的真实类定义
+        struct TypeEvent
+        {
+            ScopeId scope;          // 类型自身的作用域ID
+            const char* file_name;  // 定义所在的源文件
+            int member_count;       // 成员数量（数据成员、成员函数、成员模板）
+            int base_count;         // 直接基类数量
+            TimeSpan ts;            // 定义的时间跨度
+        };
+        std::vector<TypeEvent> type_events;  // 所有类定义事件
+
+        // 沿作用域链取出所有命名空间（由外到内，类作用域由PLUGIN_FINISH_TYPE追踪，这里跳过）
+        std::vector<ScopeId> namespace_chain(ScopeId scope)
+        {
+            std::vector<ScopeId> chain;
+            for (ScopeId id = scope; id != GLOBAL_SCOPE; id = scopes[id].parent)
+            {
+                if (scopes[id].type == EventCategory::NAMESPACE)
+                {
+                    chain.insert(chain.begin(), id);
+                }
+            }
+            return chain;
+        }
+
+        // 关闭当前打开链中不再连续的命名空间，返回与chain的公共前缀长度
+        size_t close_scopes(const std::vector<ScopeId>& chain)
+        {
+            size_t common = 0;
+            while (common < chain.size() && common < open_scopes.size() &&
+                open_scopes[common].first == chain[common])
+            {
+                common++;
+            }
+            open_scopes.resize(common);
+            return common;
+        }
+
+        // 记录命名空间作用域事件：沿作用域链取出所有命名空间（由外到内），
+        // 与当前打开的命名空间链比较，公共前缀扩展结束时间，其余关闭后重新打开
+        void record_scope(ScopeId scope, TimeSpan ts)
+        {
+            std::vector<ScopeId> chain = namespace_chain(scope);
+            size_t common = close_scopes(chain);
+
+            // 外层作用域比内层多留1纳秒，保证Chrome Tracing中的嵌套关系
+            for (size_t i = 0; i < chain.size(); i++)
+            {
+                TimeStamp margin = static_cast<TimeStamp>(chain.size() - i);
+                if (i < common)
+                {
+                    // 扩展现有作用域的时间范围
+                    scope_events[open_scopes[i].second].ts.end = ts.end + margin;
+                }
+                else
+                {
+                    // 创建新的作用域事件（微调时间避免重叠）
+                    open_scopes.emplace_back(chain[i], scope_events.size());
+                    scope_events.emplace_back(chain[i], TimeSpan{ts.start - margin, ts.end + margin});
+                }
+            }
+        }
+
         // 函数事件结构：函数解析的追踪
+        // 解析时只保存tree节点，函数签名延迟到确定事件会被输出时才格式化
+        // （大多数函数事件会被最小事件长度过滤掉，格式化模板函数签名的开销很大）
         struct FunctionEvent
         {
-            std::string name;      // 函数签名（包含命名空间和类名）
+            const void* decl;      // GCC的tree节点指针（用于延迟格式化函数签名）
             const char* file_name; // 定义所在的源文件
             TimeSpan ts;           // 解析时间跨度
+            std::string name{};    // 函数签名（包含命名空间和类名，延迟格式化）
         };
         std::vector<FunctionEvent> function_events;  // 所有函数事件
 
+        // 声明解析事件：两个最外层函数之间的解析时间
+        // （类定义、变量声明、命名空间作用域代码等）
+        std::vector<TimeSpan> declaration_events;
+
+        // 记录从上一个事件结束到now之间的声明解析时间
+        // 与上一段声明事件连续时直接扩展，避免每个声明生成一个事件
+        void record_declarations(TimeStamp now)
+        {
+            if (now <= last_function_parsed_ts + 3)
+            {
+                return;
+            }
+
+            if (!declaration_events.empty() && declaration_events.back().end == last_function_parsed_ts)
+            {
+                declaration_events.back().end = now;
+            }
+            else
+            {
+                // +3纳秒避免与上一个事件重叠
+                declaration_events.emplace_back(last_function_parsed_ts + 3, now);
+            }
+        }
+
+        // 前端事件是否已写入（前端结束时写入一次，之后不再变化）
+        bool frontend_events_written = false;
+
+        // 函数和作用域名称是否已格式化（前端中途退出时tree可能已不可用，不再格式化）
+        bool names_resolved = false;
+
+        // 写入已结束预处理的文件（写入后移除，主文件等仍在栈中的文件留待之后写入）
+        void write_finished_preprocess_files()
+        {
+            for (auto it = preprocess_start.begin(); it != preprocess_start.end();)
+            {
+                const auto& [file, start] = *it;
+
+                // 跳过循环包含的毒丸记录和尚未结束的文件
+                auto end = preprocess_end.find(file);
+                if (file == CIRCULAR_POISON_VALUE || end == preprocess_end.end())
+                {
+                    ++it;
+                    continue;
+                }
+
+                // 未详细追踪的源文件：只计入该文件的汇总
+                if (untraced_preprocess_files.contains(file))
+                {
+                    record_dropped_event(EventCategory::PREPROCESS, normalized_file_name(file.data()),
+                        {start, end->second});
+                }
+                else
+                {
+                    // 创建并添加预处理事件
+                    add_event(TraceEvent{
+                        normalized_file_name(file.data()),  // 使用规范化文件名
+                        EventCategory::PREPROCESS,          // 事件类别：预处理
+                        {start, end->second},               // 时间跨度
+                        std::nullopt                        // 无额外参数
+                        });
+                }
+                it = preprocess_start.erase(it);
+            }
+        }
+
     } // 匿名命名空间结束
 
     // ==================== 公共接口实现 ====================
@@ -173,6 +622,7 @@ namespace GccTrace
         {
             end_preprocess_file();                      // 结束当前文件的预处理
             last_function_parsed_ts = ns_from_start();  // 更新时间戳基准
+            last_toplevel_ts = last_function_parsed_ts;
         }
     }
 
@@ -201,13 +651,15 @@ namespace GccTrace
         }
 
         // 记录文件的开始时间（如果是第一次处理）
-        if (!preprocess_start.contains(file_name))
+        bool first_entry = !preprocess_start.contains(file_name);
+        if (first_entry)
         {
             preprocess_start[file_name] = now;
         }
 
         // 将文件压入栈中（表示开始处理）
         preprocessing_stack.push(file_name);
+        live_status_include(file_name, static_cast<int>(preprocessing_stack.size()));
 
         // 如果pfile有效，获取包含路径信息用于文件名规范化
         if (pfile)
@@ -244,6 +696,12 @@ namespace GccTrace
                 free(real_file_name);
             }
         }
+
+        // 路径过滤：按GCC驻留的文件名指针缓存（在注册包含位置之后，缓存的是规范化名称）
+        if (first_entry && file_name != CIRCULAR_POISON_VALUE && !is_traced_file(file_name))
+        {
+            untraced_preprocess_files.insert(file_name);
+        }
     }
 
     // 结束预处理一个文件（离开#include）
@@ -259,9 +717,12 @@ namespace GccTrace
 
         // 弹出栈顶文件（表示处理完成）
         preprocessing_stack.pop();
+        live_status_include(preprocessing_stack.empty() ? nullptr : preprocessing_stack.top().data(),
+            static_cast<int>(preprocessing_stack.size()));
 
         // 更新函数解析时间戳基准（+3纳秒避免重叠）
         last_function_parsed_ts = now + 3;
+        last_toplevel_ts = last_function_parsed_ts;
     }
 
     // 写入所有预处理事件到输出系统
@@ -270,139 +731,860 @@ namespace GccTrace
         // 确保预处理阶段完全结束（安全措施）
         finish_preprocessing_stage();
 
-        // 遍历所有预处理文件
-        for (const auto& [file, start] : preprocess_start)
-        {
-            // 跳过循环包含的毒丸记录
-            if (file == CIRCULAR_POISON_VALUE)
-            {
-                continue;
-            }
-
-            // 获取文件的结束时间
-            int64_t end = preprocess_end.at(file);
-
-            // 创建并添加预处理事件
-            add_event(TraceEvent{
-                normalized_file_name(file.data()),  // 使用规范化文件名
-                EventCategory::PREPROCESS,          // 事件类别：预处理
-                {start, end},                       // 时间跨度
-                std::nullopt                        // 无额外参数
-                });
-        }
+        write_finished_preprocess_files();
     }
 
     // 开始追踪一个优化pass的执行
-    void start_opt_pass(const opt_pass* pass)
+    void start_opt_pass(const opt_pass* pass, const void* function, const char* file_name)
     {
         auto now = ns_from_start();  // 获取当前时间
 
         // 结束上一个pass的追踪（如果有的话）
-        last_pass.ts.end = now;
-        if (last_pass.pass)
-        {
-            // 将上一个pass保存到历史记录
-            pass_events.emplace_back(last_pass);
-        }
+        finish_last_pass(now);
 
-        // 开始新pass的追踪
-        last_pass.pass = pass;           // 设置pass指针
-        last_pass.ts.start = now + 1;    // 开始时间（+1纳秒避免重叠）
+        // pass边界：距上次落盘超过间隔时把已写入的事件刷到文件
+        flush_output();
+
+        // 开始新pass的追踪（开始时间+1纳秒避免重叠）
+        const char* other_file = is_traced_file(file_name) ? nullptr : file_filter(file_name).name;
+        last_pass = OptPassEvent{pass, function, other_file, TimeSpan{now + 1, now + 1}};
     }
 
-    // 写入所有优化pass事件到输出系统
-    void write_opt_pass_events()
+    // 添加源文件路径过滤
+    // 参数：
+    //   path    - 目录或文件路径（存在时解析为真实路径）
+    //   include - true为只详细追踪该路径，false为不详细追踪该路径
+    void add_path_filter(const char* path, bool include)
     {
-        // 遍历所有记录的pass事件
-        for (const auto& event : pass_events)
-        {
-            // 准备pass的额外参数
-            map_t<std::string, std::string> args;
-            args["static_pass_number"] = std::to_string(event.pass->static_pass_number);
+        char* real_path = realpath(path, nullptr);
+        (include ? include_paths : exclude_paths).emplace_back(real_path ? real_path : path);
+        free(real_path);
+    }
 
-            // 创建并添加pass事件
-            add_event(TraceEvent{
-                event.pass->name,                // pass名称
-                pass_type(event.pass->type),     // pass类型转换
-                event.ts,                        // 时间跨度
-                std::move(args)                  // 额外参数（移动语义）
-                });
+    // 判断源文件是否详细追踪（没有过滤规则或文件未知时总是追踪）
+    bool is_traced_file(const char* file_name)
+    {
+        if (!file_name || (include_paths.empty() && exclude_paths.empty()))
+        {
+            return true;
         }
+        return file_filter(file_name).traced;
     }
 
-    // 处理函数解析完成事件
-    // 参数：
-    //   info - 从GCC回调传递来的函数信息
-    void end_parse_function(FinishedFunction info)
+    // 设置pass执行采样
+    void configure_pass_sampling(int sample_rate, int64_t max_events)
     {
-        // 静态变量：记录上一个函数是否有作用域
-        static bool did_last_function_have_scope = false;
+        sampling.rate = sample_rate > 1 ? sample_rate : 1;
+        sampling.max_events = max_events > 0 ? max_events : 0;
+    }
 
-        TimeStamp now = ns_from_start();  // 获取当前时间
+    // 判断是否追踪函数上执行的pass
+    bool sample_function(const void* function, uint32_t hash)
+    {
+        if (sampling.rate <= 1)
+        {
+            return true;
+        }
 
-        // 由于Chrome Tracing的UI bug，我们不能让不同事件在同一时间开始和结束
-        // 因此调整事件的时间戳，避免完全重叠
+        // 同一函数的pass连续执行，直接复用上一次的判断
+        if (function == sampling.last_function)
+        {
+            if (!sampling.last_sampled)
+            {
+                sampling.skipped_executions++;
+            }
+            return sampling.last_sampled;
+        }
 
-        // 计算函数解析的时间跨度（+3纳秒避免与上一个事件重叠）
-        TimeSpan ts{last_function_parsed_ts + 3, now};
-        last_function_parsed_ts = now;  // 更新基准时间
+        // 乘法散列打散哈希值的低位，再按采样率取模
+        bool sampled = (hash * 2654435761u) % static_cast<uint32_t>(sampling.rate) == 0;
+        if (sampling.seen_functions.insert(function).second)
+        {
+            (sampled ? sampling.sampled_functions : sampling.skipped_functions)++;
+        }
+        sampling.last_function = function;
+        sampling.last_sampled = sampled;
+        if (!sampled)
+        {
+            sampling.skipped_executions++;
+        }
+        return sampled;
+    }
+
+    // 跳过一个未被采样的pass：只结束上一个被追踪的pass
+    void skip_opt_pass()
+    {
+        if (last_pass.pass)
+        {
+            finish_last_pass(ns_from_start());
+        }
+    }
 
-        // 存储函数事件
-        function_events.emplace_back(info.name, info.file_name, ts);
+    // 写入pass采样报告：按pass外推未被追踪函数上的执行时间
+    void write_sampling_report()
+    {
+        if (sampling.rate <= 1 && !sampling.dropped_events)
+        {
+            return;
+        }
 
-        // 处理作用域事件（如果函数有作用域）
-        if (info.scope_name)
+        // 按pass汇总追踪到的时间：函数级pass按采样率外推，IPA pass总是完整追踪
+        struct PassTotal
         {
-            // 检查是否可以扩展上一个作用域事件
-            if (!scope_events.empty() && did_last_function_have_scope &&
-                scope_events.back().name == info.scope_name)
+            int64_t executions = 0;
+            TimeStamp recorded_ns = 0;
+            TimeStamp dropped_ns = 0;     // 超过上限未保存的事件的时间（已按采样率外推）
+            TimeStamp estimated_ns = 0;
+        };
+        map_t<const opt_pass*, PassTotal> totals;
+        std::vector<const opt_pass*> order;
+        TimeStamp recorded_ns = 0;
+        TimeStamp estimated_ns = 0;
+        for (const auto& event : pass_events)
+        {
+            auto [it, inserted] = totals.try_emplace(event.pass);
+            if (inserted)
             {
-                // 扩展现有作用域的时间范围（+1纳秒避免重叠）
-                scope_events.back().ts.end = ts.end + 1;
+                order.push_back(event.pass);
             }
-            else
+
+            TimeStamp ns = event.ts.end - event.ts.start;
+            TimeStamp estimate = event.function ? ns * sampling.rate : ns;
+            it->second.executions++;
+            it->second.recorded_ns += ns;
+            it->second.estimated_ns += estimate;
+            recorded_ns += ns;
+            estimated_ns += estimate;
+        }
+
+        // 超过上限被丢弃的事件：时间已在丢弃时按采样率外推
+        for (const auto& [pass, ns] : sampling.dropped_ns)
+        {
+            auto [it, inserted] = totals.try_emplace(pass);
+            if (inserted)
             {
-                // 创建新的作用域事件（微调时间避免重叠）
-                scope_events.emplace_back(
-                    info.scope_name,                    // 作用域名称
-                    info.scope_type,                    // 作用域类型
-                    TimeSpan{ts.start - 1, ts.end + 1}  // 时间跨度
-                );
+                order.push_back(pass);
             }
-            did_last_function_have_scope = true;
+            it->second.dropped_ns += ns;
+            it->second.estimated_ns += ns;
+            estimated_ns += ns;
         }
-        else
+
+        json::object* report = new json::object();
+        report->set("sample_rate", new json::integer_number(sampling.rate));
+        report->set("max_events", new json::integer_number(sampling.max_events));
+        report->set("sampled_functions", new json::integer_number(sampling.sampled_functions));
+        report->set("skipped_functions", new json::integer_number(sampling.skipped_functions));
+        report->set("skipped_executions", new json::integer_number(sampling.skipped_executions));
+        report->set("dropped_events", new json::integer_number(sampling.dropped_events));
+        report->set("recorded_ns", new json::integer_number(recorded_ns));
+        report->set("estimated_ns", new json::integer_number(estimated_ns));
+
+        json::array* passes = new json::array();
+        for (const opt_pass* pass : order)
         {
-            did_last_function_have_scope = false;
+            const PassTotal& total = totals[pass];
+            json::object* entry = new json::object();
+            entry->set("name", new json::string(pass->name));
+            entry->set("static_pass_number", new json::integer_number(pass->static_pass_number));
+            entry->set("executions", new json::integer_number(total.executions));
+            entry->set("recorded_ns", new json::integer_number(total.recorded_ns));
+            if (total.dropped_ns)
+            {
+                entry->set("dropped_ns", new json::integer_number(total.dropped_ns));
+            }
+            entry->set("estimated_ns", new json::integer_number(total.estimated_ns));
+            passes->append(entry);
         }
+        report->set("passes", passes);
+        add_report("passSampling", report);
     }
 
-    // 写入所有作用域事件到输出系统
-    void write_all_scopes()
+    // 记录内联pass中一个调用者的内联决策
+    void record_inlining(const void* caller, std::vector<const void*> callees, int size_before, int size_after)
     {
-        // 遍历所有作用域事件
-        for (const auto& [name, type, ts] : scope_events)
+        // 内联pass本身超过事件上限被丢弃，或调用者来自未详细追踪的源文件时不记录
+        if (!last_pass.pass || last_pass.other_file)
         {
-            // 创建并添加作用域事件
-            add_event(TraceEvent{
-                name.data(),    // 作用域名称
-                type,           // 作用域类型
-                ts,             // 时间跨度
-                std::nullopt    // 无额外参数
-                });
+            return;
         }
+
+        // 汇总到当前内联pass事件的参数
+        last_pass.inlined_calls += static_cast<int>(callees.size());
+        if (size_before >= 0 && size_after >= 0)
+        {
+            last_pass.size_growth += size_after - size_before;
+        }
+
+        // 名称现在格式化：编译结束时-flto编译的语言数据已被释放
+        // 同一函数的多个调用点合并为一项（保持第一次出现的顺序）
+        std::vector<std::pair<const std::string*, int>> callee_names;
+        for (const void* callee : callees)
+        {
+            const std::string* name = &function_name(callee);
+            size_t i = 0;
+            while (i < callee_names.size() && callee_names[i].first != name)
+            {
+                i++;
+            }
+            if (i < callee_names.size())
+            {
+                callee_names[i].second++;
+            }
+            else
+            {
+                callee_names.emplace_back(name, 1);
+            }
+        }
+        inline_records.emplace_back(last_pass.pass, &function_name(caller), std::move(callee_names),
+            size_before, size_after);
+    }
+
+    // 写入内联报告
+    void write_inline_report()
+    {
+        json::array* report = new json::array();
+        for (const auto& [pass, caller, callees, size_before, size_after] : inline_records)
+        {
+            json::object* entry = new json::object();
+            entry->set("pass", new json::string(pass->name));
+            entry->set("caller", new json::string(caller->data()));
+            entry->set("size_before", new json::integer_number(size_before));
+            entry->set("size_after", new json::integer_number(size_after));
+            if (size_before >= 0 && size_after >= 0)
+            {
+                entry->set("growth", new json::integer_number(size_after - size_before));
+            }
+
+            json::array* inlined = new json::array();
+            for (const auto& [callee, calls] : callees)
+            {
+                json::object* inlined_callee = new json::object();
+                inlined_callee->set("function", new json::string(callee->data()));
+                inlined_callee->set("calls", new json::integer_number(calls));
+                inlined->append(inlined_callee);
+            }
+            entry->set("inlined", inlined);
+            report->append(entry);
+        }
+        add_report("inlineReport", report);
+    }
+
+    // 写入pass事件处理的函数名称
+    void write_pass_function_report()
+    {
+        json::array* report = new json::array();
+        for (const void* function : pass_functions)
+        {
+            report->append(new json::string(function_name(function).data()));
+        }
+        add_report("passFunctions", report);
+    }
+
+    // 记录函数的生成代码大小
+    void record_function_code_size(const void* function, int64_t rtl_insns, int64_t asm_bytes)
+    {
+        // 同一函数的多个克隆（构造函数变体、IPA克隆）累加到原始函数
+        // 生成了代码的函数都会出现在函数报告中：名称现在格式化（每个函数一次），编译结束时不再访问tree
+        auto [it, inserted] = code_sizes.try_emplace(function);
+        if (inserted)
+        {
+            function_name(function);
+        }
+        CodeSize& size = it->second;
+        size.rtl_insns += rtl_insns;
+        if (asm_bytes >= 0)
+        {
+            size.asm_bytes = (size.asm_bytes < 0 ? 0 : size.asm_bytes) + asm_bytes;
+        }
+    }
+
+    // 写入函数报告：解析时间、优化时间与生成代码大小的关联
+    void write_function_report()
+    {
+        // 按函数汇总优化时间（只统计作用于单个函数的GIMPLE/RTL pass）
+        map_t<const void*, TimeStamp> opt_times;
+        for (const auto& event : pass_events)
+        {
+            if (event.function)
+            {
+                opt_times[event.function] += event.ts.end - event.ts.start;
+            }
+        }
+
+        json::array* report = new json::array();
+        set_t<const void*> reported;
+
+        // 添加一条函数记录
+        auto append = [&](const void* decl, const char* name, const char* file_name, TimeStamp parse_ns)
+        {
+            auto opt = opt_times.find(decl);
+            auto size = code_sizes.find(decl);
+            TimeStamp opt_ns = opt != opt_times.end() ? opt->second : 0;
+
+            // 只报告生成了代码的函数，以及解析+优化时间足以单独输出的函数
+            if (size == code_sizes.end() &&
+                !should_emit_event(EventCategory::FUNCTION, TimeSpan{0, parse_ns + opt_ns}))
+            {
+                return;
+            }
+            reported.insert(decl);
+
+            json::object* entry = new json::object();
+            entry->set("name", new json::string(name ? name : function_name(decl).data()));
+            if (file_name)
+            {
+                entry->set("file", new json::string(normalized_file_name(file_name)));
+            }
+            entry->set("parse_ns", new json::integer_number(parse_ns));
+            entry->set("opt_ns", new json::integer_number(opt_ns));
+            if (size != code_sizes.end())
+            {
+                entry->set("rtl_insns", new json::integer_number(size->second.rtl_insns));
+                if (size->second.asm_bytes >= 0)
+                {
+                    entry->set("asm_bytes", new json::integer_number(size->second.asm_bytes));
+                }
+            }
+            report->append(entry);
+        };
+
+        // 前端解析过的函数：复用已经格式化的函数签名
+        for (const auto& event : function_events)
+        {
+            if (!reported.contains(event.decl))
+            {
+                append(event.decl, event.name.empty() ? nullptr : event.name.data(),
+                    event.file_name, event.ts.end - event.ts.start);
+            }
+        }
+
+        // 没有解析事件但生成了代码的函数（如thunk）
+        for (const auto& [decl, size] : code_sizes)
+        {
+            if (!reported.contains(decl))
+            {
+                append(decl, nullptr, nullptr, 0);
+            }
+        }
+
+        add_report("functionReport", report);
+    }
+
+    // 记录一次插件自身的开销
+    void record_overhead(OverheadSource source, TimeStamp start)
+    {
+        TimeStamp now = ns_from_start();
+        overhead_calls[(int)source]++;
+        overhead_ns[(int)source] += now - start;
+
+        // 间隔足够长时保存一个采样点
+        if (overhead_samples.empty() || now - overhead_samples.back().ts >= OVERHEAD_SAMPLE_INTERVAL_NS)
+        {
+            sample_overhead(now);
+        }
+    }
+
+    // 写入插件开销报告
+    void write_overhead_report()
+    {
+        TimeStamp now = ns_from_start();
+        sample_overhead(now);
+
+        // 计数器轨道：各来源的累计开销（毫秒）
+        for (const auto& sample : overhead_samples)
+        {
+            map_t<std::string, double> values;
+            for (int i = 0; i < OVERHEAD_SOURCE_COUNT; i++)
+            {
+                if (overhead_calls[i])
+                {
+                    values[overhead_source_name(i)] = static_cast<double>(sample.ns[i]) * 0.000001;
+                }
+            }
+            add_counter_event("gperf overhead", sample.ts, values);
+        }
+
+        // 汇总：每个来源的调用次数和总耗时
+        TimeStamp total_ns = 0;
+        json::object* sources = new json::object();
+        for (int i = 0; i < OVERHEAD_SOURCE_COUNT; i++)
+        {
+            if (!overhead_calls[i])
+            {
+                continue;
+            }
+            json::object* entry = new json::object();
+            entry->set("calls", new json::integer_number(overhead_calls[i]));
+            entry->set("total_ns", new json::integer_number(overhead_ns[i]));
+            sources->set(overhead_source_name(i), entry);
+            total_ns += overhead_ns[i];
+        }
+
+        json::object* overhead = new json::object();
+        overhead->set("total_ns", new json::integer_number(total_ns));
+        overhead->set("tu_ns", new json::integer_number(now));
+        overhead->set("fraction", new json::float_number(now ? static_cast<double>(total_ns) / now : 0.0));
+        overhead->set("sources", sources);
+
+        json::object* metadata = new json::object();
+        metadata->set("gperf_overhead", overhead);
+        add_report("metadata", metadata);
+    }
+
+    // 设置LTO编译单元信息
+    void set_lto_unit(LtoUnit unit)
+    {
+        lto = std::move(unit);
+    }
+
+    // 获取LTO编译单元信息
+    const LtoUnit& lto_unit()
+    {
+        return lto;
+    }
+
+    // 记录本进程处理的符号
+    void record_partition_symbols(std::vector<const void*> functions, int variable_count)
+    {
+        // 名称在此格式化（lto1中为反修饰的汇编名称），编译结束时不再访问tree
+        partition_function_count = static_cast<int64_t>(functions.size());
+        for (size_t i = 0; i < functions.size() && i < LTO_REPORT_MAX_FUNCTIONS; i++)
+        {
+            partition_functions.push_back(decl_name(functions[i]));
+        }
+        partition_variable_count = variable_count;
+    }
+
+    // 记录WPA划分出的LTRANS分区
+    void record_ltrans_partitions(std::vector<std::string> files)
+    {
+        ltrans_files = std::move(files);
+    }
+
+    // lto1进程的名称：lto1-wpa <run> / lto1-ltrans <run> #N
+    std::string lto_process_name()
+    {
+        static const char* mode_strings[] = {"none", "lto", "wpa", "ltrans"};
+        std::string process_name = std::string("lto1-") + mode_strings[(int)lto.mode] + " " + lto.run;
+        if (lto.mode == LtoMode::LTRANS)
+        {
+            process_name += " #" + std::to_string(lto.partition);
+        }
+        return process_name;
+    }
+
+    // 写入LTO报告
+    void write_lto_report()
+    {
+        if (lto.mode == LtoMode::NONE)
+        {
+            return;
+        }
+
+        static const char* mode_strings[] = {"none", "lto", "wpa", "ltrans"};
+        const char* mode = mode_strings[(int)lto.mode];
+
+        json::object* report = new json::object();
+        report->set("mode", new json::string(mode));
+        report->set("run", new json::string(lto.run.data()));
+        if (lto.mode == LtoMode::LTRANS)
+        {
+            report->set("partition", new json::integer_number(lto.partition));
+        }
+        report->set("function_count", new json::integer_number(partition_function_count));
+        report->set("variable_count", new json::integer_number(partition_variable_count));
+
+        json::array* functions = new json::array();
+        for (const std::string& function : partition_functions)
+        {
+            functions->append(new json::string(function.data()));
+        }
+        report->set("functions", functions);
+
+        if (lto.mode == LtoMode::WPA)
+        {
+            json::array* partitions = new json::array();
+            for (const auto& file : ltrans_files)
+            {
+                partitions->append(new json::string(file.data()));
+            }
+            report->set("partitions", partitions);
+        }
+        add_report("lto", report);
+
+        // 排序：WPA在前，LTRANS按分区编号排列
+        set_process_name(lto_process_name().data(), lto.mode == LtoMode::LTRANS ? lto.partition + 1 : 0);
+    }
+
+    // 写入尚未结束的最后一个pass（其余pass在结束时已流式写入）
+    void write_opt_pass_events()
+    {
+        finish_last_pass(ns_from_start());
+    }
+
+    // 前端结束时写入已经完整的前端事件，编译中途退出时这些事件已在文件中
+    void write_frontend_events()
+    {
+        if (frontend_events_written)
+        {
+            return;
+        }
+        frontend_events_written = true;
+
+        write_finished_preprocess_files();  // 已结束的文件（主文件在编译结束时写入）
+        write_all_declarations();           // 函数之间的声明解析事件
+        write_all_scopes();                 // 作用域事件和scopeRollup报告
+    }
+
+    // 编译异常结束：写入不需要再访问GCC数据结构就能输出的事件
+    void write_incomplete_events()
+    {
+        names_frozen = true;           // 名称未缓存的函数的pass事件省略function参数
+        write_opt_pass_events();       // 正在执行的pass结束于此刻
+        write_preprocessing_events();  // 仍在包含栈中的文件结束于此刻
+
+        // 前端中途退出：名称尚未格式化，只输出声明解析事件
+        if (!names_resolved)
+        {
+            write_all_declarations();
+            return;
+        }
+        write_frontend_events();
+        write_all_functions();
+    }
+
+    // 处理函数解析开始事件
+    void start_parse_function()
+    {
+        TimeStamp now = ns_from_start();  // 获取当前时间
+
+        // 最外层函数：上一个函数结束到现在的时间属于声明解析，单独记录
+        if (function_start_stack.empty())
+        {
+            record_declarations(now);
+        }
+
+        // 记录函数解析的真实开始时间（+3纳秒避免与声明事件、作用域事件重叠）
+        function_start_stack.push_back(now + 3);
+    }
+
+    // 处理函数解析完成事件
+    // 参数：
+    //   info - 从GCC回调传递来的函数信息
+    void end_parse_function(FinishedFunction info)
+    {
+        TimeStamp now = ns_from_start();  // 获取当前时间
+
+        // 由于Chrome Tracing的UI bug，我们不能让不同事件在同一时间开始和结束
+        // 因此调整事件的时间戳，避免完全重叠
+
+        // 计算函数解析的时间跨度：优先使用PLUGIN_START_PARSE_FUNCTION记录的开始时间
+        // 开始回调缺失时（如错误恢复）退回到上一个事件结束时间+3纳秒
+        TimeSpan ts{last_function_parsed_ts + 3, now};
+        if (!function_start_stack.empty())
+        {
+            ts.start = function_start_stack.back();
+            function_start_stack.pop_back();
+        }
+
+        // 只有最外层函数结束时才更新基准时间，嵌套函数属于外层函数体
+        if (function_start_stack.empty())
+        {
+            last_function_parsed_ts = now;
+
+            // 类内定义的成员函数属于所在类的定义时间，不作为命名空间作用域实体
+            if (!info.in_class_body)
+            {
+                last_toplevel_ts = now;
+            }
+        }
+
+        // 存储函数事件（未详细追踪的源文件只计入该文件的汇总）
+        if (is_traced_file(info.file_name))
+        {
+            function_events.emplace_back(info.decl, info.file_name, ts);
+        }
+        else
+        {
+            record_dropped_event(EventCategory::FUNCTION, file_filter(info.file_name).name, ts);
+        }
+
+        // 嵌套函数（lambda、局部类成员函数）的时间已包含在外层函数内，不参与汇总
+        if (!function_start_stack.empty())
+        {
+            return;
+        }
+
+        // 累加到作用域树：直接所属作用域的函数统计，以及所有祖先作用域的包含统计
+        TimeStamp duration = ts.end - ts.start;
+        scopes[info.scope].function_count++;
+        scopes[info.scope].function_ns += duration;
+        add_to_scope_chain(info.scope, &ScopeNode::total_function_ns, duration);
+
+        // 类内定义的成员函数已包含在所属类的定义时间内，不重复计入独占时间
+        if (!info.in_class_body)
+        {
+            add_to_scope_chain(info.scope, &ScopeNode::total_ns, duration);
+
+            // 处理命名空间作用域事件
+            record_scope(info.scope, ts);
+        }
+    }
+
+    // 查找已驻留的作用域
+    ScopeId find_scope(const void* key)
+    {
+        auto it = scope_ids.find(key);
+        return it != scope_ids.end() ? it->second : GLOBAL_SCOPE;
+    }
+
+    // 驻留一个新的作用域
+    ScopeId intern_scope(const void* key, ScopeId parent, EventCategory type)
+    {
+        ScopeId id = static_cast<ScopeId>(scopes.size());
+        scopes.emplace_back(key, parent, type);
+        scope_ids[key] = id;
+        return id;
+    }
+
+    // 处理命名空间作用域声明完成事件
+    // 参数：scope - 声明所在的作用域（DECL_CONTEXT）
+    void end_toplevel_declaration(ScopeId scope)
+    {
+        // 函数体内的声明属于外层函数
+        if (!function_start_stack.empty())
+        {
+            return;
+        }
+
+        TimeStamp now = ns_from_start();  // 获取当前时间
+
+        // 声明解析时间计入DECLARATION事件，并作为下一个类定义的起点
+        record_declarations(now);
+        last_function_parsed_ts = now;
+        last_toplevel_ts = now;
+
+        // 其他命名空间中的声明打断了命名空间的连续解析：关闭不在声明作用域链上的命名空间，
+        // 之后的函数和类定义重新打开新的作用域事件
+        close_scopes(namespace_chain(scope));
+    }
+
+    // 处理类/结构体定义完成事件
+    // 参数：
+    //   info - 从GCC回调传递来的类型信息
+    void end_parse_type(FinishedType info)
+    {
+        // 函数体内的局部类计入外层函数，不单独追踪
+        if (!function_start_stack.empty())
+        {
+            return;
+        }
+
+        TimeStamp now = ns_from_start();  // 获取当前时间
+        TimeSpan ts;
+
+        if (info.nested)
+        {
+            // 嵌套类：在外层类定义内，从上一个函数或嵌套类结束处开始
+            ts = TimeSpan{last_function_parsed_ts + 3, now};
+            last_function_parsed_ts = now;
+        }
+        else
+        {
+            // 类内定义的成员函数之后剩余的声明解析时间
+            if (last_function_parsed_ts > last_toplevel_ts)
+            {
+                record_declarations(now);
+            }
+
+            // 最外层类：从上一个命名空间作用域实体结束处开始
+            // 微调时间保证包含类内的函数事件和声明事件
+            ts = TimeSpan{last_toplevel_ts + 1, now + 1};
+            last_function_parsed_ts = now + 1;
+            last_toplevel_ts = now + 1;
+
+            // 类定义的独占时间计入自身及所有祖先作用域（已包含类内成员函数和嵌套类）
+            add_to_scope_chain(info.scope, &ScopeNode::total_ns, ts.end - ts.start);
+
+            // 类定义也参与命名空间作用域事件的合并
+            record_scope(info.scope, ts);
+        }
+
+        scopes[info.scope].definition_ns += ts.end - ts.start;
+        if (is_traced_file(info.file_name))
+        {
+            type_events.emplace_back(info.scope, info.file_name, info.member_count, info.base_count, ts);
+        }
+        else
+        {
+            record_dropped_event(EventCategory::STRUCT, file_filter(info.file_name).name, ts);
+        }
+    }
+
+    // 格式化所有会被输出的事件名称
+    void resolve_deferred_names()
+    {
+        names_resolved = true;
+
+        // 函数签名：只格式化不会被过滤掉的函数事件
+        for (auto& event : function_events)
+        {
+            if (event.name.empty() && should_emit_event(EventCategory::FUNCTION, event.ts))
+            {
+                event.name = decl_name(event.decl);
+                function_names.try_emplace(event.decl, event.name);  // 报告中复用，不再格式化
+            }
+        }
+
+        // 作用域名称：输出的命名空间事件、类定义事件以及汇总报告中的作用域
+        for (const auto& [scope, ts] : scope_events)
+        {
+            if (should_emit_event(scopes[scope].type, ts))
+            {
+                scope_name(scope);
+            }
+        }
+        for (const auto& event : type_events)
+        {
+            if (should_emit_event(EventCategory::STRUCT, event.ts))
+            {
+                scope_name(event.scope);
+            }
+        }
+        for (ScopeId id = 0; id < scopes.size(); id++)
+        {
+            if (has_rollup(id))
+            {
+                scope_name(id);
+            }
+        }
+    }
+
+    // 写入所有作用域事件到输出系统
+    void write_all_scopes()
+    {
+        // 遍历所有作用域事件
+        for (const auto& [scope, ts] : scope_events)
+        {
+            // 跳过会被过滤掉的事件，避免格式化名称
+            if (!should_emit_event(scopes[scope].type, ts))
+            {
+                record_dropped_event(scopes[scope].type, nullptr, ts);
+                continue;
+            }
+
+            // 创建并添加作用域事件
+            add_event(TraceEvent{
+                scope_name(scope),          // 作用域名称
+                scopes[scope].type,         // 作用域类型
+                ts,                         // 时间跨度
+                std::nullopt                // 无额外参数
+                });
+        }
+
+        // 遍历所有类定义事件
+        for (const auto& [scope, file_name, member_count, base_count, ts] : type_events)
+        {
+            // 跳过会被过滤掉的事件，避免格式化名称和构造参数
+            if (!should_emit_event(EventCategory::STRUCT, ts))
+            {
+                record_dropped_event(EventCategory::STRUCT, file_name ? normalized_file_name(file_name) : nullptr, ts);
+                continue;
+            }
+
+            const ScopeNode& node = scopes[scope];
+
+            // 准备类定义的额外参数
+            map_t<std::string, std::string> args;
+            if (file_name)
+            {
+                args["file"] = normalized_file_name(file_name);   // 规范化文件名
+            }
+            args["member_count"] = std::to_string(member_count);  // 成员数量
+            args["base_count"] = std::to_string(base_count);      // 直接基类数量
+
+            // 成员函数的汇总开销（包括类外定义的成员函数）
+            args["member_function_count"] = std::to_string(node.function_count);
+            args["member_function_ns"] = std::to_string(node.function_ns);
+
+            add_event(TraceEvent{
+                scope_name(scope),              // 类型名称
+                EventCategory::STRUCT,          // 事件类别：类/结构体
+                ts,                             // 时间跨度
+                std::move(args)                 // 额外参数
+                });
+        }
+
+        // 输出作用域树的汇总报告（每个命名空间/类一条记录，重新打开的命名空间合并计算）
+        json::array* rollup = new json::array();
+        for (ScopeId id = 0; id < scopes.size(); id++)
+        {
+            // 跳过没有任何解析开销的作用域（如只作为中间层出现的命名空间）
+            if (!has_rollup(id))
+            {
+                continue;
+            }
+
+            const ScopeNode& node = scopes[id];
+
+            json::object* entry = new json::object();
+            entry->set("id", new json::integer_number(id));
+            entry->set("parent", new json::integer_number(node.parent));
+            entry->set("name", new json::string(scope_name(id)));
+            entry->set("cat", new json::string(node.type == EventCategory::STRUCT ? "STRUCT" : "NAMESPACE"));
+            entry->set("function_count", new json::integer_number(node.function_count));
+            entry->set("function_ns", new json::integer_number(node.function_ns));
+            entry->set("total_function_ns", new json::integer_number(node.total_function_ns));
+            entry->set("definition_ns", new json::integer_number(node.definition_ns));
+            entry->set("total_ns", new json::integer_number(node.total_ns));
+            rollup->append(entry);
+        }
+        add_report("scopeRollup", rollup);
+    }
+
+    // 写入所有声明解析事件到输出系统
+    void write_all_declarations()
+    {
+        for (const auto& ts : declaration_events)
+        {
+            add_event(TraceEvent{
+                "declarations",                 // 事件名称
+                EventCategory::DECLARATION,     // 事件类别：声明解析
+                ts,                             // 时间跨度
+                std::nullopt                    // 无额外参数
+                });
+        }
+        declaration_events.clear();  // 已写入，不重复输出
     }
 
     // 写入所有函数事件到输出系统
     void write_all_functions()
     {
         // 遍历所有函数事件
-        for (const auto& [name, file_name, ts] : function_events)
+        for (const auto& [decl, file_name, ts, name] : function_events)
         {
+            // 跳过会被过滤掉的事件（这些事件的函数签名从未格式化）
+            if (!should_emit_event(EventCategory::FUNCTION, ts))
+            {
+                record_dropped_event(EventCategory::FUNCTION, normalized_file_name(file_name), ts);
+                continue;
+            }
+
             // 准备函数的额外参数
             map_t<std::string, std::string> args;
             args["file"] = normalized_file_name(file_name);  // 规范化文件名
 
+            // 生成代码大小（完整的关联数据见functionReport）
+            if (auto size = code_sizes.find(decl); size != code_sizes.end())
+            {
+                args["rtl_insns"] = std::to_string(size->second.rtl_insns);
+                if (size->second.asm_bytes >= 0)
+                {
+                    args["asm_bytes"] = std::to_string(size->second.asm_bytes);
+                }
+            }
+
             // 创建并添加函数事件
             add_event(TraceEvent{
                 name.data(),                    // 函数签名
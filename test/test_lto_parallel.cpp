@@ -0,0 +1,53 @@
+// LTO并行分区测试
+// 足够多的函数使WPA划分出多个分区；-flto=N时WPA fork子进程写出分区，
+// 子进程exit时glibc刷新继承的trace流，用于验证WPA的trace不会被写入重复的数据
+
+// 每个函数的函数体足够大，不会被内联，分区大小超过lto-min-partition
+#define FUNCTION(n) \
+    __attribute__((noinline)) int function_##n(int x) \
+    { \
+        int s = x; \
+        for (int i = 0; i < x; i++) \
+        { \
+            s = s * 31 + i * n; \
+            if (s % 7 == n % 7) \
+            { \
+                s ^= i; \
+            } \
+        } \
+        return s; \
+    }
+
+#define FUNCTIONS_10(n) FUNCTION(n##0) FUNCTION(n##1) FUNCTION(n##2) FUNCTION(n##3) FUNCTION(n##4) \
+    FUNCTION(n##5) FUNCTION(n##6) FUNCTION(n##7) FUNCTION(n##8) FUNCTION(n##9)
+#define FUNCTIONS_100(n) FUNCTIONS_10(n##0) FUNCTIONS_10(n##1) FUNCTIONS_10(n##2) FUNCTIONS_10(n##3) \
+    FUNCTIONS_10(n##4) FUNCTIONS_10(n##5) FUNCTIONS_10(n##6) FUNCTIONS_10(n##7) FUNCTIONS_10(n##8) FUNCTIONS_10(n##9)
+#define FUNCTIONS_1000(n) FUNCTIONS_100(n##0) FUNCTIONS_100(n##1) FUNCTIONS_100(n##2) FUNCTIONS_100(n##3) \
+    FUNCTIONS_100(n##4) FUNCTIONS_100(n##5) FUNCTIONS_100(n##6) FUNCTIONS_100(n##7) FUNCTIONS_100(n##8) FUNCTIONS_100(n##9)
+
+// 函数表：保证LTO不会删除这些函数
+#define ENTRY(n) function_##n,
+#define ENTRIES_10(n) ENTRY(n##0) ENTRY(n##1) ENTRY(n##2) ENTRY(n##3) ENTRY(n##4) \
+    ENTRY(n##5) ENTRY(n##6) ENTRY(n##7) ENTRY(n##8) ENTRY(n##9)
+#define ENTRIES_100(n) ENTRIES_10(n##0) ENTRIES_10(n##1) ENTRIES_10(n##2) ENTRIES_10(n##3) \
+    ENTRIES_10(n##4) ENTRIES_10(n##5) ENTRIES_10(n##6) ENTRIES_10(n##7) ENTRIES_10(n##8) ENTRIES_10(n##9)
+#define ENTRIES_1000(n) ENTRIES_100(n##0) ENTRIES_100(n##1) ENTRIES_100(n##2) ENTRIES_100(n##3) \
+    ENTRIES_100(n##4) ENTRIES_100(n##5) ENTRIES_100(n##6) ENTRIES_100(n##7) ENTRIES_100(n##8) ENTRIES_100(n##9)
+
+FUNCTIONS_1000(1)
+FUNCTIONS_1000(2)
+
+int (*const functions[])(int) = {
+    ENTRIES_1000(1)
+    ENTRIES_1000(2)
+};
+
+int main(int argc, char**)
+{
+    int sum = 0;
+    for (auto function : functions)
+    {
+        sum += function(argc);
+    }
+    return sum == 0;
+}
@@ -0,0 +1,433 @@
+// trace结构回归测试
+// 读取测试程序编译时生成的trace，检查事件类别、嵌套关系、TU时间覆盖率、
+// 插件自报开销和文件大小，任何一项不满足都以非零状态退出（使构建失败）
+// 存在belowThreshold报告时，检查各类别输出的事件与trace一致、输出与丢弃的时间和summary报告相符
+//
+// 用法：trace_check <trace.json> [选项...]
+//   --expect-category CAT[|CAT...]  至少存在一个指定类别的事件（|分隔表示任一即可）
+//   --expect-name TEXT              至少存在一个名称包含TEXT的事件
+//   --expect-report KEY             根对象中存在附加报告KEY
+//   --min-coverage F                TU之下的事件覆盖TU时间的比例不低于F
+//   --max-overhead F                metadata.gperf_overhead.fraction不超过F
+//   --max-bytes N                   trace文件不超过N字节
+//   --expect-other-files CAT        belowThreshold报告中类别CAT的other_files非空（被过滤的事件按文件汇总）
+//   --truncated-readable F          只保留文件前F比例的字节（模拟编译被SIGKILL终止）仍能读出事件：
+//                                   压缩的trace在进入IPA等阶段边界同步刷新，截断的压缩流也能解压
+
+#include "trace_reader.h"  // trace读取
+
+#include <algorithm>       // 排序
+#include <cmath>           // abs
+#include <cstdio>          // 输出
+#include <cstdlib>         // strtod、strtoull
+#include <filesystem>      // 截断副本的路径
+#include <fstream>         // 写入截断副本
+#include <map>             // 按线程分组
+#include <set>             // 类别集合
+#include <string>          // 字符串
+#include <vector>          // 向量容器
+
+using namespace GccTrace;
+
+namespace
+{
+    // 时间比较容差（微秒）：时间戳保留纳秒精度，容差只吸收浮点误差
+    constexpr double EPSILON_US = 0.001;
+
+    // 最多逐条打印的违规数量
+    constexpr int MAX_REPORTED_VIOLATIONS = 10;
+
+    int failures = 0;
+
+    void fail(const char* format, const std::string& detail)
+    {
+        fprintf(stderr, "trace_check: ");
+        fprintf(stderr, format, detail.data());
+        fprintf(stderr, "\n");
+        failures++;
+    }
+
+    std::string describe(const TraceSpan& span)
+    {
+        return span.category + " '" + span.name + "' [" + std::to_string(span.start_us) + ", " +
+            std::to_string(span.end_us) + "]";
+    }
+
+    // 同一线程内的事件必须严格嵌套：要么不相交，要么一个完全包含另一个
+    void check_nesting(const Trace& trace)
+    {
+        std::map<std::pair<int64_t, int64_t>, std::vector<const TraceSpan*>> stacks;
+        int violations = 0;
+        for (const TraceSpan& span : trace.spans)
+        {
+            if (span.end_us + EPSILON_US < span.start_us)
+            {
+                fail("event ends before it starts: %s", describe(span));
+                continue;
+            }
+
+            // spans已按开始时间排序（同时开始时长者在前），栈中保存仍未结束的祖先
+            auto& stack = stacks[{span.pid, span.tid}];
+            while (!stack.empty() && stack.back()->end_us <= span.start_us + EPSILON_US)
+            {
+                stack.pop_back();
+            }
+            if (!stack.empty() && span.end_us > stack.back()->end_us + EPSILON_US)
+            {
+                if (violations++ < MAX_REPORTED_VIOLATIONS)
+                {
+                    fail("partially overlapping events: %s", describe(*stack.back()) + " and " + describe(span));
+                }
+                continue;
+            }
+            stack.push_back(&span);
+        }
+        if (violations > MAX_REPORTED_VIOLATIONS)
+        {
+            fail("%s more nesting violations", std::to_string(violations - MAX_REPORTED_VIOLATIONS));
+        }
+    }
+
+    // TU事件唯一、从时间原点开始并包含其他所有事件；返回TU之下事件的覆盖率
+    double check_tu_span(const Trace& trace)
+    {
+        const TraceSpan* tu = nullptr;
+        for (const TraceSpan& span : trace.spans)
+        {
+            if (span.category == "TU")
+            {
+                if (tu)
+                {
+                    fail("more than one TU event: %s", describe(span));
+                }
+                tu = &span;
+            }
+        }
+        if (!tu)
+        {
+            fail("%s", "no TU event");
+            return 0;
+        }
+        if (tu->start_us > EPSILON_US)
+        {
+            fail("TU event doesn't start at the beginning of time: %s", describe(*tu));
+        }
+
+        // 合并TU之外所有事件的时间区间（spans已按开始时间排序）
+        double covered = 0;
+        double current_start = 0;
+        double current_end = -1;
+        int outside = 0;
+        for (const TraceSpan& span : trace.spans)
+        {
+            if (&span == tu)
+            {
+                continue;
+            }
+            if (span.start_us + EPSILON_US < tu->start_us || span.end_us > tu->end_us + EPSILON_US)
+            {
+                if (outside++ < MAX_REPORTED_VIOLATIONS)
+                {
+                    fail("event outside the TU span: %s", describe(span));
+                }
+                continue;
+            }
+            if (span.start_us > current_end)
+            {
+                covered += std::max(0.0, current_end - current_start);
+                current_start = span.start_us;
+            }
+            current_end = std::max(current_end, span.end_us);
+        }
+        covered += std::max(0.0, current_end - current_start);
+
+        return tu->duration_us() > 0 ? covered / tu->duration_us() : 0;
+    }
+
+    // 报告中的整数字段（缺失时为-1）
+    int64_t report_integer(const JsonValue* object, std::string_view key)
+    {
+        const JsonValue* value = object ? object->get(key) : nullptr;
+        return value ? static_cast<int64_t>(value->number_or(-1)) : -1;
+    }
+
+    // belowThreshold报告与trace和summary报告一致：
+    // 每个类别输出的事件数和时间等于trace中该类别的事件，按文件汇总的丢弃事件不超过该类别的other，
+    // 输出与丢弃的时间合计与summary的类别统计相同，各优化阶段时间等于对应pass类别的合计
+    void check_threshold_report(const Trace& trace)
+    {
+        const JsonValue* report = trace.report("belowThreshold");
+        if (!report || report->type != JsonValue::OBJECT)
+        {
+            return;
+        }
+
+        std::map<std::string, std::pair<int64_t, double>> spans;  // 类别 -> (事件数, 总时间µs)
+        for (const TraceSpan& span : trace.spans)
+        {
+            auto& [count, total_us] = spans[span.category];
+            count++;
+            total_us += span.duration_us();
+        }
+
+        const JsonValue* summary = trace.report("summary");
+        const JsonValue* summary_categories = summary ? summary->get("categories") : nullptr;
+        std::map<std::string, int64_t> category_ns;  // 类别 -> 输出与丢弃的时间合计
+        for (const auto& [category, entry] : report->object)
+        {
+            int64_t emitted_count = report_integer(&entry, "emitted_count");
+            int64_t emitted_ns = report_integer(&entry, "emitted_ns");
+            int64_t other_count = report_integer(&entry, "other_count");
+            int64_t other_ns = report_integer(&entry, "other_ns");
+            category_ns[category] = emitted_ns + other_ns;
+
+            // 时间戳精确到纳秒，求和的浮点误差远小于1µs
+            auto [count, total_us] = spans[category];
+            if (emitted_count != count || std::abs(emitted_ns / 1000.0 - total_us) > 1)
+            {
+                fail("belowThreshold doesn't match the trace: %s", category + " emits " +
+                    std::to_string(emitted_count) + " events / " + std::to_string(emitted_ns) + " ns, trace has " +
+                    std::to_string(count) + " / " + std::to_string(static_cast<int64_t>(total_us * 1000)) + " ns");
+            }
+            if (category == "TU" && other_count != 0)
+            {
+                fail("%s", "the TU event was dropped by the threshold");
+            }
+
+            int64_t file_count = 0;
+            int64_t file_ns = 0;
+            if (const JsonValue* files = entry.get("other_files"))
+            {
+                for (const auto& [file, aggregate] : files->object)
+                {
+                    file_count += report_integer(&aggregate, "count");
+                    file_ns += report_integer(&aggregate, "total_ns");
+                }
+            }
+            if (file_count > other_count || file_ns > other_ns)
+            {
+                fail("belowThreshold other_files exceed the category total: %s", category + ": " +
+                    std::to_string(file_ns) + " > " + std::to_string(other_ns) + " ns");
+            }
+
+            const JsonValue* summary_entry = summary_categories ? summary_categories->get(category) : nullptr;
+            if (!summary_entry)
+            {
+                fail("summary has no statistics for category %s", category);
+            }
+            else if (report_integer(summary_entry, "total_ns") != emitted_ns ||
+                report_integer(summary_entry, "other_ns") != other_ns)
+            {
+                fail("summary and belowThreshold disagree on category %s", category);
+            }
+        }
+
+        // 各优化阶段的时间包括被丢弃的pass事件
+        const JsonValue* phases = summary ? summary->get("phases") : nullptr;
+        const std::pair<const char*, int64_t> expected_phases[] = {
+            {"ipa_ns", category_ns["SIMPLE_IPA_PASS"] + category_ns["IPA_PASS"]},
+            {"gimple_ns", category_ns["GIMPLE_PASS"]},
+            {"rtl_ns", category_ns["RTL_PASS"]},
+        };
+        for (const auto& [phase, expected] : expected_phases)
+        {
+            if (phases && report_integer(phases, phase) != expected)
+            {
+                fail("summary phase doesn't add up: %s", std::string(phase) + " = " +
+                    std::to_string(report_integer(phases, phase)) + ", emitted + other = " + std::to_string(expected));
+            }
+        }
+    }
+
+    // 按'|'拆分类别列表
+    std::vector<std::string> split_alternatives(const std::string& text)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true)
+        {
+            size_t end = text.find('|', start);
+            parts.push_back(text.substr(start, end - start));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            start = end + 1;
+        }
+        return parts;
+    }
+
+    // 把trace文件的前fraction比例的字节写入副本（扩展名不变，按同样的方式解压），读取副本：
+    // 必须被识别为截断的trace并至少读出一个完整的事件
+    bool check_truncated_prefix(const std::string& path, double fraction, std::string& detail)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        content.resize(static_cast<size_t>(content.size() * fraction));
+
+        std::string copy = path;
+        size_t extension = copy.rfind(".json");
+        copy.insert(extension == std::string::npos ? copy.size() : extension, ".truncated");
+        std::ofstream(copy, std::ios::binary) << content;
+
+        Trace trace;
+        bool ok = load_trace(copy, trace, detail);
+        std::filesystem::remove(copy);
+        if (!ok)
+        {
+            return false;
+        }
+        if (!trace.truncated)
+        {
+            detail = "the cut file still parses as a complete trace";
+            return false;
+        }
+        if (trace.spans.empty())
+        {
+            detail = "no complete event in the first " + std::to_string(content.size()) + " bytes";
+            return false;
+        }
+        printf("trace_check: %zu events readable from the first %zu bytes\n", trace.spans.size(), content.size());
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: trace_check <trace.json> [--expect-category CAT[|CAT...]] [--expect-name TEXT]\n"
+            "       [--expect-report KEY] [--min-coverage F] [--max-overhead F] [--max-bytes N]\n"
+            "       [--expect-other-files CAT] [--truncated-readable F]\n");
+        return 2;
+    }
+
+    Trace trace;
+    std::string error;
+    if (!load_trace(argv[1], trace, error))
+    {
+        fprintf(stderr, "trace_check: %s\n", error.data());
+        return 1;
+    }
+
+    // 结构检查：文件完整、B/E记录全部配对、严格嵌套、TU包含全部事件
+    if (trace.truncated)
+    {
+        fail("%s", "trace is truncated");
+    }
+    if (trace.unmatched_records)
+    {
+        fail("%s unmatched B/E records", std::to_string(trace.unmatched_records));
+    }
+    check_nesting(trace);
+    double coverage = check_tu_span(trace);
+    check_threshold_report(trace);
+
+    std::set<std::string> categories;
+    for (const TraceSpan& span : trace.spans)
+    {
+        categories.insert(span.category);
+    }
+
+    // 期望与预算检查
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "trace_check: missing value for %s\n", option.data());
+            return 2;
+        }
+        std::string value = argv[++i];
+
+        if (option == "--expect-category")
+        {
+            bool found = false;
+            for (const std::string& category : split_alternatives(value))
+            {
+                found = found || categories.contains(category);
+            }
+            if (!found)
+            {
+                fail("no event of category %s", value);
+            }
+        }
+        else if (option == "--expect-name")
+        {
+            bool found = std::any_of(trace.spans.begin(), trace.spans.end(),
+                [&](const TraceSpan& span) { return span.name.find(value) != std::string::npos; });
+            if (!found)
+            {
+                fail("no event named like '%s'", value);
+            }
+        }
+        else if (option == "--expect-report")
+        {
+            if (!trace.report(value))
+            {
+                fail("missing report '%s'", value);
+            }
+        }
+        else if (option == "--min-coverage")
+        {
+            if (coverage < strtod(value.data(), nullptr))
+            {
+                fail("events cover too little of the TU: %s", std::to_string(coverage) + " < " + value);
+            }
+        }
+        else if (option == "--max-overhead")
+        {
+            const JsonValue* metadata = trace.report("metadata");
+            const JsonValue* overhead = metadata ? metadata->get("gperf_overhead") : nullptr;
+            const JsonValue* fraction = overhead ? overhead->get("fraction") : nullptr;
+            if (!fraction)
+            {
+                fail("%s", "missing metadata.gperf_overhead.fraction");
+            }
+            else if (fraction->number_or(0) > strtod(value.data(), nullptr))
+            {
+                fail("plugin overhead over budget: %s", std::to_string(fraction->number) + " > " + value);
+            }
+        }
+        else if (option == "--max-bytes")
+        {
+            if (trace.file_bytes > strtoull(value.data(), nullptr, 10))
+            {
+                fail("trace file over budget: %s", std::to_string(trace.file_bytes) + " > " + value + " bytes");
+            }
+        }
+        else if (option == "--expect-other-files")
+        {
+            const JsonValue* report = trace.report("belowThreshold");
+            const JsonValue* entry = report ? report->get(value) : nullptr;
+            const JsonValue* files = entry ? entry->get("other_files") : nullptr;
+            if (!files || files->object.empty())
+            {
+                fail("no filtered %s events aggregated by file in belowThreshold", value);
+            }
+        }
+        else if (option == "--truncated-readable")
+        {
+            std::string detail;
+            if (!check_truncated_prefix(argv[1], strtod(value.data(), nullptr), detail))
+            {
+                fail("truncated trace is not readable: %s", detail);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "trace_check: unknown option %s\n", option.data());
+            return 2;
+        }
+    }
+
+    if (failures)
+    {
+        fprintf(stderr, "trace_check: %s: %d check(s) failed\n", argv[1], failures);
+        return 1;
+    }
+
+    printf("trace_check: %s: %zu events, %zu bytes, %.1f%% of TU covered\n",
+        argv[1], trace.spans.size(), trace.file_bytes, coverage * 100);
+    return 0;
+}
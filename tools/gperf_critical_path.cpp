@@ -0,0 +1,810 @@
+// gperf-critical-path：构建关键路径分析
+// 读取ninja的.ninja_log（最近一次构建的每个步骤的开始、结束时间和输出文件）和依赖图
+// （ninja -t graph的构建边，ninja -t deps的头文件依赖），按步骤耗时找出依赖图上最长的路径，
+// 再按输出文件把关键路径上的编译步骤与插件的trace关联，
+// 把每个关键翻译单元的时间分解到插件的事件类别，并列出关键路径上耗时最多的头文件和pass
+//
+// 用法：gperf-critical-path <.ninja_log> <trace目录或文件...> [--compdb compile_commands.json] [--top N]
+//                           [--ninja-dir DIR] [--graph FILE] [--deps FILE]
+//   --compdb FILE   用编译数据库（file、output字段）精确关联目标文件和源文件，
+//                   否则按路径匹配（CMake的foo.cpp.o、Makefile风格的foo.o都能对应foo.cpp）
+//   --top N         每个翻译单元和汇总中列出的头文件、pass数量（默认10）
+//   --ninja-dir DIR 构建目录（默认为.ninja_log所在目录），在其中运行ninja -t graph和ninja -t deps
+//   --graph FILE    使用保存的ninja -t graph输出（不运行ninja）
+//   --deps FILE     使用保存的ninja -t deps输出（不运行ninja）
+//
+// 得不到依赖图时退回按时间推断（并在输出中说明）：每个步骤的前驱取在它开始之前（或同时）
+// 结束得最晚的步骤；并行构建中这通常是恰好让出执行槽的无关步骤，只能作为粗略的参考
+
+#include "trace_reader.h"  // trace解析
+
+#include <algorithm>       // 排序
+#include <cstdio>          // 输出
+#include <cstdlib>         // atoi、atof
+#include <cstring>         // strlen
+#include <filesystem>      // 路径处理
+#include <fstream>         // 读取.ninja_log
+#include <map>             // 按名称汇总
+#include <set>             // 步骤的前驱
+#include <sstream>         // 读取编译数据库
+#include <string>          // 字符串
+#include <tuple>           // 合并多输出步骤的键
+#include <vector>          // 向量容器
+
+using namespace GccTrace;
+
+namespace
+{
+    // .ninja_log中的一个构建步骤（多个输出的步骤合并为一项）
+    struct BuildStep
+    {
+        double start_ms;                    // 开始时间（相对构建开始，毫秒）
+        double end_ms;                      // 结束时间
+        std::string hash;                   // 命令哈希
+        std::vector<std::string> outputs;   // 输出文件（相对构建目录）
+    };
+
+    // 文件级依赖图：每个文件的直接输入（构建边的显式、隐式输入和头文件依赖，不含order-only输入）
+    using DependencyGraph = std::map<std::string, std::vector<std::string>>;
+
+    // 一个翻译单元trace的时间分解（读取后不保留完整的trace）
+    struct TuBreakdown
+    {
+        std::string path;                           // trace文件
+        std::string unit;                           // 主源文件
+        double total_us = 0;                        // TU事件的时长
+        std::map<std::string, double> self_us;      // 类别 -> 自身时间（不含嵌套事件），TU为未归属的时间
+        std::map<std::string, double> headers_us;   // 主源文件直接包含的头文件 -> 预处理时间（含嵌套包含）
+        std::map<std::string, double> passes_us;    // pass名称 -> 执行时间
+    };
+
+    // 编译数据库中的一项
+    struct CompileCommand
+    {
+        std::string file;      // 源文件（绝对路径）
+        std::string output;    // 目标文件
+    };
+
+    // 路径分量（忽略空分量和"."）
+    std::vector<std::string> split_path(const std::string& path)
+    {
+        std::vector<std::string> components;
+        for (const auto& component : std::filesystem::path(path).lexically_normal())
+        {
+            std::string text = component.string();
+            if (!text.empty() && text != "/" && text != ".")
+            {
+                components.push_back(text);
+            }
+        }
+        return components;
+    }
+
+    // 两个路径末尾相同的分量数
+    size_t common_suffix(const std::vector<std::string>& a, const std::vector<std::string>& b)
+    {
+        size_t count = 0;
+        while (count < a.size() && count < b.size() && a[a.size() - 1 - count] == b[b.size() - 1 - count])
+        {
+            count++;
+        }
+        return count;
+    }
+
+    // 一个路径是否为另一个的后缀（相对路径对应绝对路径）
+    bool same_file(const std::string& a, const std::string& b)
+    {
+        auto components_a = split_path(a);
+        auto components_b = split_path(b);
+        size_t common = common_suffix(components_a, components_b);
+        return common > 0 && common == std::min(components_a.size(), components_b.size());
+    }
+
+    // 去掉目标文件的扩展名（.o/.obj），不是目标文件时返回空字符串
+    std::string object_stem(const std::string& output)
+    {
+        for (std::string extension : {".o", ".obj"})
+        {
+            if (output.size() > extension.size() &&
+                output.compare(output.size() - extension.size(), extension.size(), extension) == 0)
+            {
+                return output.substr(0, output.size() - extension.size());
+            }
+        }
+        return "";
+    }
+
+    // 读取.ninja_log中最近一次构建的步骤
+    // 日志按步骤结束的顺序追加，结束时间变小表示开始了新的一次构建
+    bool read_ninja_log(const std::string& path, std::vector<BuildStep>& steps, std::string& error)
+    {
+        std::ifstream in(path);
+        std::string line;
+        if (!in || !std::getline(in, line) || line.rfind("# ninja log v", 0) != 0)
+        {
+            error = path + ": not a .ninja_log file";
+            return false;
+        }
+        if (atoi(line.data() + strlen("# ninja log v")) < 5)
+        {
+            error = path + ": unsupported .ninja_log version (" + line + ")";
+            return false;
+        }
+
+        std::map<std::tuple<double, double, std::string>, size_t> step_index;
+        double last_end = 0;
+        while (std::getline(in, line))
+        {
+            // 开始时间、结束时间、修改时间、输出文件、命令哈希，以制表符分隔
+            std::vector<std::string> fields;
+            std::stringstream fields_in(line);
+            for (std::string field; std::getline(fields_in, field, '\t');)
+            {
+                fields.push_back(field);
+            }
+            if (fields.size() < 5)
+            {
+                continue;
+            }
+            double start = atof(fields[0].data());
+            double end = atof(fields[1].data());
+            if (end < last_end)
+            {
+                steps.clear();
+                step_index.clear();
+            }
+            last_end = end;
+
+            auto key = std::make_tuple(start, end, fields[4]);
+            auto it = step_index.find(key);
+            if (it == step_index.end())
+            {
+                step_index[key] = steps.size();
+                steps.push_back(BuildStep{start, end, fields[4], {fields[3]}});
+            }
+            else
+            {
+                steps[it->second].outputs.push_back(fields[3]);
+            }
+        }
+        if (steps.empty())
+        {
+            error = path + ": no build steps";
+            return false;
+        }
+        return true;
+    }
+
+    // 运行命令并读取标准输出，命令失败时返回false
+    bool read_command(const std::string& command, std::string& output)
+    {
+        FILE* pipe = popen(command.data(), "r");
+        if (!pipe)
+        {
+            return false;
+        }
+        char buffer[65536];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        {
+            output.append(buffer, size);
+        }
+        return pclose(pipe) == 0;
+    }
+
+    // 读取文件全部内容
+    bool read_file(const std::string& path, std::string& content)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        content = text.str();
+        return static_cast<bool>(in);
+    }
+
+    // 读取DOT中从pos开始的带引号字符串（处理反斜杠转义），pos移到结尾引号之后
+    bool read_quoted(const std::string& line, size_t& pos, std::string& text)
+    {
+        if (pos >= line.size() || line[pos] != '"')
+        {
+            return false;
+        }
+        text.clear();
+        for (pos++; pos < line.size(); pos++)
+        {
+            if (line[pos] == '\\' && pos + 1 < line.size())
+            {
+                text += line[++pos];
+            }
+            else if (line[pos] == '"')
+            {
+                pos++;
+                return true;
+            }
+            else
+            {
+                text += line[pos];
+            }
+        }
+        return false;
+    }
+
+    // 解析ninja -t graph的输出（GraphViz DOT）
+    // 文件节点：  "ID" [label="路径"]
+    // 构建边节点："ID" [label="规则", shape=ellipse]（多个输入或输出的构建边）
+    // 连线：      "输入" -> "边" [arrowhead=none]、"边" -> "输出"，单输入单输出时"输入" -> "输出" [label=" 规则"]
+    // order-only输入（style=dotted）只决定顺序，不是数据依赖，不计入
+    bool parse_ninja_graph(const std::string& text, DependencyGraph& graph)
+    {
+        std::map<std::string, std::string> files;             // 节点ID -> 路径
+        std::set<std::string> edges;                          // 构建边节点ID
+        std::vector<std::pair<std::string, std::string>> arcs;
+        std::stringstream in(text);
+        for (std::string line; std::getline(in, line);)
+        {
+            size_t pos = line.find('"');
+            std::string from;
+            if (pos == std::string::npos || !read_quoted(line, pos, from))
+            {
+                continue;
+            }
+            size_t arrow = line.find("->", pos);
+            if (arrow != std::string::npos)
+            {
+                std::string to;
+                pos = line.find('"', arrow);
+                if (pos != std::string::npos && read_quoted(line, pos, to) &&
+                    line.find("style=dotted", pos) == std::string::npos)
+                {
+                    arcs.emplace_back(from, to);
+                }
+                continue;
+            }
+            size_t label = line.find("label=", pos);
+            std::string name;
+            if (label == std::string::npos || !read_quoted(line, label += strlen("label="), name))
+            {
+                continue;
+            }
+            if (line.find("shape=ellipse", label) != std::string::npos)
+            {
+                edges.insert(from);
+            }
+            else
+            {
+                files[from] = name;
+            }
+        }
+        if (files.empty())
+        {
+            return false;
+        }
+
+        // 先收集每个构建边节点的输入，再把它们连到该构建边的输出
+        std::map<std::string, std::vector<std::string>> edge_inputs;
+        for (const auto& [from, to] : arcs)
+        {
+            if (edges.count(to) && files.count(from))
+            {
+                edge_inputs[to].push_back(files[from]);
+            }
+        }
+        for (const auto& [from, to] : arcs)
+        {
+            if (!files.count(to))
+            {
+                continue;
+            }
+            std::vector<std::string>& inputs = graph[files[to]];
+            if (edges.count(from))
+            {
+                const auto& from_inputs = edge_inputs[from];
+                inputs.insert(inputs.end(), from_inputs.begin(), from_inputs.end());
+            }
+            else if (files.count(from))
+            {
+                inputs.push_back(files[from]);
+            }
+        }
+        return true;
+    }
+
+    // 解析ninja -t deps的输出，把头文件依赖加入依赖图（生成的头文件由此连到生成它的步骤）
+    //   输出: #deps N, deps mtime T (VALID)
+    //       依赖1
+    //       依赖2
+    void parse_ninja_deps(const std::string& text, DependencyGraph& graph)
+    {
+        std::stringstream in(text);
+        std::vector<std::string>* inputs = nullptr;
+        for (std::string line; std::getline(in, line);)
+        {
+            if (line.empty())
+            {
+                inputs = nullptr;
+            }
+            else if (line[0] == ' ' || line[0] == '\t')
+            {
+                if (inputs)
+                {
+                    inputs->push_back(line.substr(line.find_first_not_of(" \t")));
+                }
+            }
+            else
+            {
+                size_t colon = line.find(": #deps ");
+                inputs = colon == std::string::npos ? nullptr : &graph[line.substr(0, colon)];
+            }
+        }
+    }
+
+    // 读取依赖图：优先使用保存的输出，否则在构建目录中运行ninja
+    bool load_dependency_graph(const std::string& ninja_dir, const std::string& graph_path,
+        const std::string& deps_path, DependencyGraph& graph, std::string& error)
+    {
+        // 构建目录用单引号传给shell（其中的单引号写作'\''）
+        std::string quoted_dir = "'";
+        for (char c : ninja_dir)
+        {
+            quoted_dir += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        quoted_dir += "'";
+
+        std::string text;
+        bool ok = graph_path.empty() ? read_command("ninja -C " + quoted_dir + " -t graph 2>/dev/null", text)
+            : read_file(graph_path, text);
+        if (!ok || !parse_ninja_graph(text, graph))
+        {
+            error = graph_path.empty() ? "couldn't run 'ninja -t graph' in " + ninja_dir
+                : graph_path + ": not a ninja graph";
+            return false;
+        }
+
+        // 头文件依赖可选：没有依赖日志时只使用构建边
+        text.clear();
+        if (deps_path.empty() ? read_command("ninja -C " + quoted_dir + " -t deps 2>/dev/null", text)
+            : read_file(deps_path, text))
+        {
+            parse_ninja_deps(text, graph);
+        }
+        return true;
+    }
+
+    // 关键路径：依赖图上按步骤耗时（.ninja_log）加权的最长路径
+    // 步骤的前驱是生成其输入文件的步骤；输入不是本次构建的步骤的输出时（phony别名、
+    // 未重新构建的目标）继续沿该文件的输入查找
+    std::vector<const BuildStep*> critical_path(const std::vector<BuildStep>& steps, const DependencyGraph& graph)
+    {
+        std::map<std::string, size_t> producer;  // 输出文件 -> 步骤下标
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            for (const std::string& output : steps[i].outputs)
+            {
+                producer[output] = i;
+            }
+        }
+
+        // 每个步骤的直接前驱步骤
+        std::vector<std::set<size_t>> predecessors(steps.size());
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            std::vector<std::string> pending;
+            std::set<std::string> visited;
+            for (const std::string& output : steps[i].outputs)
+            {
+                visited.insert(output);
+                auto it = graph.find(output);
+                if (it != graph.end())
+                {
+                    pending.insert(pending.end(), it->second.begin(), it->second.end());
+                }
+            }
+            while (!pending.empty())
+            {
+                std::string file = std::move(pending.back());
+                pending.pop_back();
+                if (!visited.insert(file).second)
+                {
+                    continue;
+                }
+                auto step = producer.find(file);
+                if (step != producer.end())
+                {
+                    predecessors[i].insert(step->second);
+                    continue;
+                }
+                auto it = graph.find(file);
+                if (it != graph.end())
+                {
+                    pending.insert(pending.end(), it->second.begin(), it->second.end());
+                }
+            }
+        }
+
+        // 按开始时间处理：前驱在步骤开始之前已经结束，处理到步骤时前驱的最长路径已经确定
+        std::vector<size_t> order(steps.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            return steps[a].start_ms < steps[b].start_ms;
+        });
+        std::vector<double> longest(steps.size(), -1);  // 以步骤结束的最长路径（-1表示尚未处理）
+        std::vector<int> previous(steps.size(), -1);    // 最长路径上的前一个步骤
+        size_t last = order.front();
+        for (size_t i : order)
+        {
+            double best = 0;
+            for (size_t p : predecessors[i])
+            {
+                if (longest[p] > best)
+                {
+                    best = longest[p];
+                    previous[i] = static_cast<int>(p);
+                }
+            }
+            longest[i] = best + (steps[i].end_ms - steps[i].start_ms);
+            if (longest[i] > longest[last])
+            {
+                last = i;
+            }
+        }
+
+        std::vector<const BuildStep*> path;
+        for (int i = static_cast<int>(last); i >= 0; i = previous[i])
+        {
+            path.push_back(&steps[i]);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // 没有依赖图时按时间推断：从最后结束的步骤开始，每次取在它开始之前（或同时）结束得最晚的步骤，
+    // 同时结束的步骤中取耗时最长的；并行构建中这常常是恰好让出执行槽的无关步骤
+    std::vector<const BuildStep*> timing_critical_path(const std::vector<BuildStep>& steps)
+    {
+        std::vector<const BuildStep*> by_end;
+        for (const BuildStep& step : steps)
+        {
+            by_end.push_back(&step);
+        }
+        std::sort(by_end.begin(), by_end.end(), [](const BuildStep* a, const BuildStep* b)
+        {
+            return a->end_ms != b->end_ms ? a->end_ms < b->end_ms : a->start_ms > b->start_ms;
+        });
+
+        std::vector<const BuildStep*> path{by_end.back()};
+        while (true)
+        {
+            double start = path.back()->start_ms;
+            auto it = std::upper_bound(by_end.begin(), by_end.end(), start, [](double value, const BuildStep* step)
+            {
+                return value < step->end_ms;
+            });
+            if (it == by_end.begin() || (*std::prev(it))->start_ms >= start)
+            {
+                break;  // 构建开始时就开始的步骤（或只剩零时长的步骤）
+            }
+            path.push_back(*std::prev(it));
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // 读取编译数据库（compile_commands.json），只保留有output字段的项
+    bool read_compdb(const std::string& path, std::vector<CompileCommand>& commands, std::string& error)
+    {
+        std::ifstream in(path);
+        std::stringstream content;
+        content << in.rdbuf();
+        JsonValue root;
+        if (!in || !parse_json(content.str(), root, error) || root.type != JsonValue::ARRAY)
+        {
+            error = path + ": " + (error.empty() ? "not a compilation database" : error);
+            return false;
+        }
+        for (const JsonValue& entry : root.array)
+        {
+            const JsonValue* file = entry.get("file");
+            const JsonValue* output = entry.get("output");
+            const JsonValue* directory = entry.get("directory");
+            if (!file || !output)
+            {
+                continue;
+            }
+            std::filesystem::path source = file->string_or_empty();
+            if (source.is_relative() && directory)
+            {
+                source = std::filesystem::path(directory->string_or_empty()) / source;
+            }
+            commands.push_back(CompileCommand{source.lexically_normal().string(), output->string_or_empty()});
+        }
+        return true;
+    }
+
+    // 读取trace并按类别分解时间
+    bool load_breakdown(const std::string& path, TuBreakdown& tu, std::string& error)
+    {
+        Trace trace;
+        if (!load_trace(path, trace, error))
+        {
+            return false;
+        }
+        tu.path = path;
+        tu.unit = trace_unit_name(trace);
+
+        std::vector<int> parents = span_parents(trace);
+        std::vector<double> self(trace.spans.size());
+        for (size_t i = 0; i < trace.spans.size(); i++)
+        {
+            self[i] += trace.spans[i].duration_us();
+            if (parents[i] >= 0)
+            {
+                self[parents[i]] -= trace.spans[i].duration_us();
+            }
+        }
+        for (size_t i = 0; i < trace.spans.size(); i++)
+        {
+            const TraceSpan& span = trace.spans[i];
+            tu.self_us[span.category] += self[i];
+            if (span.category == "TU")
+            {
+                tu.total_us = std::max(tu.total_us, span.duration_us());
+            }
+            else if (is_pass_category(span.category))
+            {
+                tu.passes_us[span.name] += span.duration_us();
+            }
+            else if (span.category == "PREPROCESS" && parents[i] >= 0 &&
+                trace.spans[parents[i]].category == "PREPROCESS" && trace.spans[parents[i]].name == tu.unit)
+            {
+                tu.headers_us[span.name] += span.duration_us();
+            }
+        }
+        return true;
+    }
+
+    // 为目标文件找到对应的翻译单元
+    // 有编译数据库时按其中的源文件精确匹配，否则取路径末尾相同分量最多的源文件
+    // （foo.cpp.o去掉.o后与foo.cpp比较，foo.o与去掉扩展名的foo比较），并列时不关联
+    const TuBreakdown* find_unit(const std::string& output, const std::vector<TuBreakdown>& units,
+        const std::vector<CompileCommand>& commands)
+    {
+        if (!commands.empty())
+        {
+            for (const CompileCommand& command : commands)
+            {
+                if (same_file(command.output, output))
+                {
+                    for (const TuBreakdown& tu : units)
+                    {
+                        if (!tu.unit.empty() && same_file(tu.unit, command.file))
+                        {
+                            return &tu;
+                        }
+                    }
+                    return nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        std::string stem = object_stem(output);
+        if (stem.empty())
+        {
+            return nullptr;
+        }
+        auto object = split_path(stem);
+        const TuBreakdown* best = nullptr;
+        size_t best_score = 0;
+        bool tie = false;
+        for (const TuBreakdown& tu : units)
+        {
+            auto source = split_path(tu.unit);
+            size_t score = common_suffix(object, source);
+            if (!source.empty())
+            {
+                source.back() = std::filesystem::path(source.back()).stem().string();
+                score = std::max(score, common_suffix(object, source));
+            }
+            if (score > best_score)
+            {
+                best = &tu;
+                best_score = score;
+                tie = false;
+            }
+            else if (score == best_score && score > 0)
+            {
+                tie = true;
+            }
+        }
+        return tie ? nullptr : best;
+    }
+
+    // 按时间从大到小列出前top项
+    void print_top(const char* title, const std::map<std::string, double>& values, size_t top, double total_us)
+    {
+        std::vector<std::pair<std::string, double>> entries(values.begin(), values.end());
+        std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b)
+        {
+            return a.second > b.second;
+        });
+        printf("    %s:\n", title);
+        for (size_t i = 0; i < entries.size() && i < top; i++)
+        {
+            printf("      %10.1f ms %5.1f%%  %s\n", entries[i].second / 1000,
+                total_us > 0 ? entries[i].second / total_us * 100 : 0.0, entries[i].first.data());
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: gperf-critical-path <.ninja_log> <trace directory or file...> "
+            "[--compdb compile_commands.json] [--top N] [--ninja-dir DIR] [--graph FILE] [--deps FILE]\n");
+        return 2;
+    }
+
+    const char* log_path = argv[1];
+    std::vector<std::string> trace_files;
+    std::string compdb_path;
+    std::string ninja_dir = std::filesystem::path(log_path).parent_path().string();
+    std::string graph_path;
+    std::string deps_path;
+    size_t top = 10;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--compdb" && i + 1 < argc)
+        {
+            compdb_path = argv[++i];
+        }
+        else if (option == "--ninja-dir" && i + 1 < argc)
+        {
+            ninja_dir = argv[++i];
+        }
+        else if (option == "--graph" && i + 1 < argc)
+        {
+            graph_path = argv[++i];
+        }
+        else if (option == "--deps" && i + 1 < argc)
+        {
+            deps_path = argv[++i];
+        }
+        else if (option == "--top" && i + 1 < argc)
+        {
+            top = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if (option.rfind("--", 0) == 0)
+        {
+            fprintf(stderr, "gperf-critical-path: unknown option %s\n", option.data());
+            return 2;
+        }
+        else
+        {
+            for (std::string& file : find_trace_files(option))
+            {
+                trace_files.push_back(std::move(file));
+            }
+        }
+    }
+
+    std::string error;
+    std::vector<BuildStep> steps;
+    std::vector<CompileCommand> commands;
+    if (!read_ninja_log(log_path, steps, error) ||
+        (!compdb_path.empty() && !read_compdb(compdb_path, commands, error)))
+    {
+        fprintf(stderr, "gperf-critical-path: %s\n", error.data());
+        return 1;
+    }
+
+    // 每个trace只保留时间分解，不同时保存所有trace
+    std::vector<TuBreakdown> units;
+    for (const std::string& file : trace_files)
+    {
+        TuBreakdown tu;
+        if (!load_breakdown(file, tu, error))
+        {
+            fprintf(stderr, "gperf-critical-path: %s\n", error.data());
+            continue;
+        }
+        units.push_back(std::move(tu));
+    }
+
+    // 依赖图上的最长路径；得不到依赖图时退回按时间推断，并明确说明
+    DependencyGraph graph;
+    std::vector<const BuildStep*> path;
+    if (load_dependency_graph(ninja_dir.empty() ? "." : ninja_dir, graph_path, deps_path, graph, error))
+    {
+        path = critical_path(steps, graph);
+    }
+    else
+    {
+        fprintf(stderr, "gperf-critical-path: %s; falling back to a timing heuristic\n", error.data());
+        path = timing_critical_path(steps);
+    }
+
+    double build_ms = 0;
+    double path_ms = 0;
+    for (const BuildStep& step : steps)
+    {
+        build_ms = std::max(build_ms, step.end_ms);
+    }
+    for (const BuildStep* step : path)
+    {
+        path_ms += step->end_ms - step->start_ms;
+    }
+    printf("critical path: %zu of %zu steps, %.3f s of %.3f s build (%zu traces)\n", path.size(), steps.size(),
+        path_ms / 1000, build_ms / 1000, units.size());
+    if (graph.empty())
+    {
+        printf("WARNING: no ninja dependency graph; this is a timing heuristic (each step's predecessor is the\n"
+            "step that finished latest before it started), which under -jN follows job slot handoffs,\n"
+            "not dependencies\n");
+    }
+    printf("\n");
+    printf("  %10s %10s  %s\n", "START", "DURATION", "OUTPUT");
+
+    std::vector<std::pair<const BuildStep*, const TuBreakdown*>> critical_units;
+    for (const BuildStep* step : path)
+    {
+        const TuBreakdown* tu = nullptr;
+        for (const std::string& output : step->outputs)
+        {
+            if ((tu = find_unit(output, units, commands)))
+            {
+                break;
+            }
+        }
+        printf("  %8.3f s %8.3f s  %s%s\n", step->start_ms / 1000, (step->end_ms - step->start_ms) / 1000,
+            step->outputs.front().data(), tu ? "" : (object_stem(step->outputs.front()).empty() ? "" : "  (no trace)"));
+        if (tu)
+        {
+            critical_units.emplace_back(step, tu);
+        }
+    }
+
+    // 每个关键翻译单元：类别的自身时间、直接包含的头文件和pass
+    std::map<std::string, double> critical_headers;
+    std::map<std::string, double> critical_passes;
+    std::map<std::string, double> critical_categories;
+    double critical_us = 0;
+    for (const auto& [step, tu] : critical_units)
+    {
+        printf("\n%s  (%s, step %.3f s, TU %.3f s)\n", tu->unit.data(), step->outputs.front().data(),
+            (step->end_ms - step->start_ms) / 1000, tu->total_us / 1e6);
+        std::map<std::string, double> categories;
+        for (const auto& [category, us] : tu->self_us)
+        {
+            categories[category == "TU" ? "(unattributed)" : category] = us;
+            critical_categories[category == "TU" ? "(unattributed)" : category] += us;
+        }
+        print_top("categories (self time)", categories, categories.size(), tu->total_us);
+        print_top("headers", tu->headers_us, top, tu->total_us);
+        print_top("passes", tu->passes_us, top, tu->total_us);
+        for (const auto& [header, us] : tu->headers_us)
+        {
+            critical_headers[header] += us;
+        }
+        for (const auto& [pass, us] : tu->passes_us)
+        {
+            critical_passes[pass] += us;
+        }
+        critical_us += tu->total_us;
+    }
+
+    // 整条关键路径上的汇总：缩短这些头文件和pass直接缩短构建时间
+    if (critical_units.size() > 1)
+    {
+        printf("\nall critical translation units (%zu, %.3f s):\n", critical_units.size(), critical_us / 1e6);
+        print_top("categories (self time)", critical_categories, critical_categories.size(), critical_us);
+        print_top("headers", critical_headers, top, critical_us);
+        print_top("passes", critical_passes, top, critical_us);
+    }
+    return 0;
+}
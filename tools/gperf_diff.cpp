@@ -0,0 +1,374 @@
+// gperf-diff：比较两组trace，找出变慢（变快）的头文件、函数和pass
+// 每组可以包含多次运行（每次运行是一个trace目录或文件），用多次运行之间的波动区分真实变化和噪声：
+// 每个事件在每次运行中的总时间（所有翻译单元相加）作为一个样本，
+// 变化量给出置信区间（Welch t区间），区间不包含0时才认为变化显著
+//
+// 用法：gperf-diff --before RUN... --after RUN... [--top N] [--min-delta-ms X] [--strip-prefix PREFIX]...
+//   --before/--after    之后的参数属于哪一组（每个参数是一次运行：trace目录或单个trace文件）
+//   --top N             每个方向列出的事件数量（默认20）
+//   --min-delta-ms X    忽略变化量小于X毫秒的事件（默认1）
+//   --strip-prefix P    匹配前去掉文件名的前缀P（不同构建目录、源码目录），可多次指定
+//
+// 事件按类别和规范化的名称匹配：预处理按文件，函数和声明按名称和所在文件，
+// pass按名称和static_pass_number，翻译单元按主源文件；
+// 标准库路径中的GCC版本号（/c++/13/、/gcc/<target>/13/）替换为*，升级GCC前后的头文件可以对应
+
+#include "trace_reader.h"  // trace解析
+
+#include <algorithm>       // 排序
+#include <cmath>           // sqrt、fabs
+#include <cstdio>          // 输出
+#include <cstdlib>         // atoi、atof
+#include <filesystem>      // 路径规范化
+#include <map>             // 按事件汇总
+#include <regex>           // GCC版本号
+#include <set>             // 所有出现过的事件
+#include <string>          // 字符串
+#include <vector>          // 向量容器
+
+using namespace GccTrace;
+
+namespace
+{
+    // 一次运行：事件键 -> 所有翻译单元中的总时间（微秒）
+    using RunTotals = std::map<std::string, double>;
+
+    // 一个事件在两组中的比较结果
+    struct EventDiff
+    {
+        std::string key;           // 事件键（类别 名称）
+        double before_us;          // 之前各次运行的平均时间
+        double after_us;           // 之后各次运行的平均时间
+        double delta_us;           // 平均时间之差
+        double margin_us;          // 置信区间半宽，-1表示样本不足（每组只有一次运行）
+    };
+
+    // 双侧95%的t分布临界值：自由度为小数或不在表中时取不大于它的最近一项（偏保守）
+    double t_critical(double df)
+    {
+        static const std::pair<double, double> table[] = {
+            {1, 12.706}, {2, 4.303}, {3, 3.182}, {4, 2.776}, {5, 2.571}, {6, 2.447}, {7, 2.365},
+            {8, 2.306}, {9, 2.262}, {10, 2.228}, {12, 2.179}, {15, 2.131}, {20, 2.086}, {30, 2.042},
+            {60, 2.000}, {120, 1.980}, {1000, 1.962}};
+        double value = table[0].second;
+        for (const auto& [table_df, critical] : table)
+        {
+            if (df < table_df)
+            {
+                break;
+            }
+            value = critical;
+        }
+        return value;
+    }
+
+    // 样本均值和方差（无偏）
+    void mean_variance(const std::vector<double>& samples, double& mean, double& variance)
+    {
+        mean = 0;
+        for (double sample : samples)
+        {
+            mean += sample;
+        }
+        mean /= samples.size();
+        variance = 0;
+        for (double sample : samples)
+        {
+            variance += (sample - mean) * (sample - mean);
+        }
+        variance = samples.size() > 1 ? variance / (samples.size() - 1) : 0;
+    }
+
+    // 比较两组样本
+    // 两组都有多次运行时用Welch t区间；只有一组有多次运行时假设两组的波动相同，用这一组的方差；
+    // 都只有一次运行时无法估计噪声，不给出区间
+    EventDiff compare(const std::string& key, const std::vector<double>& before, const std::vector<double>& after)
+    {
+        double before_mean, before_variance, after_mean, after_variance;
+        mean_variance(before, before_mean, before_variance);
+        mean_variance(after, after_mean, after_variance);
+
+        EventDiff diff{key, before_mean, after_mean, after_mean - before_mean, -1};
+        double n = static_cast<double>(before.size());
+        double m = static_cast<double>(after.size());
+        if (n > 1 && m > 1)
+        {
+            double a = before_variance / n;
+            double b = after_variance / m;
+            double se = std::sqrt(a + b);
+            double df = a + b > 0 ? (a + b) * (a + b) / (a * a / (n - 1) + b * b / (m - 1)) : n + m - 2;
+            diff.margin_us = t_critical(df) * se;
+        }
+        else if (n > 1 || m > 1)
+        {
+            double variance = n > 1 ? before_variance : after_variance;
+            double df = (n > 1 ? n : m) - 1;
+            diff.margin_us = t_critical(df) * std::sqrt(variance * (1 / n + 1 / m));
+        }
+        return diff;
+    }
+
+    // 规范化文件名：去掉指定前缀，GCC版本号替换为*
+    // 同一文件名在所有trace中反复出现，结果缓存（前缀在整个运行中不变）
+    std::string normalize_file(const std::string& file, const std::vector<std::string>& prefixes)
+    {
+        static const std::regex cxx_version("/c\\+\\+/[0-9][0-9.]*/");
+        static const std::regex gcc_version("/gcc/([^/]+)/[0-9][0-9.]*/");
+        static std::map<std::string, std::string> cache;
+        auto cached = cache.find(file);
+        if (cached != cache.end())
+        {
+            return cached->second;
+        }
+
+        std::string result = std::filesystem::path(file).lexically_normal().string();
+        for (const std::string& prefix : prefixes)
+        {
+            if (result.rfind(prefix, 0) == 0)
+            {
+                result = result.substr(prefix.size());
+                while (!result.empty() && result.front() == '/')
+                {
+                    result.erase(0, 1);
+                }
+                break;
+            }
+        }
+        result = std::regex_replace(result, cxx_version, "/c++/*/");
+        result = std::regex_replace(result, gcc_version, "/gcc/$1/*/");
+        return cache[file] = result;
+    }
+
+    // 事件键：类别加规范化的名称，没有可匹配的名称时返回空字符串
+    std::string event_key(const TraceSpan& span, const std::string& unit, const std::vector<std::string>& prefixes)
+    {
+        if (span.category == "TU")
+        {
+            return "TU " + normalize_file(unit, prefixes);
+        }
+        if (span.category == "PREPROCESS")
+        {
+            return "PREPROCESS " + normalize_file(span.name, prefixes);
+        }
+        if (is_pass_category(span.category))
+        {
+            std::string number = span.arg("static_pass_number");
+            return span.category + " " + span.name + (number.empty() ? "" : " #" + number);
+        }
+        if (span.category == "FUNCTION" || span.category == "DECLARATION" || span.category == "STRUCT" ||
+            span.category == "NAMESPACE")
+        {
+            std::string file = span.arg("file");
+            return span.category + " " + span.name + (file.empty() ? "" : " (" + normalize_file(file, prefixes) + ")");
+        }
+        return "";
+    }
+
+    // 读取一次运行的所有trace，按事件键累计时间
+    bool load_run(const std::string& path, const std::vector<std::string>& prefixes, RunTotals& totals,
+        size_t& trace_count)
+    {
+        std::vector<std::string> files = find_trace_files(path);
+        if (files.empty())
+        {
+            fprintf(stderr, "gperf-diff: no traces in %s\n", path.data());
+            return false;
+        }
+        for (const std::string& file : files)
+        {
+            Trace trace;
+            std::string error;
+            if (!load_trace(file, trace, error))
+            {
+                fprintf(stderr, "gperf-diff: %s\n", error.data());
+                continue;
+            }
+            std::string unit = trace_unit_name(trace);
+            for (const TraceSpan& span : trace.spans)
+            {
+                std::string key = event_key(span, unit, prefixes);
+                if (!key.empty())
+                {
+                    totals[key] += span.duration_us();
+                }
+                if (span.category == "TU")
+                {
+                    totals[""] += span.duration_us();  // 空键：整个构建的编译时间
+                }
+            }
+            trace_count++;
+        }
+        return true;
+    }
+
+    // 同一事件在各次运行中的样本（没有出现的运行计为0：事件被阈值过滤或不再存在）
+    std::vector<double> samples(const std::vector<RunTotals>& runs, const std::string& key)
+    {
+        std::vector<double> result;
+        for (const RunTotals& run : runs)
+        {
+            auto it = run.find(key);
+            result.push_back(it == run.end() ? 0 : it->second);
+        }
+        return result;
+    }
+
+    // 时间差（毫秒，带符号）
+    std::string signed_ms(double us)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%+.1f", us / 1000);
+        return text;
+    }
+
+    void print_diffs(const char* title, const std::vector<EventDiff>& diffs, size_t top)
+    {
+        printf("\n%s:\n", title);
+        printf("  %12s  %-22s %12s %12s  %s\n", "DELTA (ms)", "95% CI (ms)", "BEFORE (ms)", "AFTER (ms)", "EVENT");
+        for (size_t i = 0; i < diffs.size() && i < top; i++)
+        {
+            const EventDiff& diff = diffs[i];
+            std::string interval = diff.margin_us < 0 ? "n/a" :
+                "[" + signed_ms(diff.delta_us - diff.margin_us) + ", " + signed_ms(diff.delta_us + diff.margin_us) + "]";
+            printf("  %12s  %-22s %12.1f %12.1f  %s\n", signed_ms(diff.delta_us).data(), interval.data(),
+                diff.before_us / 1000, diff.after_us / 1000, diff.key.data());
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> before_paths;
+    std::vector<std::string> after_paths;
+    std::vector<std::string> prefixes;
+    std::vector<std::string>* current = nullptr;
+    size_t top = 20;
+    double min_delta_us = 1000;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--before")
+        {
+            current = &before_paths;
+        }
+        else if (option == "--after")
+        {
+            current = &after_paths;
+        }
+        else if (option == "--top" && i + 1 < argc)
+        {
+            top = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if (option == "--min-delta-ms" && i + 1 < argc)
+        {
+            min_delta_us = atof(argv[++i]) * 1000;
+        }
+        else if (option == "--strip-prefix" && i + 1 < argc)
+        {
+            prefixes.push_back(std::filesystem::path(argv[++i]).lexically_normal().string());
+        }
+        else if (current && option.rfind("--", 0) != 0)
+        {
+            current->push_back(option);
+        }
+        else
+        {
+            current = nullptr;
+            break;
+        }
+    }
+    if (!current || before_paths.empty() || after_paths.empty())
+    {
+        fprintf(stderr, "usage: gperf-diff --before RUN... --after RUN... [--top N] [--min-delta-ms X] "
+            "[--strip-prefix PREFIX]...\n       (each RUN is a trace directory or file)\n");
+        return 2;
+    }
+
+    // 较长的前缀先匹配
+    std::sort(prefixes.begin(), prefixes.end(), [](const std::string& a, const std::string& b)
+    {
+        return a.size() > b.size();
+    });
+
+    std::vector<RunTotals> before(before_paths.size());
+    std::vector<RunTotals> after(after_paths.size());
+    size_t before_traces = 0;
+    size_t after_traces = 0;
+    for (size_t i = 0; i < before_paths.size(); i++)
+    {
+        if (!load_run(before_paths[i], prefixes, before[i], before_traces))
+        {
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < after_paths.size(); i++)
+    {
+        if (!load_run(after_paths[i], prefixes, after[i], after_traces))
+        {
+            return 1;
+        }
+    }
+
+    printf("before: %zu run%s (%zu traces), after: %zu run%s (%zu traces)\n", before.size(),
+        before.size() == 1 ? "" : "s", before_traces, after.size(), after.size() == 1 ? "" : "s", after_traces);
+    if (before.size() < 2 && after.size() < 2)
+    {
+        printf("note: at least one side needs two or more runs for confidence intervals\n");
+    }
+
+    EventDiff total = compare("", samples(before, ""), samples(after, ""));
+    printf("total compile time: %.3f s -> %.3f s (%s ms, %+.1f%%", total.before_us / 1e6, total.after_us / 1e6,
+        signed_ms(total.delta_us).data(), total.before_us > 0 ? total.delta_us / total.before_us * 100 : 0.0);
+    if (total.margin_us >= 0)
+    {
+        printf(", 95%% CI [%s, %s] ms, %s", signed_ms(total.delta_us - total.margin_us).data(),
+            signed_ms(total.delta_us + total.margin_us).data(),
+            std::fabs(total.delta_us) > total.margin_us ? "significant" : "within noise");
+    }
+    printf(")\n");
+
+    // 所有出现过的事件
+    std::set<std::string> keys;
+    for (const auto* runs : {&before, &after})
+    {
+        for (const RunTotals& run : *runs)
+        {
+            for (const auto& [key, us] : run)
+            {
+                keys.insert(key);
+            }
+        }
+    }
+    keys.erase("");
+
+    // 变化量超过阈值、且置信区间不包含0（没有区间时只看阈值）的事件
+    std::vector<EventDiff> slower;
+    std::vector<EventDiff> faster;
+    size_t noise = 0;
+    for (const std::string& key : keys)
+    {
+        EventDiff diff = compare(key, samples(before, key), samples(after, key));
+        if (std::fabs(diff.delta_us) < min_delta_us)
+        {
+            continue;
+        }
+        if (diff.margin_us >= 0 && std::fabs(diff.delta_us) <= diff.margin_us)
+        {
+            noise++;
+            continue;
+        }
+        (diff.delta_us > 0 ? slower : faster).push_back(diff);
+    }
+    auto by_magnitude = [](const EventDiff& a, const EventDiff& b)
+    {
+        return std::fabs(a.delta_us) > std::fabs(b.delta_us);
+    };
+    std::sort(slower.begin(), slower.end(), by_magnitude);
+    std::sort(faster.begin(), faster.end(), by_magnitude);
+
+    print_diffs("slower", slower, top);
+    print_diffs("faster", faster, top);
+    printf("\n%zu slower, %zu faster, %zu changed within noise (of %zu events)\n", slower.size(), faster.size(),
+        noise, keys.size());
+    return 0;
+}
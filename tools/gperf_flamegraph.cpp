@@ -0,0 +1,191 @@
+// gperf-flamegraph：把trace导出为折叠栈（Brendan Gregg的folded stack格式）
+// 每行"帧;帧;...;帧 值"，值为该调用栈的自身时间（微秒），任意数量的trace中相同的栈相加；
+// 输出可直接交给flamegraph.pl、inferno、speedscope等工具
+//
+// 用法：gperf-flamegraph <trace目录或文件...> [-o out.folded] [--merge-tus]
+//   -o FILE       输出文件（默认标准输出）
+//   --merge-tus   所有翻译单元合并到同一个根帧"all"，整个构建中的同一头文件、pass合并为一个帧
+//
+// 栈帧来自插件的事件类别和嵌套关系：
+//   前端  TU > frontend > 头文件 > 嵌套包含的头文件 > 函数/声明/类/命名空间
+//   后端  TU > pass组（IPA/GIMPLE/RTL） > pass > 函数（passFunctions报告中的名称）
+
+#include "trace_reader.h"  // trace解析
+
+#include <cmath>           // llround
+#include <cstdio>          // 输出
+#include <cstdlib>         // strtoul
+#include <map>             // 按栈汇总
+#include <string>          // 字符串
+#include <vector>          // 向量容器
+
+using namespace GccTrace;
+
+namespace
+{
+    // 栈帧名称中不能出现分号（帧分隔符）和换行，替换为冒号和空格
+    std::string frame_name(const std::string& name)
+    {
+        std::string frame = name.empty() ? "?" : name;
+        for (char& c : frame)
+        {
+            if (c == ';')
+            {
+                c = ':';
+            }
+            else if (c == '\n' || c == '\r')
+            {
+                c = ' ';
+            }
+        }
+        return frame;
+    }
+
+    // pass组：IPA pass合为一组，GIMPLE和RTL各为一组
+    const char* pass_group(const std::string& category)
+    {
+        if (category == "GIMPLE_PASS")
+        {
+            return "GIMPLE";
+        }
+        if (category == "RTL_PASS")
+        {
+            return "RTL";
+        }
+        return "IPA";
+    }
+
+    // 把一个trace的自身时间按栈累计到stacks
+    void fold_trace(const Trace& trace, bool merge_tus, std::map<std::string, double>& stacks)
+    {
+        std::string unit = trace_unit_name(trace);
+        const JsonValue* pass_functions = trace.report("passFunctions");
+        std::vector<int> parents = span_parents(trace);
+
+        // 每个事件的栈（父事件的栈加上自身的帧），事件按开始时间排序，父事件总在子事件之前
+        // 栈直接驻留在stacks中，每个事件只保存指向它的迭代器
+        std::vector<std::map<std::string, double>::iterator> nodes(trace.spans.size());
+        std::vector<double> self(trace.spans.size());
+        std::string root = merge_tus ? "all" : frame_name(unit.empty() ? trace.path : unit);
+        for (size_t i = 0; i < trace.spans.size(); i++)
+        {
+            const TraceSpan& span = trace.spans[i];
+            self[i] += span.duration_us();
+            const std::string& parent = parents[i] >= 0 ? nodes[parents[i]]->first : root;
+            if (parents[i] >= 0)
+            {
+                self[parents[i]] -= span.duration_us();
+            }
+
+            std::string stack;
+            if (span.category == "TU")
+            {
+                stack = parent;
+            }
+            else if (span.category == "PREPROCESS" && span.name == unit)
+            {
+                stack = parent + ";frontend";
+            }
+            else if (is_pass_category(span.category))
+            {
+                stack = parent + ";" + pass_group(span.category) + ";" + frame_name(span.name);
+
+                // 函数下标对应passFunctions报告（编译异常结束的trace没有这个报告）
+                std::string function = span.arg("function");
+                if (!function.empty() && pass_functions && pass_functions->type == JsonValue::ARRAY)
+                {
+                    size_t index = strtoul(function.data(), nullptr, 10);
+                    if (index < pass_functions->array.size())
+                    {
+                        stack += ";" + frame_name(pass_functions->array[index].string_or_empty());
+                    }
+                }
+            }
+            else
+            {
+                stack = parent + ";" + frame_name(span.name);
+            }
+            nodes[i] = stacks.try_emplace(std::move(stack), 0).first;
+        }
+
+        for (size_t i = 0; i < trace.spans.size(); i++)
+        {
+            nodes[i]->second += self[i];
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> trace_files;
+    const char* output_path = nullptr;
+    bool merge_tus = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (option == "--merge-tus")
+        {
+            merge_tus = true;
+        }
+        else if (option.rfind("-", 0) == 0)
+        {
+            fprintf(stderr, "gperf-flamegraph: unknown option %s\n", option.data());
+            return 2;
+        }
+        else
+        {
+            for (std::string& file : find_trace_files(option))
+            {
+                trace_files.push_back(std::move(file));
+            }
+        }
+    }
+    if (trace_files.empty())
+    {
+        fprintf(stderr, "usage: gperf-flamegraph <trace directory or file...> [-o out.folded] [--merge-tus]\n");
+        return 2;
+    }
+
+    // 逐个读取trace，只保留累计的栈
+    std::map<std::string, double> stacks;
+    size_t loaded = 0;
+    for (const std::string& file : trace_files)
+    {
+        Trace trace;
+        std::string error;
+        if (!load_trace(file, trace, error))
+        {
+            fprintf(stderr, "gperf-flamegraph: %s\n", error.data());
+            continue;
+        }
+        fold_trace(trace, merge_tus, stacks);
+        loaded++;
+    }
+
+    std::FILE* out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "gperf-flamegraph: couldn't open %s for writing\n", output_path);
+        return 1;
+    }
+    size_t lines = 0;
+    for (const auto& [stack, us] : stacks)
+    {
+        long long value = std::llround(us);
+        if (value > 0)
+        {
+            fprintf(out, "%s %lld\n", stack.data(), value);
+            lines++;
+        }
+    }
+    if (output_path)
+    {
+        fclose(out);
+    }
+    fprintf(stderr, "gperf-flamegraph: %zu traces, %zu stacks\n", loaded, lines);
+    return 0;
+}
@@ -0,0 +1,468 @@
+// gperf-sqlite：把trace导出为SQLite数据库，用SQL回答临时的构建耗时问题
+// （如"包含了Y的所有翻译单元中，命名空间X里解析最慢的20个函数"）
+//
+// 用法：gperf-sqlite <数据库> <trace目录或文件...>
+//   数据库已存在时覆盖
+//
+// 表结构（名称、文件、类别等字符串都存放在strings表中，其他表只保存编号）：
+//   strings(id, text)                              字符串表
+//   tus(id, trace, unit_id, beginning_us, duration_us, truncated, incomplete)
+//                                                   每个trace一行（翻译单元）
+//   events(id, tu_id, parent_id, category_id, name_id, file_id, start_us, duration_us, self_us, depth)
+//                                                   所有事件，parent_id为包含它的最内层事件，
+//                                                   self_us为不含嵌套事件的自身时间
+//   event_args(event_id, key_id, value)            其余的事件参数（member_count、rtl_insns等）
+//   includes(tu_id, event_id, includer_id, included_id, duration_us)
+//                                                   包含关系图：每次包含一行（预处理事件的嵌套关系）
+//   passes(event_id, static_pass_number, function_id)
+//                                                   pass事件的编号和处理的函数
+//   reports(tu_id, key, json)                      附加报告（JSON文本，可用SQLite的JSON函数查询）
+//
+// 插入在大事务中批量进行（预编译语句），索引在全部插入之后创建
+
+#include "trace_reader.h"  // trace解析
+
+#include <algorithm>       // max
+#include <cstdint>         // SIZE_MAX
+#include <cstdio>          // 输出
+#include <cstdlib>         // strtoll
+#include <string>          // 字符串
+#include <unordered_map>   // 字符串表缓存
+#include <vector>          // 向量容器
+
+#include <sqlite3.h>       // SQLite
+#include <unistd.h>        // unlink
+
+using namespace GccTrace;
+
+namespace
+{
+    // 每个事务插入的最大行数（一次提交的行数越多越快，同时限制回滚日志的大小）
+    constexpr int64_t ROWS_PER_TRANSACTION = 1000000;
+
+    const char* SCHEMA = R"sql(
+        PRAGMA journal_mode = MEMORY;
+        PRAGMA synchronous = OFF;
+        CREATE TABLE strings (id INTEGER PRIMARY KEY, text TEXT NOT NULL);
+        CREATE TABLE tus (id INTEGER PRIMARY KEY, trace TEXT NOT NULL, unit_id INTEGER REFERENCES strings,
+            beginning_us REAL, duration_us REAL, truncated INTEGER NOT NULL, incomplete TEXT);
+        CREATE TABLE events (id INTEGER PRIMARY KEY, tu_id INTEGER NOT NULL REFERENCES tus,
+            parent_id INTEGER REFERENCES events, category_id INTEGER NOT NULL REFERENCES strings,
+            name_id INTEGER NOT NULL REFERENCES strings, file_id INTEGER REFERENCES strings,
+            start_us REAL NOT NULL, duration_us REAL NOT NULL, self_us REAL NOT NULL, depth INTEGER NOT NULL);
+        CREATE TABLE event_args (event_id INTEGER NOT NULL REFERENCES events,
+            key_id INTEGER NOT NULL REFERENCES strings, value TEXT);
+        CREATE TABLE includes (tu_id INTEGER NOT NULL REFERENCES tus, event_id INTEGER NOT NULL REFERENCES events,
+            includer_id INTEGER NOT NULL REFERENCES strings, included_id INTEGER NOT NULL REFERENCES strings,
+            duration_us REAL NOT NULL);
+        CREATE TABLE passes (event_id INTEGER PRIMARY KEY REFERENCES events, static_pass_number INTEGER,
+            function_id INTEGER REFERENCES strings);
+        CREATE TABLE reports (tu_id INTEGER NOT NULL REFERENCES tus, key TEXT NOT NULL, json TEXT NOT NULL);
+    )sql";
+
+    const char* INDICES = R"sql(
+        CREATE UNIQUE INDEX strings_text ON strings (text);
+        CREATE INDEX tus_unit ON tus (unit_id);
+        CREATE INDEX events_tu ON events (tu_id);
+        CREATE INDEX events_parent ON events (parent_id);
+        CREATE INDEX events_category ON events (category_id);
+        CREATE INDEX events_name ON events (name_id);
+        CREATE INDEX events_file ON events (file_id);
+        CREATE INDEX event_args_event ON event_args (event_id);
+        CREATE INDEX includes_tu ON includes (tu_id);
+        CREATE INDEX includes_includer ON includes (includer_id);
+        CREATE INDEX includes_included ON includes (included_id);
+        CREATE INDEX passes_number ON passes (static_pass_number);
+        CREATE INDEX passes_function ON passes (function_id);
+        CREATE INDEX reports_tu ON reports (tu_id, key);
+    )sql";
+
+    // 预编译的插入语句（所有trace共用）
+    class Statement
+    {
+    public:
+        Statement(sqlite3* db, const char* sql)
+        {
+            if (sqlite3_prepare_v2(db, sql, -1, &statement, nullptr) != SQLITE_OK)
+            {
+                fprintf(stderr, "gperf-sqlite: %s\n", sqlite3_errmsg(db));
+                statement = nullptr;
+            }
+        }
+        ~Statement()
+        {
+            sqlite3_finalize(statement);
+        }
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+
+        bool valid() const
+        {
+            return statement != nullptr;
+        }
+
+        // 绑定参数（从1开始），0表示NULL的编号列用bind_id
+        void bind(int index, int64_t value)
+        {
+            sqlite3_bind_int64(statement, index, value);
+        }
+        void bind(int index, double value)
+        {
+            sqlite3_bind_double(statement, index, value);
+        }
+        void bind(int index, const std::string& value)
+        {
+            sqlite3_bind_text(statement, index, value.data(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+        }
+        void bind_id(int index, int64_t id)
+        {
+            if (id > 0)
+            {
+                sqlite3_bind_int64(statement, index, id);
+            }
+            else
+            {
+                sqlite3_bind_null(statement, index);
+            }
+        }
+
+        // 执行并重置，供下一行使用
+        bool run()
+        {
+            int result = sqlite3_step(statement);
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+            return result == SQLITE_DONE;
+        }
+
+    private:
+        sqlite3_stmt* statement = nullptr;
+    };
+
+    // 导出器：字符串表缓存在内存中，编号由导出器分配
+    class Exporter
+    {
+    public:
+        explicit Exporter(sqlite3* db) :
+            db(db),
+            insert_string(db, "INSERT INTO strings (id, text) VALUES (?, ?)"),
+            insert_tu(db, "INSERT INTO tus (id, trace, unit_id, beginning_us, duration_us, truncated, incomplete) "
+                "VALUES (?, ?, ?, ?, ?, ?, ?)"),
+            insert_event(db, "INSERT INTO events (id, tu_id, parent_id, category_id, name_id, file_id, "
+                "start_us, duration_us, self_us, depth) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"),
+            insert_arg(db, "INSERT INTO event_args (event_id, key_id, value) VALUES (?, ?, ?)"),
+            insert_include(db, "INSERT INTO includes (tu_id, event_id, includer_id, included_id, duration_us) "
+                "VALUES (?, ?, ?, ?, ?)"),
+            insert_pass(db, "INSERT INTO passes (event_id, static_pass_number, function_id) VALUES (?, ?, ?)"),
+            insert_report(db, "INSERT INTO reports (tu_id, key, json) VALUES (?, ?, ?)")
+        {
+        }
+
+        bool valid() const
+        {
+            return insert_string.valid() && insert_tu.valid() && insert_event.valid() && insert_arg.valid() &&
+                insert_include.valid() && insert_pass.valid() && insert_report.valid();
+        }
+
+        // 导出一个trace
+        bool add_trace(const Trace& trace)
+        {
+            begin_batch();
+            int64_t tu_id = ++tu_count;
+            std::string unit = trace_unit_name(trace);
+            const JsonValue* beginning = trace.root.get("beginningOfTime");
+            const JsonValue* incomplete = trace.report("incomplete");
+            const JsonValue* pass_functions = trace.report("passFunctions");
+
+            std::vector<int> parents = span_parents(trace);
+            std::vector<double> self(trace.spans.size());
+            std::vector<int> depth(trace.spans.size());
+            double duration_us = 0;
+            for (size_t i = 0; i < trace.spans.size(); i++)
+            {
+                self[i] += trace.spans[i].duration_us();
+                if (parents[i] >= 0)
+                {
+                    self[parents[i]] -= trace.spans[i].duration_us();
+                    depth[i] = depth[parents[i]] + 1;
+                }
+                if (trace.spans[i].category == "TU")
+                {
+                    duration_us = std::max(duration_us, trace.spans[i].duration_us());
+                }
+            }
+
+            insert_tu.bind(1, tu_id);
+            insert_tu.bind(2, trace.path);
+            insert_tu.bind_id(3, unit.empty() ? 0 : string_id(unit));
+            insert_tu.bind(4, beginning ? beginning->number_or(0) : 0.0);
+            insert_tu.bind(5, duration_us);
+            insert_tu.bind(6, static_cast<int64_t>(trace.truncated));
+            if (incomplete && incomplete->get("reason"))
+            {
+                insert_tu.bind(7, incomplete->get("reason")->string_or_empty());
+            }
+            if (!step(insert_tu))
+            {
+                return false;
+            }
+
+            int64_t first_event = event_count + 1;
+            for (size_t i = 0; i < trace.spans.size(); i++)
+            {
+                const TraceSpan& span = trace.spans[i];
+                int64_t event_id = first_event + static_cast<int64_t>(i);
+                int64_t parent_id = parents[i] >= 0 ? first_event + parents[i] : 0;
+                std::string file = span.arg("file");
+
+                insert_event.bind(1, event_id);
+                insert_event.bind(2, tu_id);
+                insert_event.bind_id(3, parent_id);
+                insert_event.bind(4, string_id(span.category));
+                insert_event.bind(5, string_id(span.name));
+                insert_event.bind_id(6, file.empty() ? 0 : string_id(file));
+                insert_event.bind(7, span.start_us);
+                insert_event.bind(8, span.duration_us());
+                insert_event.bind(9, self[i]);
+                insert_event.bind(10, static_cast<int64_t>(depth[i]));
+                if (!step(insert_event))
+                {
+                    return false;
+                }
+
+                // 包含关系：预处理事件嵌套在另一个预处理事件中
+                if (span.category == "PREPROCESS" && parents[i] >= 0 &&
+                    trace.spans[parents[i]].category == "PREPROCESS")
+                {
+                    insert_include.bind(1, tu_id);
+                    insert_include.bind(2, event_id);
+                    insert_include.bind(3, string_id(trace.spans[parents[i]].name));
+                    insert_include.bind(4, string_id(span.name));
+                    insert_include.bind(5, span.duration_us());
+                    if (!step(insert_include))
+                    {
+                        return false;
+                    }
+                }
+
+                if (is_pass_category(span.category))
+                {
+                    std::string number = span.arg("static_pass_number");
+                    std::string function = span.arg("function");
+                    size_t index = function.empty() ? SIZE_MAX : strtoull(function.data(), nullptr, 10);
+                    insert_pass.bind(1, event_id);
+                    if (!number.empty())
+                    {
+                        insert_pass.bind(2, static_cast<int64_t>(strtoll(number.data(), nullptr, 10)));
+                    }
+                    insert_pass.bind_id(3, pass_functions && index < pass_functions->array.size() ?
+                        string_id(pass_functions->array[index].string_or_empty()) : 0);
+                    if (!step(insert_pass))
+                    {
+                        return false;
+                    }
+                }
+
+                // 其余参数（已单独成列的参数和配对用的UID除外）
+                if (span.args && span.args->type == JsonValue::OBJECT)
+                {
+                    for (const auto& [key, value] : span.args->object)
+                    {
+                        if (key == "UID" || key == "file" || key == "static_pass_number" || key == "function")
+                        {
+                            continue;
+                        }
+                        insert_arg.bind(1, event_id);
+                        insert_arg.bind(2, string_id(key));
+                        if (value.type == JsonValue::STRING)
+                        {
+                            insert_arg.bind(3, value.string);
+                        }
+                        else
+                        {
+                            std::string text;
+                            append_json(text, value);
+                            insert_arg.bind(3, text);
+                        }
+                        if (!step(insert_arg))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            event_count += static_cast<int64_t>(trace.spans.size());
+
+            // 附加报告：除traceEvents和文件头以外的顶层键
+            for (const auto& [key, value] : trace.root.object)
+            {
+                if (key == "traceEvents" || key == "displayTimeUnit" || key == "beginningOfTime")
+                {
+                    continue;
+                }
+                std::string text;
+                append_json(text, value);
+                insert_report.bind(1, tu_id);
+                insert_report.bind(2, key);
+                insert_report.bind(3, text);
+                if (!step(insert_report))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 提交最后一个事务并创建索引
+        bool finish()
+        {
+            return end_batch() && exec(INDICES) && exec("ANALYZE");
+        }
+
+        int64_t events() const
+        {
+            return event_count;
+        }
+
+    private:
+        // 执行语句，计入当前事务的行数
+        bool step(Statement& statement)
+        {
+            if (!statement.run())
+            {
+                fprintf(stderr, "gperf-sqlite: %s\n", sqlite3_errmsg(db));
+                return false;
+            }
+            batch_rows++;
+            return true;
+        }
+
+        bool exec(const char* sql)
+        {
+            char* message = nullptr;
+            if (sqlite3_exec(db, sql, nullptr, nullptr, &message) != SQLITE_OK)
+            {
+                fprintf(stderr, "gperf-sqlite: %s\n", message ? message : sqlite3_errmsg(db));
+                sqlite3_free(message);
+                return false;
+            }
+            return true;
+        }
+
+        // 每个trace开始时检查：当前事务的行数达到上限时提交，开始新的事务
+        void begin_batch()
+        {
+            if (in_transaction && batch_rows < ROWS_PER_TRANSACTION)
+            {
+                return;
+            }
+            end_batch();
+            exec("BEGIN");
+            in_transaction = true;
+            batch_rows = 0;
+        }
+
+        bool end_batch()
+        {
+            if (!in_transaction)
+            {
+                return true;
+            }
+            in_transaction = false;
+            return exec("COMMIT");
+        }
+
+        // 字符串的编号（第一次出现时插入strings表）
+        int64_t string_id(const std::string& text)
+        {
+            auto [it, inserted] = string_ids.try_emplace(text, static_cast<int64_t>(string_ids.size() + 1));
+            if (inserted)
+            {
+                insert_string.bind(1, it->second);
+                insert_string.bind(2, text);
+                step(insert_string);
+            }
+            return it->second;
+        }
+
+        sqlite3* db;
+        Statement insert_string;
+        Statement insert_tu;
+        Statement insert_event;
+        Statement insert_arg;
+        Statement insert_include;
+        Statement insert_pass;
+        Statement insert_report;
+        std::unordered_map<std::string, int64_t> string_ids;  // 字符串 -> 编号
+        int64_t tu_count = 0;
+        int64_t event_count = 0;
+        int64_t batch_rows = 0;           // 当前事务已插入的行数
+        bool in_transaction = false;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: gperf-sqlite <database> <trace directory or file...>\n");
+        return 2;
+    }
+
+    std::vector<std::string> trace_files;
+    for (int i = 2; i < argc; i++)
+    {
+        for (std::string& file : find_trace_files(argv[i]))
+        {
+            trace_files.push_back(std::move(file));
+        }
+    }
+
+    const char* db_path = argv[1];
+    unlink(db_path);
+    sqlite3* db = nullptr;
+    if (sqlite3_open(db_path, &db) != SQLITE_OK ||
+        sqlite3_exec(db, SCHEMA, nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        fprintf(stderr, "gperf-sqlite: %s: %s\n", db_path, db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return 1;
+    }
+
+    int status = 0;
+    size_t exported = 0;
+    {
+        Exporter exporter(db);
+        if (!exporter.valid())
+        {
+            sqlite3_close(db);
+            return 1;
+        }
+
+        // 逐个读取trace，导出后即释放
+        for (const std::string& file : trace_files)
+        {
+            Trace trace;
+            std::string error;
+            if (!load_trace(file, trace, error))
+            {
+                fprintf(stderr, "gperf-sqlite: %s\n", error.data());
+                continue;
+            }
+            if (!exporter.add_trace(trace))
+            {
+                status = 1;
+                break;
+            }
+            exported++;
+        }
+        if (!exporter.finish())
+        {
+            status = 1;
+        }
+        fprintf(stderr, "gperf-sqlite: %zu traces, %lld events written to %s\n", exported,
+            static_cast<long long>(exporter.events()), db_path);
+    }
+    sqlite3_close(db);
+    return status;
+}
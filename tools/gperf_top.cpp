@@ -0,0 +1,259 @@
+// gperf-top：查看构建中所有正在运行的编译
+// 以-fplugin-arg-gperf-live编译时，插件把当前阶段、pass、函数和包含深度发布到共享内存/gperf-<pid>；
+// gperf-top定期读取所有这样的共享内存，按已编译时间从长到短列出，找出构建中拖后腿的翻译单元
+//
+// 用法：gperf-top [--once] [--interval SECONDS]
+//   --once       只输出一次（不清屏），用于脚本
+//   --interval   刷新间隔（秒，默认1）
+
+#include "live_status.h"   // 共享内存布局
+
+#include <algorithm>       // 排序
+#include <atomic>          // atomic_ref、内存屏障（顺序锁）
+#include <cerrno>          // errno
+#include <chrono>          // 当前时间
+#include <csignal>         // kill
+#include <cstdio>          // 输出
+#include <cstdlib>         // atof、free
+#include <cstring>         // strncmp、memcpy
+#include <cxxabi.h>        // 函数汇编名称反修饰
+#include <string>          // 字符串
+#include <vector>          // 向量容器
+
+#include <dirent.h>        // 遍历/dev/shm
+#include <fcntl.h>         // open
+#include <sys/ioctl.h>     // 终端宽度
+#include <sys/mman.h>      // mmap、shm_unlink
+#include <sys/stat.h>      // fstat
+#include <unistd.h>        // close、usleep
+
+using namespace GccTrace;
+
+namespace
+{
+    // POSIX共享内存在Linux上的挂载点
+    constexpr const char* SHM_DIR = "/dev/shm";
+
+    // 读取到一致记录之前的最大重试次数（写入方一直在更新时放弃这一轮）
+    constexpr int MAX_READ_ATTEMPTS = 100;
+
+    // 用顺序锁读取状态记录：sequence为偶数且读取前后不变时内容一致
+    bool read_status(const LiveStatus* shared, LiveStatus& status)
+    {
+        std::atomic_ref<uint32_t> sequence{const_cast<uint32_t&>(shared->sequence)};
+        for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+        {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue;
+            }
+            memcpy(&status, shared, sizeof(LiveStatus));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 读取一个共享内存对象；编译进程已不存在（被SIGKILL，未删除共享内存）时清理它
+    bool load_status(const char* name, LiveStatus& status)
+    {
+        std::string path = std::string(SHM_DIR) + "/" + name;
+        int fd = open(path.data(), O_RDONLY);
+        if (fd == -1)
+        {
+            return false;  // 编译恰好结束
+        }
+        struct stat info;
+        if (fstat(fd, &info) == -1 || info.st_size < static_cast<off_t>(sizeof(LiveStatus)))
+        {
+            close(fd);
+            return false;  // 插件尚未完成初始化，或不是插件创建的对象
+        }
+        void* memory = mmap(nullptr, sizeof(LiveStatus), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            return false;
+        }
+        bool valid = read_status(static_cast<const LiveStatus*>(memory), status);
+        munmap(memory, sizeof(LiveStatus));
+
+        valid = valid && status.magic == LIVE_STATUS_MAGIC && status.version == LIVE_STATUS_VERSION;
+        if (valid && kill(status.pid, 0) == -1 && errno == ESRCH)
+        {
+            shm_unlink((std::string("/") + name).data());
+            return false;
+        }
+        return valid;
+    }
+
+    // 读取所有正在运行的编译，按已编译时间从长到短排列
+    std::vector<LiveStatus> load_all()
+    {
+        std::vector<LiveStatus> result;
+        DIR* dir = opendir(SHM_DIR);
+        if (!dir)
+        {
+            return result;
+        }
+        size_t prefix_length = strlen(LIVE_STATUS_PREFIX);
+        while (dirent* entry = readdir(dir))
+        {
+            LiveStatus status;
+            if (!strncmp(entry->d_name, LIVE_STATUS_PREFIX, prefix_length) && load_status(entry->d_name, status))
+            {
+                result.push_back(status);
+            }
+        }
+        closedir(dir);
+        std::sort(result.begin(), result.end(), [](const LiveStatus& a, const LiveStatus& b) {
+            return a.start_unix_ns < b.start_unix_ns;
+        });
+        return result;
+    }
+
+    // 时长：一分钟以内显示秒（一位小数），一小时以内显示分和秒，否则显示时和分
+    std::string format_duration(int64_t ns)
+    {
+        char text[32];
+        double seconds = static_cast<double>(std::max<int64_t>(ns, 0)) / 1e9;
+        if (seconds < 60)
+        {
+            snprintf(text, sizeof(text), "%.1fs", seconds);
+        }
+        else if (seconds < 3600)
+        {
+            snprintf(text, sizeof(text), "%dm%02ds", static_cast<int>(seconds) / 60, static_cast<int>(seconds) % 60);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "%dh%02dm", static_cast<int>(seconds) / 3600,
+                static_cast<int>(seconds) / 60 % 60);
+        }
+        return text;
+    }
+
+    // 函数名称：汇编名称反修饰，声明名称原样显示
+    std::string function_name(const char* name)
+    {
+        int result = 0;
+        char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &result);
+        if (!demangled)
+        {
+            return name;
+        }
+        std::string text = demangled;
+        free(demangled);
+        return text;
+    }
+
+    // 超过宽度的文本保留末尾（路径和函数签名的末尾更有区分度）
+    std::string fit(const std::string& text, size_t width)
+    {
+        if (text.size() <= width)
+        {
+            return text;
+        }
+        return width > 3 ? "..." + text.substr(text.size() - (width - 3)) : text.substr(0, width);
+    }
+
+    // 终端宽度（输出不是终端时不限制）
+    size_t terminal_width()
+    {
+        winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0)
+        {
+            return size.ws_col;
+        }
+        return 1000;
+    }
+
+    // 输出一屏：每个编译一行
+    // 前端显示包含深度和正在预处理的文件，优化阶段显示当前pass、已执行的时间和函数
+    void print_table(const std::vector<LiveStatus>& compiles)
+    {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        size_t width = terminal_width();
+
+        printf("%zu compile%s running\n\n", compiles.size(), compiles.size() == 1 ? "" : "s");
+        printf("%-8s %-8s %-9s %-24s %-8s %s\n", "PID", "ELAPSED", "PHASE", "PASS/DEPTH", "IN PASS", "UNIT / DETAIL");
+        for (const LiveStatus& status : compiles)
+        {
+            std::string where;
+            std::string in_pass;
+            std::string detail;
+            switch (status.phase)
+            {
+                case LivePhase::PARSE:
+                    where = "depth " + std::to_string(status.include_depth);
+                    detail = status.include_depth > 1 ? status.file : "";
+                    break;
+                case LivePhase::IPA:
+                case LivePhase::GIMPLE:
+                case LivePhase::RTL:
+                    where = status.pass;
+                    in_pass = format_duration(now - status.start_unix_ns - status.pass_start_ns);
+                    detail = status.function[0] ? function_name(status.function) : "";
+                    break;
+                default:
+                    break;
+            }
+
+            char line[128];
+            int length = snprintf(line, sizeof(line), "%-8d %-8s %-9s %-24s %-8s ", status.pid,
+                format_duration(now - status.start_unix_ns).data(), live_phase_name(status.phase),
+                fit(where, 24).data(), in_pass.data());
+            size_t rest = width > static_cast<size_t>(length) ? width - length : 0;
+            std::string text = status.unit;
+            if (!detail.empty())
+            {
+                text += "  " + detail;
+            }
+            printf("%s%s\n", line, fit(text, rest).data());
+        }
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool once = false;
+    double interval = 1.0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--once")
+        {
+            once = true;
+        }
+        else if (option == "--interval" && i + 1 < argc && atof(argv[i + 1]) > 0)
+        {
+            interval = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: gperf-top [--once] [--interval SECONDS]\n");
+            return 2;
+        }
+    }
+
+    if (once)
+    {
+        print_table(load_all());
+        return 0;
+    }
+
+    // 持续刷新，直到被Ctrl-C终止
+    while (true)
+    {
+        std::vector<LiveStatus> compiles = load_all();
+        printf("\033[H\033[2J");  // 光标回到左上角并清屏
+        print_table(compiles);
+        usleep(static_cast<useconds_t>(interval * 1e6));
+    }
+}
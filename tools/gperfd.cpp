@@ -0,0 +1,515 @@
+// gperfd：构建级trace收集守护进程
+// 插件以-fplugin-arg-gperf-collector=SOCKET连接，把trace流式发送过来（内容与trace文件相同），
+// 连接关闭时由工作线程解析该翻译单元的trace（poll循环只接收数据，解析大的trace不阻塞其他连接）：
+// 事件追加到合并的trace（每个翻译单元一个进程轨道），
+// 并在内存中汇总整个构建的头文件、pass和函数统计；
+// 收到SIGINT/SIGTERM时结束合并的trace，写入汇总报告（buildReport键）并打印摘要后退出
+//
+// 用法：gperfd <socket> [-o build_trace.json] [--top N]
+//   -o FILE    合并的trace文件（默认build_trace.json）
+//   --top N    报告中列出的头文件和函数数量（默认100，pass全部列出）
+
+#include "trace_reader.h"  // trace解析和JSON序列化
+
+#include <algorithm>       // 排序
+#include <cerrno>          // errno
+#include <chrono>          // 时间原点
+#include <cmath>           // round
+#include <condition_variable> // 唤醒解析线程
+#include <csignal>         // 停止信号
+#include <cstdio>          // 输出
+#include <cstdlib>         // atoi
+#include <cstring>         // strerror
+#include <deque>           // 待解析的trace
+#include <map>             // 按名称汇总
+#include <mutex>           // 保护待解析的trace
+#include <string>          // 字符串
+#include <thread>          // 解析线程
+#include <vector>          // 向量容器
+
+#include <poll.h>          // ppoll
+#include <sys/socket.h>    // socket、bind、listen、accept4
+#include <sys/un.h>        // sockaddr_un
+#include <unistd.h>        // read、close、unlink
+
+using namespace GccTrace;
+
+namespace
+{
+    // 每次从连接读取的字节数
+    constexpr size_t READ_CHUNK_SIZE = 1 << 16;
+
+    // 一项统计：出现次数、总时间、最长的一次及其所在的翻译单元
+    struct Stat
+    {
+        int64_t count = 0;
+        double total_us = 0;
+        double max_us = 0;
+        std::string max_tu;
+
+        void add(double us, const std::string& tu)
+        {
+            count++;
+            total_us += us;
+            if (us > max_us)
+            {
+                max_us = us;
+                max_tu = tu;
+            }
+        }
+    };
+
+    // 一个已收到的翻译单元
+    struct TuRecord
+    {
+        std::string name;          // 主源文件（或lto1的进程名称）
+        double start_us;           // 相对构建时间原点的开始时间
+        double duration_us;        // TU事件的时长
+        size_t events;             // 事件数量
+        bool truncated;            // 连接在trace结束前断开（编译被终止）
+        std::string incomplete;    // 插件记录的异常结束原因（incomplete报告）
+    };
+
+    // 追加时间（微秒），保留到纳秒，去掉相减产生的浮点误差
+    void append_number(std::string& out, double value)
+    {
+        JsonValue number;
+        number.type = JsonValue::NUMBER;
+        number.number = std::round(value * 1000) / 1000;
+        append_json(out, number);
+    }
+
+    // 构建级汇总：合并的trace边收边写，统计保存在内存中
+    class Collector
+    {
+    public:
+        Collector(std::FILE* out, double origin_us) : out(out), origin_us(origin_us)
+        {
+            fputs("{\"displayTimeUnit\": \"ns\", \"beginningOfTime\": ", out);
+            std::string origin;
+            append_number(origin, origin_us);
+            fputs(origin.data(), out);
+            fputs(", \"traceEvents\": [", out);
+        }
+
+        // 解析一个翻译单元的trace，追加到合并的trace并累计统计
+        void add_trace(std::string_view content)
+        {
+            Trace trace;
+            trace.path = "connection #" + std::to_string(tus.size() + 1);
+            std::string error;
+            if (content.empty())
+            {
+                return;  // 连接后没有发送任何内容（插件初始化失败）
+            }
+            if (!parse_trace(content, trace, error))
+            {
+                fprintf(stderr, "gperfd: %s\n", error.data());
+                return;
+            }
+
+            TuRecord tu;
+            tu.name = trace_unit_name(trace);
+            if (tu.name.empty())
+            {
+                tu.name = "TU #" + std::to_string(tus.size() + 1);
+            }
+            const JsonValue* beginning = trace.root.get("beginningOfTime");
+            double offset_us = (beginning ? beginning->number_or(origin_us) : origin_us) - origin_us;
+            tu.start_us = offset_us;
+            tu.duration_us = 0;
+            tu.events = trace.spans.size();
+            tu.truncated = trace.truncated;
+            const JsonValue* incomplete = trace.report("incomplete");
+            tu.incomplete = incomplete && incomplete->get("reason") ? incomplete->get("reason")->string_or_empty() : "";
+
+            int pid = static_cast<int>(tus.size() + 1);
+            std::string text;
+            begin_record(text);
+            text += "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " + std::to_string(pid) + ", \"args\": {\"name\": ";
+            append_json_string(text, tu.name);
+            text += "}}";
+
+            for (const TraceSpan& span : trace.spans)
+            {
+                double duration = span.duration_us();
+                if (span.category == "TU")
+                {
+                    tu.duration_us = std::max(tu.duration_us, duration);
+                }
+                else if (span.category == "PREPROCESS" && span.name != tu.name)
+                {
+                    headers[span.name].add(duration, tu.name);
+                }
+                else if (span.category == "FUNCTION")
+                {
+                    functions[span.name].add(duration, tu.name);
+                }
+                else if (is_pass_category(span.category))
+                {
+                    passes[span.name].add(duration, tu.name);
+                }
+
+                // 合并的trace使用完整事件（"X"），不需要UID配对
+                begin_record(text);
+                text += "{\"name\": ";
+                append_json_string(text, span.name);
+                text += ", \"cat\": ";
+                append_json_string(text, span.category);
+                text += ", \"ph\": \"X\", \"ts\": ";
+                append_number(text, offset_us + span.start_us);
+                text += ", \"dur\": ";
+                append_number(text, duration);
+                text += ", \"pid\": " + std::to_string(pid) + ", \"tid\": " + std::to_string(span.tid);
+                if (span.args && span.args->type == JsonValue::OBJECT)
+                {
+                    bool first = true;
+                    for (const auto& [key, value] : span.args->object)
+                    {
+                        if (key == "UID")
+                        {
+                            continue;
+                        }
+                        text += first ? ", \"args\": {" : ", ";
+                        append_json_string(text, key);
+                        text += ": ";
+                        append_json(text, value);
+                        first = false;
+                    }
+                    text += first ? "" : "}";
+                }
+                text += "}";
+            }
+            fwrite(text.data(), 1, text.size(), out);
+            fflush(out);
+
+            tus.push_back(std::move(tu));
+        }
+
+        // 结束合并的trace：写入buildReport并打印摘要
+        void finish(size_t top)
+        {
+            std::string text = "], \"buildReport\": {\"tus\": [";
+            for (size_t i = 0; i < tus.size(); i++)
+            {
+                const TuRecord& tu = tus[i];
+                text += i ? ", " : "";
+                text += "{\"name\": ";
+                append_json_string(text, tu.name);
+                text += ", \"start_us\": ";
+                append_number(text, tu.start_us);
+                text += ", \"duration_us\": ";
+                append_number(text, tu.duration_us);
+                text += ", \"events\": " + std::to_string(tu.events);
+                text += ", \"truncated\": ";
+                text += tu.truncated ? "true" : "false";
+                if (!tu.incomplete.empty())
+                {
+                    text += ", \"incomplete\": ";
+                    append_json_string(text, tu.incomplete);
+                }
+                text += "}";
+            }
+            text += "], \"headers\": ";
+            append_stats(text, headers, top);
+            text += ", \"passes\": ";
+            append_stats(text, passes, passes.size());
+            text += ", \"functions\": ";
+            append_stats(text, functions, top);
+            text += "}}\n";
+            fwrite(text.data(), 1, text.size(), out);
+
+            size_t truncated = std::count_if(tus.begin(), tus.end(), [](const TuRecord& tu) { return tu.truncated; });
+            size_t incomplete = std::count_if(tus.begin(), tus.end(), [](const TuRecord& tu) { return !tu.incomplete.empty(); });
+            printf("gperfd: %zu translation units (%zu truncated, %zu incomplete)\n", tus.size(), truncated, incomplete);
+            print_top("headers", headers);
+            print_top("passes", passes);
+            print_top("functions", functions);
+        }
+
+    private:
+        // 按总时间从大到小排序
+        static std::vector<std::pair<const std::string*, const Stat*>> sorted(const std::map<std::string, Stat>& stats)
+        {
+            std::vector<std::pair<const std::string*, const Stat*>> entries;
+            for (const auto& [name, stat] : stats)
+            {
+                entries.emplace_back(&name, &stat);
+            }
+            std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b)
+            {
+                return a.second->total_us > b.second->total_us;
+            });
+            return entries;
+        }
+
+        static void append_stats(std::string& text, const std::map<std::string, Stat>& stats, size_t limit)
+        {
+            auto entries = sorted(stats);
+            text += "[";
+            for (size_t i = 0; i < entries.size() && i < limit; i++)
+            {
+                const auto& [name, stat] = entries[i];
+                text += i ? ", " : "";
+                text += "{\"name\": ";
+                append_json_string(text, *name);
+                text += ", \"count\": " + std::to_string(stat->count);
+                text += ", \"total_us\": ";
+                append_number(text, stat->total_us);
+                text += ", \"max_us\": ";
+                append_number(text, stat->max_us);
+                text += ", \"max_tu\": ";
+                append_json_string(text, stat->max_tu);
+                text += "}";
+            }
+            text += "]";
+        }
+
+        static void print_top(const char* title, const std::map<std::string, Stat>& stats)
+        {
+            constexpr size_t PRINTED = 10;
+            auto entries = sorted(stats);
+            printf("\ntop %s by total time:\n", title);
+            for (size_t i = 0; i < entries.size() && i < PRINTED; i++)
+            {
+                const auto& [name, stat] = entries[i];
+                printf("  %12.1f ms  %6lld x  %s\n", stat->total_us / 1000, (long long)stat->count, name->data());
+            }
+        }
+
+        void begin_record(std::string& text)
+        {
+            if (records++)
+            {
+                text += ",\n";
+            }
+        }
+
+        std::FILE* out;                          // 合并的trace文件
+        double origin_us;                        // 构建时间原点（gperfd启动时间，微秒）
+        size_t records = 0;                      // 已写入的事件记录数
+        std::vector<TuRecord> tus;               // 已收到的翻译单元
+        std::map<std::string, Stat> headers;     // 头文件 -> 预处理（包含嵌套包含）时间
+        std::map<std::string, Stat> passes;      // pass名称 -> 执行时间
+        std::map<std::string, Stat> functions;   // 函数签名 -> 解析时间（同一函数在多个TU中解析时累加）
+    };
+
+    volatile sig_atomic_t stopping = 0;
+
+    void on_stop(int)
+    {
+        stopping = 1;
+    }
+
+    // 创建并监听Unix套接字（删除上次遗留的套接字文件）
+    // 解析队列：已接收完的trace交给工作线程解析并汇总
+    // poll循环不解析trace：解析一个大的trace期间其他连接无人读取，编译进程写满套接字缓冲区后会等待
+    class ParseQueue
+    {
+    public:
+        explicit ParseQueue(Collector& collector) : collector(collector), worker([this] { run(); })
+        {
+        }
+
+        // 加入一个已接收完的trace
+        void push(std::string content)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(std::move(content));
+            }
+            ready.notify_one();
+        }
+
+        // 解析完所有已加入的trace后结束工作线程
+        void finish()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+            }
+            ready.notify_one();
+            worker.join();
+        }
+
+    private:
+        void run()
+        {
+            while (true)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return done || !pending.empty(); });
+                if (pending.empty())
+                {
+                    return;
+                }
+                std::string content = std::move(pending.front());
+                pending.pop_front();
+                lock.unlock();
+                collector.add_trace(content);
+            }
+        }
+
+        Collector& collector;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::string> pending;  // 等待解析的trace
+        bool done = false;                // 不再加入新的trace
+        std::thread worker;               // 解析线程（最后构造，其他成员已初始化）
+    };
+
+    int listen_socket(const char* path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(address.sun_path))
+        {
+            fprintf(stderr, "gperfd: socket path is too long: %s\n", path);
+            return -1;
+        }
+        strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        unlink(path);
+        if (fd == -1 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+            listen(fd, SOMAXCONN) == -1)
+        {
+            fprintf(stderr, "gperfd: couldn't listen on %s: %s\n", path, strerror(errno));
+            if (fd != -1)
+            {
+                close(fd);
+            }
+            return -1;
+        }
+        return fd;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: gperfd <socket> [-o build_trace.json] [--top N]\n");
+        return 2;
+    }
+
+    const char* socket_path = argv[1];
+    const char* output_path = "build_trace.json";
+    size_t top = 100;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (option == "--top" && i + 1 < argc)
+        {
+            top = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else
+        {
+            fprintf(stderr, "gperfd: unknown option %s\n", option.data());
+            return 2;
+        }
+    }
+
+    // 停止信号只在ppoll等待时处理，避免打断正在处理的trace
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stop_signals, nullptr);
+    struct sigaction action = {};
+    action.sa_handler = on_stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    std::FILE* out = fopen(output_path, "w");
+    if (!out)
+    {
+        fprintf(stderr, "gperfd: couldn't open %s for writing\n", output_path);
+        return 1;
+    }
+    int listen_fd = listen_socket(socket_path);
+    if (listen_fd == -1)
+    {
+        fclose(out);
+        return 1;
+    }
+
+    // 时间原点：与插件的beginningOfTime相同的时钟（Unix纪元起的微秒）
+    double origin_us = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    Collector collector(out, origin_us);
+    ParseQueue queue(collector);  // 解析线程继承阻塞的停止信号，信号只在ppoll中处理
+    fprintf(stderr, "gperfd: listening on %s, writing %s\n", socket_path, output_path);
+
+    // fds[0]为监听套接字，其余为插件连接；buffers[i]为fds[i]已收到的内容
+    std::vector<pollfd> fds{{listen_fd, POLLIN, 0}};
+    std::vector<std::string> buffers(1);
+    sigset_t wait_mask;
+    sigemptyset(&wait_mask);
+    std::vector<char> chunk(READ_CHUNK_SIZE);
+    while (!stopping)
+    {
+        if (ppoll(fds.data(), fds.size(), nullptr, &wait_mask) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "gperfd: poll failed: %s\n", strerror(errno));
+            break;
+        }
+
+        // 从后往前处理，关闭的连接可以直接移除
+        for (size_t i = fds.size() - 1; i > 0; i--)
+        {
+            if (!fds[i].revents)
+            {
+                continue;
+            }
+            ssize_t n = read(fds[i].fd, chunk.data(), chunk.size());
+            if (n > 0)
+            {
+                buffers[i].append(chunk.data(), static_cast<size_t>(n));
+                continue;
+            }
+            if (n == -1 && errno == EINTR)
+            {
+                continue;
+            }
+
+            // 连接关闭（插件关闭trace或编译进程退出）：该翻译单元的trace已完整
+            queue.push(std::move(buffers[i]));
+            close(fds[i].fd);
+            fds.erase(fds.begin() + i);
+            buffers.erase(buffers.begin() + i);
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd != -1)
+            {
+                fds.push_back({fd, POLLIN, 0});
+                buffers.emplace_back();
+            }
+        }
+    }
+
+    // 停止时仍在编译的翻译单元：按被截断的trace汇总已收到的部分
+    for (size_t i = 1; i < fds.size(); i++)
+    {
+        queue.push(std::move(buffers[i]));
+        close(fds[i].fd);
+    }
+    queue.finish();
+    close(listen_fd);
+    unlink(socket_path);
+
+    collector.finish(top);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,768 @@
+// GCC性能追踪插件的trace读取模块
+// 最小JSON解析器和Chrome Tracing事件配对，不依赖GCC
+
+#include "trace_reader.h"    // 包含读取接口声明，提供实现
+
+#include <algorithm>         // 排序
+#include <charconv>          // from_chars（数字解析）
+#include <cstdio>            // 文件读取
+#include <filesystem>        // 遍历trace目录
+#include <map>               // B/E记录配对
+
+#ifdef GPERF_HAVE_ZLIB
+#include <zlib.h>            // 读取gzip压缩的trace（也透明读取未压缩文件）
+#endif
+#ifdef GPERF_HAVE_ZSTD
+#include <zstd.h>            // 读取zstd压缩的trace
+#endif
+
+namespace GccTrace
+{
+    namespace
+    {
+        // 递归下降JSON解析器
+        class JsonParser
+        {
+        public:
+            explicit JsonParser(std::string_view text) : text(text) {}
+
+            bool parse(JsonValue& value, std::string& error)
+            {
+                skip_whitespace();
+                if (!parse_value(value, 0))
+                {
+                    error = message + " at byte " + std::to_string(pos);
+                    return false;
+                }
+                skip_whitespace();
+                if (pos != text.size())
+                {
+                    error = "trailing characters at byte " + std::to_string(pos);
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            // 嵌套深度上限，避免恶意或损坏的输入耗尽栈
+            static constexpr int MAX_DEPTH = 512;
+
+            bool fail(const char* what)
+            {
+                message = what;
+                return false;
+            }
+
+            void skip_whitespace()
+            {
+                while (pos < text.size() &&
+                    (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t'))
+                {
+                    pos++;
+                }
+            }
+
+            bool consume(std::string_view literal)
+            {
+                if (text.substr(pos, literal.size()) != literal)
+                {
+                    return false;
+                }
+                pos += literal.size();
+                return true;
+            }
+
+            bool parse_value(JsonValue& value, int depth)
+            {
+                if (depth > MAX_DEPTH)
+                {
+                    return fail("nesting too deep");
+                }
+                if (pos >= text.size())
+                {
+                    return fail("unexpected end of input");
+                }
+
+                switch (text[pos])
+                {
+                    case '{':
+                        return parse_object(value, depth);
+                    case '[':
+                        return parse_array(value, depth);
+                    case '"':
+                        value.type = JsonValue::STRING;
+                        return parse_string(value.string);
+                    case 't':
+                        value.type = JsonValue::BOOLEAN;
+                        value.boolean = true;
+                        return consume("true") || fail("invalid literal");
+                    case 'f':
+                        value.type = JsonValue::BOOLEAN;
+                        value.boolean = false;
+                        return consume("false") || fail("invalid literal");
+                    case 'n':
+                        value.type = JsonValue::NUL;
+                        return consume("null") || fail("invalid literal");
+                    default:
+                        return parse_number(value);
+                }
+            }
+
+            bool parse_object(JsonValue& value, int depth)
+            {
+                value.type = JsonValue::OBJECT;
+                pos++;  // '{'
+                skip_whitespace();
+                if (pos < text.size() && text[pos] == '}')
+                {
+                    pos++;
+                    return true;
+                }
+
+                while (true)
+                {
+                    skip_whitespace();
+                    std::string key;
+                    if (pos >= text.size() || text[pos] != '"' || !parse_string(key))
+                    {
+                        return message.empty() ? fail("expected object key") : false;
+                    }
+                    skip_whitespace();
+                    if (pos >= text.size() || text[pos] != ':')
+                    {
+                        return fail("expected ':'");
+                    }
+                    pos++;
+                    skip_whitespace();
+
+                    value.object.emplace_back(std::move(key), JsonValue{});
+                    if (!parse_value(value.object.back().second, depth + 1))
+                    {
+                        return false;
+                    }
+
+                    skip_whitespace();
+                    if (pos < text.size() && text[pos] == ',')
+                    {
+                        pos++;
+                        continue;
+                    }
+                    if (pos < text.size() && text[pos] == '}')
+                    {
+                        pos++;
+                        return true;
+                    }
+                    return fail("expected ',' or '}'");
+                }
+            }
+
+            bool parse_array(JsonValue& value, int depth)
+            {
+                value.type = JsonValue::ARRAY;
+                pos++;  // '['
+                skip_whitespace();
+                if (pos < text.size() && text[pos] == ']')
+                {
+                    pos++;
+                    return true;
+                }
+
+                while (true)
+                {
+                    skip_whitespace();
+                    value.array.emplace_back();
+                    if (!parse_value(value.array.back(), depth + 1))
+                    {
+                        return false;
+                    }
+
+                    skip_whitespace();
+                    if (pos < text.size() && text[pos] == ',')
+                    {
+                        pos++;
+                        continue;
+                    }
+                    if (pos < text.size() && text[pos] == ']')
+                    {
+                        pos++;
+                        return true;
+                    }
+                    return fail("expected ',' or ']'");
+                }
+            }
+
+            // 追加UTF-8编码的码点
+            static void append_utf8(std::string& out, uint32_t cp)
+            {
+                if (cp < 0x80)
+                {
+                    out += char(cp);
+                }
+                else if (cp < 0x800)
+                {
+                    out += char(0xc0 | (cp >> 6));
+                    out += char(0x80 | (cp & 0x3f));
+                }
+                else if (cp < 0x10000)
+                {
+                    out += char(0xe0 | (cp >> 12));
+                    out += char(0x80 | ((cp >> 6) & 0x3f));
+                    out += char(0x80 | (cp & 0x3f));
+                }
+                else
+                {
+                    out += char(0xf0 | (cp >> 18));
+                    out += char(0x80 | ((cp >> 12) & 0x3f));
+                    out += char(0x80 | ((cp >> 6) & 0x3f));
+                    out += char(0x80 | (cp & 0x3f));
+                }
+            }
+
+            bool parse_hex4(uint32_t& cp)
+            {
+                if (pos + 4 > text.size())
+                {
+                    return fail("truncated \\u escape");
+                }
+                auto result = std::from_chars(text.data() + pos, text.data() + pos + 4, cp, 16);
+                if (result.ptr != text.data() + pos + 4)
+                {
+                    return fail("invalid \\u escape");
+                }
+                pos += 4;
+                return true;
+            }
+
+            bool parse_string(std::string& out)
+            {
+                pos++;  // '"'
+                while (pos < text.size())
+                {
+                    // 批量追加无需转义的部分
+                    size_t end = pos;
+                    while (end < text.size() && text[end] != '"' && text[end] != '\\')
+                    {
+                        end++;
+                    }
+                    out.append(text.data() + pos, end - pos);
+                    pos = end;
+                    if (pos >= text.size())
+                    {
+                        break;
+                    }
+                    if (text[pos] == '"')
+                    {
+                        pos++;
+                        return true;
+                    }
+
+                    // 转义字符
+                    if (++pos >= text.size())
+                    {
+                        break;
+                    }
+                    char c = text[pos++];
+                    switch (c)
+                    {
+                        case '"':  out += '"'; break;
+                        case '\\': out += '\\'; break;
+                        case '/':  out += '/'; break;
+                        case 'b':  out += '\b'; break;
+                        case 'f':  out += '\f'; break;
+                        case 'n':  out += '\n'; break;
+                        case 'r':  out += '\r'; break;
+                        case 't':  out += '\t'; break;
+                        case 'u':
+                        {
+                            uint32_t cp;
+                            if (!parse_hex4(cp))
+                            {
+                                return false;
+                            }
+                            // UTF-16代理对
+                            if (cp >= 0xd800 && cp < 0xdc00 && consume("\\u"))
+                            {
+                                uint32_t low;
+                                if (!parse_hex4(low))
+                                {
+                                    return false;
+                                }
+                                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                            }
+                            append_utf8(out, cp);
+                            break;
+                        }
+                        default:
+                            return fail("invalid escape");
+                    }
+                }
+                return fail("unterminated string");
+            }
+
+            bool parse_number(JsonValue& value)
+            {
+                size_t end = pos;
+                while (end < text.size() && (isdigit((unsigned char)text[end]) || text[end] == '-' ||
+                    text[end] == '+' || text[end] == '.' || text[end] == 'e' || text[end] == 'E'))
+                {
+                    end++;
+                }
+                if (end == pos)
+                {
+                    return fail("unexpected character");
+                }
+
+                value.type = JsonValue::NUMBER;
+                auto result = std::from_chars(text.data() + pos, text.data() + end, value.number);
+                if (result.ptr != text.data() + end)
+                {
+                    return fail("invalid number");
+                }
+                pos = end;
+                return true;
+            }
+
+            std::string_view text;   // 输入文本
+            size_t pos = 0;          // 当前位置
+            std::string message;     // 错误描述
+        };
+
+#ifdef GPERF_HAVE_ZLIB
+        // 读取gzip压缩的文件
+        bool read_gzip_file(const std::string& path, std::string& content, std::string& error)
+        {
+            gzFile file = gzopen(path.data(), "rb");
+            if (!file)
+            {
+                error = "couldn't open " + path;
+                return false;
+            }
+
+            char chunk[1 << 16];
+            int n;
+            while ((n = gzread(file, chunk, sizeof(chunk))) > 0)
+            {
+                content.append(chunk, n);
+            }
+
+            // 被截断的压缩流（没有gzip结尾）：保留已解压的数据，由JSON补全处理
+            int code = Z_OK;
+            if (n < 0)
+            {
+                gzerror(file, &code);
+            }
+            bool ok = n == 0 || code == Z_BUF_ERROR;
+            gzclose(file);
+            if (!ok)
+            {
+                error = "couldn't decompress " + path;
+            }
+            return ok;
+        }
+#endif
+
+#ifdef GPERF_HAVE_ZSTD
+        // 解压zstd数据（可能由多个帧组成）
+        bool decompress_zstd(const std::string& compressed, std::string& content)
+        {
+            ZSTD_DCtx* context = ZSTD_createDCtx();
+            std::string chunk(ZSTD_DStreamOutSize(), '\0');
+            ZSTD_inBuffer in{compressed.data(), compressed.size(), 0};
+            bool ok = context != nullptr;
+            while (ok && in.pos < in.size)
+            {
+                ZSTD_outBuffer out{chunk.data(), chunk.size(), 0};
+                size_t result = ZSTD_decompressStream(context, &out, &in);
+                ok = !ZSTD_isError(result);
+                content.append(chunk.data(), out.pos);
+            }
+            ZSTD_freeDCtx(context);
+            return ok;
+        }
+#endif
+
+        // 读取整个未压缩文件
+        bool read_plain_file(const std::string& path, std::string& content, std::string& error)
+        {
+            FILE* file = fopen(path.data(), "rb");
+            if (!file)
+            {
+                error = "couldn't open " + path;
+                return false;
+            }
+
+            char chunk[1 << 16];
+            size_t n;
+            while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+            {
+                content.append(chunk, n);
+            }
+            bool ok = !ferror(file);
+            fclose(file);
+            if (!ok)
+            {
+                error = "couldn't read " + path;
+            }
+            return ok;
+        }
+
+        // 读取整个文件（按扩展名解压.gz和.zst）
+        bool read_file(const std::string& path, std::string& content, std::string& error)
+        {
+#ifdef GPERF_HAVE_ZLIB
+            if (path.ends_with(".gz"))
+            {
+                return read_gzip_file(path, content, error);
+            }
+#endif
+#ifdef GPERF_HAVE_ZSTD
+            if (path.ends_with(".zst"))
+            {
+                std::string compressed;
+                if (!read_plain_file(path, compressed, error))
+                {
+                    return false;
+                }
+                if (!decompress_zstd(compressed, content))
+                {
+                    error = "couldn't decompress " + path;
+                    return false;
+                }
+                return true;
+            }
+#endif
+            return read_plain_file(path, content, error);
+        }
+
+        // 补全被截断的trace：截断在事件记录之间（阶段边界刷新的位置）时直接结束数组和根对象，
+        // 截断在记录中间时退回到最后一个记录分隔符
+        bool parse_truncated_trace(std::string_view content, JsonValue& root)
+        {
+            static constexpr std::string_view EVENTS_KEY = "\"traceEvents\": [";
+            size_t events = content.find(EVENTS_KEY);
+            if (events == std::string_view::npos)
+            {
+                return false;
+            }
+
+            std::string error;
+            std::string_view complete = content;
+            while (!complete.empty() && (complete.back() == '\n' || complete.back() == ' ' || complete.back() == ','))
+            {
+                complete.remove_suffix(1);
+            }
+            if (parse_json(std::string(complete) + "]}", root, error))
+            {
+                return true;
+            }
+
+            size_t separator = content.rfind(",\n");
+            if (separator == std::string_view::npos || separator < events)
+            {
+                separator = events + EVENTS_KEY.size();  // 没有完整的事件记录
+            }
+            root = JsonValue{};
+            return parse_json(std::string(content.substr(0, separator)) + "]}", root, error);
+        }
+    }
+
+    const JsonValue* JsonValue::get(std::string_view key) const
+    {
+        if (type != OBJECT)
+        {
+            return nullptr;
+        }
+        for (const auto& [name, value] : object)
+        {
+            if (name == key)
+            {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    const std::string& JsonValue::string_or_empty() const
+    {
+        static const std::string empty;
+        return type == STRING ? string : empty;
+    }
+
+    std::string TraceSpan::arg(std::string_view key) const
+    {
+        const JsonValue* value = args ? args->get(key) : nullptr;
+        if (!value)
+        {
+            return {};
+        }
+        if (value->type == JsonValue::NUMBER)
+        {
+            char digits[64];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value->number);
+            return std::string(digits, result.ptr);
+        }
+        return value->string_or_empty();
+    }
+
+    bool parse_json(std::string_view text, JsonValue& value, std::string& error)
+    {
+        JsonParser parser(text);
+        return parser.parse(value, error);
+    }
+
+    void append_json_string(std::string& out, std::string_view text)
+    {
+        static const char* hex = "0123456789abcdef";
+
+        out += '"';
+        for (unsigned char c : text)
+        {
+            switch (c)
+            {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20)
+                    {
+                        out += "\\u00";
+                        out += hex[c >> 4];
+                        out += hex[c & 0xf];
+                    }
+                    else
+                    {
+                        out += char(c);
+                    }
+                    break;
+            }
+        }
+        out += '"';
+    }
+
+    void append_json(std::string& out, const JsonValue& value)
+    {
+        switch (value.type)
+        {
+            case JsonValue::NUL:
+                out += "null";
+                break;
+            case JsonValue::BOOLEAN:
+                out += value.boolean ? "true" : "false";
+                break;
+            case JsonValue::NUMBER:
+            {
+                char digits[64];
+                auto result = std::to_chars(digits, digits + sizeof(digits), value.number);
+                out.append(digits, result.ptr);
+                break;
+            }
+            case JsonValue::STRING:
+                append_json_string(out, value.string);
+                break;
+            case JsonValue::ARRAY:
+                out += '[';
+                for (size_t i = 0; i < value.array.size(); i++)
+                {
+                    out += i ? ", " : "";
+                    append_json(out, value.array[i]);
+                }
+                out += ']';
+                break;
+            case JsonValue::OBJECT:
+                out += '{';
+                for (size_t i = 0; i < value.object.size(); i++)
+                {
+                    out += i ? ", " : "";
+                    append_json_string(out, value.object[i].first);
+                    out += ": ";
+                    append_json(out, value.object[i].second);
+                }
+                out += '}';
+                break;
+        }
+    }
+
+    bool load_trace(const std::string& path, Trace& trace, std::string& error)
+    {
+        std::string content;
+        if (!read_file(path, content, error))
+        {
+            return false;
+        }
+
+        trace.path = path;
+        trace.file_bytes = content.size();
+        return parse_trace(content, trace, error);
+    }
+
+    bool parse_trace(std::string_view content, Trace& trace, std::string& error)
+    {
+        if (!parse_json(content, trace.root, error))
+        {
+            trace.root = JsonValue{};
+            if (!parse_truncated_trace(content, trace.root))
+            {
+                error = trace.path + ": " + error;
+                return false;
+            }
+            trace.truncated = true;
+        }
+
+        const JsonValue* events = trace.root.get("traceEvents");
+        if (!events || events->type != JsonValue::ARRAY)
+        {
+            error = trace.path + ": missing traceEvents array";
+            return false;
+        }
+
+        // B/E记录按(pid, UID)配对
+        std::map<std::pair<int64_t, int64_t>, size_t> open_spans;
+        for (const JsonValue& record : events->array)
+        {
+            const std::string& phase = record.get("ph") ? record.get("ph")->string_or_empty() : std::string();
+            if (phase != "B" && phase != "E" && phase != "X")
+            {
+                continue;  // 元数据、计数器等记录
+            }
+
+            int64_t pid = record.get("pid") ? (int64_t)record.get("pid")->number_or(0) : 0;
+            double ts = record.get("ts") ? record.get("ts")->number_or(0) : 0;
+            const JsonValue* args = record.get("args");
+            const JsonValue* uid_value = args ? args->get("UID") : nullptr;
+
+            if (phase == "E")
+            {
+                auto it = uid_value ? open_spans.find({pid, (int64_t)uid_value->number}) : open_spans.end();
+                if (it == open_spans.end())
+                {
+                    trace.unmatched_records++;
+                    continue;
+                }
+                trace.spans[it->second].end_us = ts;
+                open_spans.erase(it);
+                continue;
+            }
+
+            TraceSpan span;
+            span.name = record.get("name") ? record.get("name")->string_or_empty() : std::string();
+            span.category = record.get("cat") ? record.get("cat")->string_or_empty() : std::string();
+            span.pid = pid;
+            span.tid = record.get("tid") ? (int64_t)record.get("tid")->number_or(0) : 0;
+            span.start_us = ts;
+            span.end_us = ts;
+            span.args = args;
+
+            if (phase == "X")
+            {
+                span.end_us = ts + (record.get("dur") ? record.get("dur")->number_or(0) : 0);
+            }
+            else if (uid_value)
+            {
+                open_spans[{pid, (int64_t)uid_value->number}] = trace.spans.size();
+            }
+            else
+            {
+                trace.unmatched_records++;
+                continue;
+            }
+            trace.spans.push_back(std::move(span));
+        }
+        trace.unmatched_records += open_spans.size();
+
+        // 移除未配对的开始记录（结束时间未设置）
+        for (auto it = open_spans.rbegin(); it != open_spans.rend(); ++it)
+        {
+            trace.spans[it->second].end_us = -1;
+        }
+        trace.spans.erase(std::remove_if(trace.spans.begin(), trace.spans.end(),
+            [](const TraceSpan& span) { return span.end_us < 0; }), trace.spans.end());
+
+        // 按开始时间排序，开始时间相同时较长的事件在前
+        std::stable_sort(trace.spans.begin(), trace.spans.end(), [](const TraceSpan& a, const TraceSpan& b)
+        {
+            return a.start_us != b.start_us ? a.start_us < b.start_us : a.end_us > b.end_us;
+        });
+        return true;
+    }
+
+    std::vector<std::string> find_trace_files(const std::string& path)
+    {
+        namespace fs = std::filesystem;
+        std::error_code error;
+        if (!fs::is_directory(path, error))
+        {
+            return {path};
+        }
+
+        std::vector<std::string> files;
+        for (fs::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+        {
+            std::string name = it->path().filename().string();
+            if (name.ends_with(".summary.json"))
+            {
+                continue;  // 摘要侧车文件
+            }
+            for (const char* suffix : {".json", ".json.gz", ".json.zst"})
+            {
+                std::string_view extension(suffix);
+                if (it->is_regular_file(error) && name.size() > extension.size() &&
+                    name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+                {
+                    files.push_back(it->path().string());
+                    break;
+                }
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    std::string trace_unit_name(const Trace& trace)
+    {
+        const JsonValue* events = trace.root.get("traceEvents");
+        for (size_t i = 0; events && i < events->array.size(); i++)
+        {
+            const JsonValue& record = events->array[i];
+            const JsonValue* name = record.get("name");
+            const JsonValue* args = record.get("args");
+            if (name && name->string == "process_name" && args && args->get("name"))
+            {
+                return args->get("name")->string_or_empty();
+            }
+        }
+        for (const TraceSpan& span : trace.spans)
+        {
+            if (span.category == "PREPROCESS")
+            {
+                return span.name;
+            }
+        }
+        return "";
+    }
+
+    bool is_pass_category(std::string_view category)
+    {
+        return category == "GIMPLE_PASS" || category == "RTL_PASS" ||
+            category == "SIMPLE_IPA_PASS" || category == "IPA_PASS";
+    }
+
+    std::vector<int> span_parents(const Trace& trace)
+    {
+        // 事件按开始时间排序（同时开始时较长的在前），每个(pid, tid)维护一个包含栈
+        std::vector<int> parents(trace.spans.size(), -1);
+        std::map<std::pair<int64_t, int64_t>, std::vector<int>> stacks;
+        for (size_t i = 0; i < trace.spans.size(); i++)
+        {
+            const TraceSpan& span = trace.spans[i];
+            auto& stack = stacks[{span.pid, span.tid}];
+            while (!stack.empty() && trace.spans[stack.back()].end_us <= span.start_us)
+            {
+                stack.pop_back();
+            }
+            parents[i] = stack.empty() ? -1 : stack.back();
+            stack.push_back(static_cast<int>(i));
+        }
+        return parents;
+    }
+}
@@ -0,0 +1,179 @@
+// GCC性能追踪插件的trace读取接口头文件
+// 不依赖GCC：供离线分析工具和trace结构测试读取插件生成的Chrome Tracing文件
+
+#pragma once                  // 头文件保护，防止重复包含
+
+#include <cstdint>            // 定长整数类型
+#include <string>             // 字符串
+#include <string_view>        // 字符串视图
+#include <utility>            // pair
+#include <vector>             // 向量容器
+
+namespace GccTrace
+{
+    // ==================== JSON文档 ====================
+
+    /**
+     * @brief 最小JSON文档节点
+     *
+     * 对象保持键的原始顺序（与插件输出顺序一致），按键查找为线性查找，
+     * trace中的对象（事件、参数、报告条目）都只有少量键。
+     */
+    struct JsonValue
+    {
+        enum Type
+        {
+            NUL,        // null
+            BOOLEAN,    // true/false
+            NUMBER,     // 数字（统一为double）
+            STRING,     // 字符串
+            ARRAY,      // 数组
+            OBJECT      // 对象
+        };
+
+        Type type = NUL;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        // 按键查找对象成员，不存在或不是对象时返回nullptr
+        const JsonValue* get(std::string_view key) const;
+
+        // 便捷访问：类型不符时返回默认值
+        double number_or(double fallback) const
+        {
+            return type == NUMBER ? number : fallback;
+        }
+        const std::string& string_or_empty() const;
+    };
+
+    /**
+     * @brief 解析JSON文本
+     *
+     * @param text JSON文本
+     * @param value 解析结果
+     * @param error 失败时的错误描述（包含字节偏移）
+     * @return 成功返回true
+     */
+    bool parse_json(std::string_view text, JsonValue& value, std::string& error);
+
+    /**
+     * @brief 追加JSON字符串（带引号，转义引号、反斜杠和控制字符）
+     */
+    void append_json_string(std::string& out, std::string_view text);
+
+    /**
+     * @brief 把JSON文档节点序列化后追加到out（单行，对象保持键的顺序）
+     */
+    void append_json(std::string& out, const JsonValue& value);
+
+    // ==================== Chrome Tracing读取 ====================
+
+    /**
+     * @brief 一个完整的追踪事件（由B/E记录按UID配对，或X记录）
+     */
+    struct TraceSpan
+    {
+        std::string name;               // 事件名称
+        std::string category;           // 事件类别（cat字段）
+        int64_t pid = 0;                // 进程ID
+        int64_t tid = 0;                // 线程ID
+        double start_us = 0;            // 开始时间（微秒）
+        double end_us = 0;              // 结束时间（微秒）
+        const JsonValue* args = nullptr;// 参数对象（指向Trace::root内部，可能为nullptr）
+
+        double duration_us() const
+        {
+            return end_us - start_us;
+        }
+
+        // 读取字符串参数，不存在时返回空字符串
+        std::string arg(std::string_view key) const;
+    };
+
+    /**
+     * @brief 一个已读取的trace文件
+     */
+    struct Trace
+    {
+        std::string path;               // 文件路径
+        size_t file_bytes = 0;          // 文件大小（字节）
+        JsonValue root;                 // 完整JSON文档（包含附加报告）
+        std::vector<TraceSpan> spans;   // 配对后的事件，按开始时间排序
+        size_t unmatched_records = 0;   // 未能配对的B/E记录数
+        bool truncated = false;         // 文件被截断（编译中途被终止），已在最后一个完整记录处补全
+
+        // 附加报告（根对象的顶层键），不存在时返回nullptr
+        const JsonValue* report(std::string_view key) const
+        {
+            return root.get(key);
+        }
+    };
+
+    /**
+     * @brief 读取trace文件
+     *
+     * 以.gz/.zst结尾的文件先解压（需要构建时启用zlib/libzstd），
+     * 解析JSON，把B/E记录按(pid, UID)配对为TraceSpan，按开始时间排序
+     * （开始时间相同时较长的事件在前，便于按嵌套关系遍历）。
+     * 被截断的trace（编译被SIGKILL终止）在最后一个完整的事件记录处补全后读取，
+     * 并设置Trace::truncated，截断处未结束的事件计入unmatched_records。
+     *
+     * @param path 文件路径
+     * @param trace 读取结果
+     * @param error 失败时的错误描述
+     * @return 成功返回true
+     */
+    bool load_trace(const std::string& path, Trace& trace, std::string& error);
+
+    /**
+     * @brief 从内存中的JSON文本读取trace（如gperfd从套接字收到的trace）
+     *
+     * 与load_trace相同的解析和配对，trace.path只用于错误描述，由调用方设置。
+     *
+     * @param content 未压缩的trace文本
+     * @param trace 读取结果
+     * @param error 失败时的错误描述
+     * @return 成功返回true
+     */
+    bool parse_trace(std::string_view content, Trace& trace, std::string& error);
+
+    // ==================== 分析工具的公共函数 ====================
+
+    /**
+     * @brief 列出trace文件
+     *
+     * 路径是目录时递归查找其中的.json、.json.gz和.json.zst文件（按路径排序），否则返回路径本身。
+     * 插件写在trace旁边的摘要侧车文件（.summary.json）不是trace，不包括在内。
+     *
+     * @param path trace文件或目录（如插件trace-dir参数指定的目录）
+     * @return trace文件路径列表（目录不存在或为空时为空）
+     */
+    std::vector<std::string> find_trace_files(const std::string& path);
+
+    /**
+     * @brief 翻译单元的名称
+     *
+     * lto1的trace为process_name元数据（lto1-wpa/ltrans运行名称），
+     * 否则为最早开始的预处理事件（主源文件）。
+     *
+     * @return 名称；都没有时为空字符串
+     */
+    std::string trace_unit_name(const Trace& trace);
+
+    /**
+     * @brief 是否为优化pass的类别（GIMPLE_PASS、RTL_PASS、SIMPLE_IPA_PASS、IPA_PASS）
+     */
+    bool is_pass_category(std::string_view category);
+
+    /**
+     * @brief 每个事件的父事件
+     *
+     * 父事件是同一进程、线程中包含该事件的最内层事件（插件输出的事件严格嵌套）。
+     *
+     * @return 与trace.spans对应的父事件下标，顶层事件为-1
+     */
+    std::vector<int> span_parents(const Trace& trace);
+}